@@ -0,0 +1,561 @@
+/**
+ * @file udpCapture.c
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief High-rate host-side receiver for the FIFO streamer packets
+ * @details Receives with recvmmsg() straight into a preallocated ring of packet
+ *          slots (no per-packet allocation or copy), takes the arrival time of
+ *          every datagram from the kernel (SO_TIMESTAMPNS) and tracks the
+ *          packet sequence: gaps, duplicates and reordering. Once per second it
+ *          prints packets/s, throughput, loss and interarrival jitter.
+ *
+ *          Both packet layouts of the streamer are understood: the
+ *          self-describing header of sdrPacket.h (recognized by its magic) and
+ *          the legacy layout (a bare 32-bit packet ID, -H legacy). Packets the
+ *          streamer compressed (-C) are decoded back to cs16_qi samples.
+ *
+ *          With -S the capture subscribes itself at the control port of the
+ *          streamer and keeps renewing the lease while it runs; with -g it joins
+ *          a multicast group the streamer sends to.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#define _GNU_SOURCE // recvmmsg
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <poll.h>
+
+#include "../web/cgi-bin/sdrPacket.h"
+#include "../web/cgi-bin/iqCodec.h"
+
+/* Definitions */
+#define DEFAULT_PORT            25344               // Default UDP port of the streamer
+#define DEFAULT_BATCH           64                  // Datagrams per recvmmsg() call
+#define MAX_BATCH               1024                // Upper limit for the batch size
+#define DEFAULT_RING_SLOTS      4096                // Preallocated packet slots
+#define DEFAULT_RCVBUF          (16 * 1024 * 1024)  // Requested socket receive buffer
+#define SLOT_SIZE               9216                // Largest datagram kept (jumbo frame)
+#define LEGACY_SAMPLE_RATE      48000               // Assumed sample rate of legacy packets
+#define SEQ_WINDOW              4096                // Sequence numbers remembered for duplicate detection
+#define DEFAULT_CONTROL_PORT    25345               // Subscriber control port of the streamer
+#define SUBSCRIBE_RENEW_S       3                   // Renew the subscription this often (the lease is longer)
+
+/**
+ * @brief Sequence and timing statistics
+ */
+typedef struct captureStats
+{
+    uint64_t packets;           // datagrams received
+    uint64_t bytes;             // payload bytes received
+    uint64_t samples;           // samples received
+    uint64_t lost;              // sequence numbers never seen (so far)
+    uint64_t duplicates;        // sequence numbers seen twice
+    uint64_t reordered;         // packets that arrived after a later one
+    uint64_t restarts;          // sequence jumped back beyond the window (streamer restarted)
+    uint64_t malformed;         // datagrams with an unexpected size
+    uint64_t legacy;            // packets with the legacy layout
+    uint64_t compressed;        // packets decoded from the compressed layout
+    uint64_t decodedBytes;      // sample bytes they decoded to
+    uint64_t discontinuities;   // packets the streamer flagged as missing samples at the FIFO
+    uint64_t syscalls;          // recvmmsg() calls
+    double jitterUs;            // RFC 3550 interarrival jitter
+    double fifoToWireUsTotal;   // sum of FIFO-to-wire latencies (header timestamps)
+    double fifoToWireUsMax;     // worst FIFO-to-wire latency
+    double wireToHostUsTotal;   // sum of wire-to-host latencies (needs synced clocks)
+    uint64_t latencySamples;    // packets with valid header timestamps
+} captureStats;
+
+/* Global Variables */
+volatile sig_atomic_t terminate = 0;    // Termination flag
+captureStats stats;                     // Totals since the start
+uint32_t highestSeq = 0;                // Highest sequence number seen
+bool haveSeq = false;                   // highestSeq is valid
+uint8_t seen[SEQ_WINDOW / 8];           // Bitmap of the last SEQ_WINDOW sequence numbers
+bool haveTransit = false;               // lastTransitUs is valid
+bool lastLegacy = false;                // layout of the previous packet, transit times of the two do not compare
+double lastTransitUs = 0;               // Arrival minus send time of the previous packet
+
+/* Prototype */
+void usage(const char *executableName);
+void signalHandler(int sig);
+void track_sequence(uint32_t seq);
+void track_timing(const uint8_t *data, size_t len, const struct timespec *arrival);
+void print_stats(const captureStats *now, const captureStats *last, double seconds);
+void send_control(int fd, const struct sockaddr_in *streamer, const char *verb, int port);
+
+int main(int argc, char const *argv[])
+{
+    int port = DEFAULT_PORT;
+    unsigned int batch = DEFAULT_BATCH;
+    unsigned int ring_slots = DEFAULT_RING_SLOTS;
+    int rcvbuf = DEFAULT_RCVBUF;
+    int duration = 0;
+    const char *out_path = NULL;
+    const char *subscribe_to = NULL;
+    const char *group = NULL;
+    int opt = 0;
+
+    // Parse command line arguments
+    while ((opt = getopt(argc, (char * const *)argv, "p:b:n:r:t:o:S:g:h")) != -1) {
+        switch (opt) {
+            case 'p':
+                port = atoi(optarg); break;
+            case 'b':
+                batch = (unsigned int)atoi(optarg); break;
+            case 'n':
+                ring_slots = (unsigned int)atoi(optarg); break;
+            case 'r':
+                rcvbuf = atoi(optarg); break;
+            case 't':
+                duration = atoi(optarg); break;
+            case 'o':
+                out_path = optarg; break;
+            case 'S':
+                subscribe_to = optarg; break;
+            case 'g':
+                group = optarg; break;
+            case 'h':
+                usage(argv[0]); return 0;
+            default:
+                usage(argv[0]); return -1;
+        }
+    }
+    if (port <= 0 || port > 65535 || batch == 0 || batch > MAX_BATCH || ring_slots < batch || rcvbuf <= 0) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sockfd < 0) {
+        perror("Error creating socket");
+        return -1;
+    }
+
+    // a large receive buffer rides out scheduling hiccups of this process;
+    // SO_RCVBUFFORCE ignores net.core.rmem_max when running as root
+    if (setsockopt(sockfd, SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf, sizeof(rcvbuf)) != 0) {
+        setsockopt(sockfd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    }
+    int actual = 0;
+    socklen_t optlen = sizeof(actual);
+    getsockopt(sockfd, SOL_SOCKET, SO_RCVBUF, &actual, &optlen);
+    int on = 1;
+    setsockopt(sockfd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)); // kernel arrival time per datagram
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(sockfd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        perror("Bind failed");
+        close(sockfd);
+        return -1;
+    }
+
+    if (group != NULL) {
+        // receive what the streamer sends to the multicast group on this port
+        struct ip_mreq mreq;
+        memset(&mreq, 0, sizeof(mreq));
+        mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+        if (inet_pton(AF_INET, group, &mreq.imr_multiaddr) <= 0
+            || setsockopt(sockfd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) != 0) {
+            perror("Failed to join the multicast group");
+            close(sockfd);
+            return -1;
+        }
+    }
+
+    // SUB/UNSUB go out on their own socket, the replies must not land among the packets
+    int ctlfd = -1;
+    struct sockaddr_in streamer;
+    if (subscribe_to != NULL) {
+        char ip[INET_ADDRSTRLEN];
+        int ctlPort = DEFAULT_CONTROL_PORT;
+        memset(&streamer, 0, sizeof(streamer));
+        streamer.sin_family = AF_INET;
+        if (sscanf(subscribe_to, "%15[0-9.]:%d", ip, &ctlPort) < 1 || inet_pton(AF_INET, ip, &streamer.sin_addr) <= 0
+            || ctlPort <= 0 || ctlPort > 65535) {
+            fprintf(stderr, "Invalid streamer address: %s\n", subscribe_to);
+            close(sockfd);
+            return -1;
+        }
+        streamer.sin_port = htons(ctlPort);
+        ctlfd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (ctlfd < 0) {
+            perror("Error creating control socket");
+            close(sockfd);
+            return -1;
+        }
+    }
+
+    FILE *out = NULL;
+    if (out_path != NULL) {
+        out = fopen(out_path, "wb");
+        if (out == NULL) {
+            perror("Failed to open output file");
+            close(sockfd);
+            return -1;
+        }
+    }
+
+    static uint32_t decoded[IQ_CODEC_MAX_SAMPLES]; // samples of the compressed packet at hand
+    // preallocated ring of packet slots, recvmmsg() writes straight into it
+    uint8_t *ring = calloc(ring_slots, SLOT_SIZE);
+    struct mmsghdr *msgs = calloc(batch, sizeof(struct mmsghdr));
+    struct iovec *iovs = calloc(batch, sizeof(struct iovec));
+    char (*controls)[CMSG_SPACE(sizeof(struct timespec))] = calloc(batch, CMSG_SPACE(sizeof(struct timespec)));
+    if (ring == NULL || msgs == NULL || iovs == NULL || controls == NULL) {
+        fprintf(stderr, "Failed to allocate the receive ring\n");
+        close(sockfd);
+        return -1;
+    }
+
+    struct sigaction sigact;
+    memset(&sigact, 0, sizeof(sigact));
+    sigact.sa_handler = signalHandler;
+    sigaction(SIGINT, &sigact, NULL);
+    sigaction(SIGTERM, &sigact, NULL);
+
+    printf("Listening for UDP packets on port %d (receive buffer %d bytes, batch %u, ring %u slots)\n",
+           port, actual, batch, ring_slots);
+
+    unsigned int head = 0; // next ring slot to receive into
+    struct timespec start, last, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    last = start;
+    struct timespec renewed = start;
+    if (ctlfd >= 0) {
+        send_control(ctlfd, &streamer, "SUB", port);
+    }
+    captureStats lastStats = stats;
+
+    while (!terminate) {
+        // point the next batch of messages at the next ring slots
+        unsigned int n = batch;
+        if (head + n > ring_slots) {
+            n = ring_slots - head; // do not wrap inside one call
+        }
+        for (unsigned int i = 0; i < n; i++) {
+            iovs[i].iov_base = ring + (size_t)(head + i) * SLOT_SIZE;
+            iovs[i].iov_len = SLOT_SIZE;
+            memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            msgs[i].msg_hdr.msg_control = controls[i];
+            msgs[i].msg_hdr.msg_controllen = sizeof(controls[i]);
+        }
+
+        // wait at most 100 ms (to keep printing stats), then take whatever is queued;
+        // the timeout argument of recvmmsg() is only checked after a datagram arrived
+        struct pollfd pfd = { .fd = sockfd, .events = POLLIN };
+        int received = 0;
+        if (poll(&pfd, 1, 100) > 0) {
+            received = recvmmsg(sockfd, msgs, n, MSG_DONTWAIT, NULL);
+            stats.syscalls++;
+        }
+        if (received < 0 && errno != EAGAIN && errno != EINTR) {
+            perror("recvmmsg failed");
+            break;
+        }
+
+        for (int i = 0; i < received; i++) {
+            const uint8_t *data = iovs[i].iov_base;
+            size_t len = msgs[i].msg_len;
+
+            struct timespec arrival = {0, 0};
+            for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cm != NULL; cm = CMSG_NXTHDR(&msgs[i].msg_hdr, cm)) {
+                if (cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_TIMESTAMPNS) {
+                    memcpy(&arrival, CMSG_DATA(cm), sizeof(arrival));
+                }
+            }
+            if (arrival.tv_sec == 0) {
+                clock_gettime(CLOCK_REALTIME, &arrival);
+            }
+
+            size_t payload = 0;
+            size_t samples = 0;
+            uint32_t seq = 0;
+            const void *sampleData = NULL; // what -o writes: the payload, or the decoded samples
+            const sdrPacketHeader *header = (const sdrPacketHeader *)data;
+            if (len >= sizeof(sdrPacketHeader) && header->magic == SDR_PACKET_MAGIC
+                && (header->flags & SDR_FLAG_COMPRESSED)) {
+                // a corrupt or truncated payload fails to decode and counts as malformed
+                size_t headerBytes = (size_t)header->headerWords * 4;
+                if (header->format != SDR_FORMAT_CS16_QI || len < headerBytes
+                    || iqCodec_decode(data + headerBytes, len - headerBytes, header->sampleCount, decoded) != 0) {
+                    stats.malformed++;
+                    continue;
+                }
+                seq = header->sequence;
+                payload = len - headerBytes;
+                samples = header->sampleCount;
+                sampleData = decoded;
+                stats.compressed++;
+                stats.decodedBytes += samples * 4;
+            } else if (len >= sizeof(sdrPacketHeader) && header->magic == SDR_PACKET_MAGIC
+                && sdrPacket_sampleBytes(header->format) > 0
+                && len == (size_t)header->headerWords * 4 + (size_t)header->sampleCount * sdrPacket_sampleBytes(header->format)) {
+                seq = header->sequence;
+                payload = len - (size_t)header->headerWords * 4;
+                samples = header->sampleCount;
+            } else if (len > SDR_LEGACY_HEADER_SIZE && (len - SDR_LEGACY_HEADER_SIZE) % 4 == 0
+                       && !(len >= 4 && header->magic == SDR_PACKET_MAGIC)) {
+                memcpy(&seq, data, sizeof(seq));
+                payload = len - SDR_LEGACY_HEADER_SIZE;
+                samples = payload / 4;
+                stats.legacy++;
+            } else {
+                stats.malformed++; // counted, never silently dropped
+                continue;
+            }
+
+            stats.packets++;
+            stats.bytes += payload;
+            stats.samples += samples;
+            track_sequence(seq);
+            track_timing(data, len, &arrival);
+            if (out != NULL && sampleData != NULL) {
+                fwrite(sampleData, 4, samples, out);
+            } else if (out != NULL) {
+                fwrite(data + (len - payload), 1, payload, out);
+            }
+        }
+        if (received > 0) {
+            head = (head + received) % ring_slots;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        double seconds = (now.tv_sec - last.tv_sec) + (now.tv_nsec - last.tv_nsec) / 1e9;
+        if (seconds >= 1.0) {
+            print_stats(&stats, &lastStats, seconds);
+            lastStats = stats;
+            last = now;
+        }
+        if (duration > 0 && now.tv_sec - start.tv_sec >= duration) {
+            break;
+        }
+        if (ctlfd >= 0 && now.tv_sec - renewed.tv_sec >= SUBSCRIBE_RENEW_S) {
+            send_control(ctlfd, &streamer, "SUB", port); // renew the lease
+            renewed = now;
+        }
+    }
+    if (ctlfd >= 0) {
+        send_control(ctlfd, &streamer, "UNSUB", port);
+        close(ctlfd);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double total = (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+    captureStats zero;
+    memset(&zero, 0, sizeof(zero));
+    printf("\nCapture summary (%.1f s):\n", total);
+    print_stats(&stats, &zero, total);
+    printf("    Malformed datagrams: %llu, legacy-layout packets: %llu, recvmmsg calls: %llu (%.1f packets/call)\n",
+           (unsigned long long)stats.malformed, (unsigned long long)stats.legacy, (unsigned long long)stats.syscalls,
+           stats.syscalls ? (double)stats.packets / stats.syscalls : 0.0);
+    if (stats.compressed > 0) {
+        printf("    Compressed packets: %llu, decoded to %llu sample bytes (ratio %.2f)\n",
+               (unsigned long long)stats.compressed, (unsigned long long)stats.decodedBytes,
+               stats.bytes > 0 ? (double)stats.decodedBytes / stats.bytes : 0.0);
+    }
+    if (stats.restarts > 0) {
+        printf("    Streamer restarts: %llu (sequence started over)\n", (unsigned long long)stats.restarts);
+    }
+    if (stats.discontinuities > 0) {
+        printf("    Discontinuities: %llu packets with samples lost at the FIFO\n", (unsigned long long)stats.discontinuities);
+    }
+    if (stats.latencySamples > 0) {
+        printf("    FIFO-to-wire latency: mean %.0f us, max %.0f us\n",
+               stats.fifoToWireUsTotal / stats.latencySamples, stats.fifoToWireUsMax);
+        printf("    Wire-to-host latency: mean %.0f us (needs synced clocks)\n",
+               stats.wireToHostUsTotal / stats.latencySamples);
+    }
+
+    if (out != NULL) {
+        fclose(out);
+    }
+    free(controls);
+    free(iovs);
+    free(msgs);
+    free(ring);
+    close(sockfd);
+    return 0;
+}
+
+/**
+ * @brief Send a SUB/UNSUB request for this port to the streamer and print a refusal
+ * @details The streamer answers every request; only an error is worth showing,
+ *          a lost reply is covered by the next renewal. The first request is
+ *          answered with a cookie, which goes with this and every later request.
+ */
+void send_control(int fd, const struct sockaddr_in *streamer, const char *verb, int port)
+{
+    static char cookie[24] = ""; // from the streamer's COOKIE reply, the same for every request
+    for (int attempt = 0; attempt < 2; attempt++) {
+        char msg[64];
+        int len = snprintf(msg, sizeof(msg), "%s %d %s", verb, port, cookie);
+        if (sendto(fd, msg, len, 0, (const struct sockaddr *)streamer, sizeof(*streamer)) < 0) {
+            perror("Failed to send the subscription request");
+            return;
+        }
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        char reply[64];
+        if (poll(&pfd, 1, 100) <= 0) {
+            return;
+        }
+        ssize_t n = recv(fd, reply, sizeof(reply) - 1, MSG_DONTWAIT);
+        if (n <= 0) {
+            return;
+        }
+        reply[n] = '\0';
+        if (sscanf(reply, "COOKIE %23s", cookie) == 1) {
+            continue; // repeat the request with it
+        }
+        if (strncmp(reply, "OK", 2) != 0) {
+            fprintf(stderr, "Streamer refused %s: %s", msg, reply);
+        }
+        return;
+    }
+}
+
+/**
+ * @brief Account for one sequence number
+ * @details A number above the highest one seen opens a gap (counted as lost
+ *          until it shows up); a number inside the remembered window is either
+ *          a duplicate or a late packet filling a gap. A number further back
+ *          than the window means the streamer restarted and counts from 0
+ *          again: the tracking starts over from it.
+ */
+void track_sequence(uint32_t seq)
+{
+    if (!haveSeq) {
+        haveSeq = true;
+        highestSeq = seq;
+        seen[(seq % SEQ_WINDOW) / 8] |= 1 << (seq % 8);
+        return;
+    }
+
+    int32_t ahead = (int32_t)(seq - highestSeq);
+    if (ahead > 0) {
+        if ((uint32_t)ahead >= SEQ_WINDOW) {
+            memset(seen, 0, sizeof(seen)); // jumped past the whole window (a long outage)
+        } else {
+            for (uint32_t s = highestSeq + 1; s != seq; s++) {
+                seen[(s % SEQ_WINDOW) / 8] &= ~(1 << (s % 8)); // not seen yet
+            }
+        }
+        stats.lost += ahead - 1;
+        highestSeq = seq;
+        seen[(seq % SEQ_WINDOW) / 8] |= 1 << (seq % 8);
+    } else if (-ahead < SEQ_WINDOW) {
+        uint8_t bit = 1 << (seq % 8);
+        if (seen[(seq % SEQ_WINDOW) / 8] & bit) {
+            stats.duplicates++;
+        } else {
+            seen[(seq % SEQ_WINDOW) / 8] |= bit;
+            stats.reordered++; // late, but it fills a gap
+            if (stats.lost > 0) {
+                stats.lost--;
+            }
+        }
+    } else {
+        // far behind: a restarted streamer, not copies of packets that old
+        stats.restarts++;
+        memset(seen, 0, sizeof(seen));
+        highestSeq = seq;
+        seen[(seq % SEQ_WINDOW) / 8] |= 1 << (seq % 8);
+    }
+}
+
+/**
+ * @brief Update jitter and latency from one packet
+ * @details Jitter follows RFC 3550: the smoothed difference of consecutive
+ *          transit times. The send time comes from the header; legacy packets
+ *          have none, so their nominal time (sequence x packet duration) is used.
+ */
+void track_timing(const uint8_t *data, size_t len, const struct timespec *arrival)
+{
+    const sdrPacketHeader *header = (const sdrPacketHeader *)data;
+    double arrivalUs = arrival->tv_sec * 1e6 + arrival->tv_nsec / 1e3;
+    double sendUs;
+    if (header->magic == SDR_PACKET_MAGIC) {
+        sendUs = header->sendTimeNs / 1e3;
+        if (header->flags & SDR_FLAG_DISCONTINUITY) {
+            stats.discontinuities++;
+        }
+        if (header->flags & SDR_FLAG_TIMESTAMPS) {
+            double fifoToWireUs = (uint32_t)(header->sendTicks - header->captureTicks) * 1e6 / SDR_TIMER_HZ;
+            stats.fifoToWireUsTotal += fifoToWireUs;
+            if (fifoToWireUs > stats.fifoToWireUsMax) {
+                stats.fifoToWireUsMax = fifoToWireUs;
+            }
+            stats.wireToHostUsTotal += arrivalUs - sendUs;
+            stats.latencySamples++;
+        }
+    } else {
+        uint32_t seq;
+        memcpy(&seq, data, sizeof(seq));
+        sendUs = seq * ((len - SDR_LEGACY_HEADER_SIZE) / 4) * 1e6 / LEGACY_SAMPLE_RATE;
+    }
+
+    double transitUs = arrivalUs - sendUs;
+    bool legacy = (header->magic != SDR_PACKET_MAGIC);
+    if (haveTransit && legacy == lastLegacy) {
+        double d = transitUs - lastTransitUs;
+        stats.jitterUs += ((d < 0 ? -d : d) - stats.jitterUs) / 16;
+    }
+    lastTransitUs = transitUs;
+    lastLegacy = legacy;
+    haveTransit = true;
+}
+
+/**
+ * @brief Print the counters of one interval
+ */
+void print_stats(const captureStats *now, const captureStats *last, double seconds)
+{
+    uint64_t packets = now->packets - last->packets;
+    uint64_t lost = now->lost - last->lost;
+    printf("%8.0f packets/s  %7.2f Mb/s  %8.0f samples/s  lost %llu (%.3f%%)  dup %llu  reordered %llu  jitter %.0f us\n",
+           packets / seconds, (now->bytes - last->bytes) * 8 / seconds / 1e6, (now->samples - last->samples) / seconds,
+           (unsigned long long)lost, (packets + lost) ? 100.0 * lost / (packets + lost) : 0.0,
+           (unsigned long long)(now->duplicates - last->duplicates),
+           (unsigned long long)(now->reordered - last->reordered), now->jitterUs);
+}
+
+/**
+ * @brief Stop the capture loop
+ */
+void signalHandler(int sig)
+{
+    (void)sig;
+    terminate = 1;
+}
+
+void usage(const char *executableName)
+{
+    printf("Usage: %s -p <port> [-b <batch>] [-n <slots>] [-r <bytes>] [-t <seconds>] [-o <file>] [-S <ip>[:<port>]] [-g <group>]\n", executableName);
+    printf("  port: UDP port to listen on (default %d)\n", DEFAULT_PORT);
+    printf("  batch: datagrams per recvmmsg() call, 1 to %d (default %d)\n", MAX_BATCH, DEFAULT_BATCH);
+    printf("  slots: preallocated packet slots in the receive ring (default %d)\n", DEFAULT_RING_SLOTS);
+    printf("  bytes: socket receive buffer size (default %d)\n", DEFAULT_RCVBUF);
+    printf("  seconds: stop after this long (default: until Ctrl-C)\n");
+    printf("  file: append the raw samples of every packet to this file (compressed packets decoded)\n");
+    printf("  -S: subscribe at the streamer's control port (default %d) and renew until done\n", DEFAULT_CONTROL_PORT);
+    printf("  -g: join this multicast group (the streamer sends to it with -m)\n");
+}
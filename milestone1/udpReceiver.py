@@ -8,13 +8,26 @@ import argparse
 import struct
 import select 
 
-PACKET_SIZE = 4 + 512 * 2  # uint32_t + 512 int16_t
+DEFAULT_NUM_SAMPLES = 256   # I/Q samples per packet, must match the sender's -s (legacy packets)
+MAX_DATAGRAM = 65535
+
+# self-describing header of web/cgi-bin/sdrPacket.h
+SDR_PACKET_MAGIC = 0x53445250
+SDR_HEADER = struct.Struct("<IBBHIHHIIIIIIQ")
+SDR_TIMER_HZ = 125e6
+
+def packet_size(num_samples):
+    return 4 + num_samples * 4  # uint32_t + num_samples x (int16_t I, int16_t Q)
 
 def main():
     # Set up argument parser
     parser = argparse.ArgumentParser(description="UDP Receiver")
     parser.add_argument("-p", "--port", type=int, required=True, help="Port to listen on")
+    parser.add_argument("-s", "--samples", type=int, default=DEFAULT_NUM_SAMPLES,
+                        help="I/Q samples per packet (default: %(default)s)")
     args = parser.parse_args()
+    PACKET_SIZE = packet_size(args.samples)
+    sample_format = f"<{2 * args.samples}h"
 
     # Create a UDP socket
     try:
@@ -38,12 +51,22 @@ def main():
             # 100ms timeout
             ready_socks, _, _ = select.select([sock], [], [], 0.1)  
             if sock in ready_socks:
-                data, addr = sock.recvfrom(PACKET_SIZE)
+                data, addr = sock.recvfrom(MAX_DATAGRAM)
+                if len(data) >= SDR_HEADER.size and struct.unpack_from("<I", data, 0)[0] == SDR_PACKET_MAGIC:
+                    (_, version, header_words, flags, sequence, sample_count, _, sample_rate,
+                     adc_pinc, tuner_pinc, capture_ticks, send_ticks, _, send_time_ns) = SDR_HEADER.unpack_from(data, 0)
+                    latency = ""
+                    if flags & 0x1:
+                        fifo_to_wire_us = ((send_ticks - capture_ticks) & 0xFFFFFFFF) / SDR_TIMER_HZ * 1e6
+                        latency = f", FIFO-to-wire {fifo_to_wire_us:.0f} us"
+                    print(f"Received packet seq: {sequence}, {sample_count} samples @ {sample_rate} S/s{latency}")
+                    continue
                 if len(data) != PACKET_SIZE:
+                    print(f"Unexpected packet size {len(data)} (expected {PACKET_SIZE}, check -s)")
                     continue
 
                 packet_id = struct.unpack_from("<I", data, 0)[0]
-                samples = struct.unpack_from("<512h", data, 4)
+                samples = struct.unpack_from(sample_format, data, 4)
                 print(f"Received packet ID: {packet_id}")
     except KeyboardInterrupt:
         pass
@@ -1,115 +1,588 @@
 /**
  * @file udpSender.c
  * @author Yuchen Zhou (yzhou276@jh.edu)
- * @brief 
+ * @brief UDP load generator for the SDR packet layout: synthetic ramp or replayed IQ recording
+ * @details N sender threads, each with its own connected socket (and so its
+ *          own source port), send packets with sendmmsg() batches at a target
+ *          packet or bit rate. Packet IDs are striped across the threads
+ *          (thread k sends k, k + N, k + 2N, ...), so a receiver still sees one
+ *          sequence. Every pacing deadline is computed from the packet index
+ *          (start + k * period), so sleep and send jitter never accumulate.
+ *          A reporter prints the achieved rate, send errors and CPU time once
+ *          per interval, as text or JSON lines (-j), optionally for a sweep of
+ *          packet sizes.
+ *
+ *          Replay mode memory-maps a recorded IQ file (int16 pairs, e.g. a
+ *          .sigmf-data file or the raw output of udpCapture -o) and cuts it into
+ *          the dataPacket layout of the FIFO streamer, paced at the original
+ *          sample rate (times -x).
  * @version 0.1
  * @date 2025-04-15
- * 
+ *
  * @copyright Copyright (c) 2025
- * 
+ *
  */
 
+#define _GNU_SOURCE // sendmmsg
+
 #include <stdio.h>
-#include <stdlib.h> 
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <stdint.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <signal.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <sys/socket.h>
 
 /* structure definition */
 
-#define NUM_SAMPLES 512 // Number of samples in the packet
+#define DEFAULT_NUM_SAMPLES 256 // Number of I/Q samples in the packet (same layout as the FIFO streamer)
+#define MAX_NUM_SAMPLES 2242    // Largest packet in a 9000-byte (jumbo) MTU
+#define DEFAULT_SAMPLE_RATE 48000 // Sample rate of the radio tuner, assumed for recordings without metadata
+#define MAX_THREADS 64          // Upper limit for -T
+#define DEFAULT_BATCH 1         // Packets per sendmmsg() call (1 keeps replay pacing smooth)
+#define MAX_BATCH 1024          // Upper limit for -b
+#define DEFAULT_REPORT_MS 1000  // Report interval
+#define UDP_IP_HEADER_SIZE 28   // IPv4 + UDP header bytes, counted by the -B bit rate
 typedef struct dataPacket
 {
     /* data */
     uint32_t packetID;
-    int16_t  sdrData[NUM_SAMPLES];
+    int16_t  sdrData[];         // I/Q pairs, 2 int16 per sample
 } dataPacket;
 
-#define PACKET_SIZE (sizeof(dataPacket)) // 1028
+#define PACKET_SIZE(numSamples) (sizeof(dataPacket) + (size_t)(numSamples) * 2 * sizeof(int16_t)) // 1028 by default
+
+/**
+ * @brief One sender thread, its counters are read by the reporter
+ */
+typedef struct senderThread
+{
+    pthread_t thread;           // thread handle
+    unsigned int index;         // thread number, also its first packet ID
+    int sockfd;                 // own socket, connected to the destination
+    unsigned short sourcePort;  // local port of the socket
+    uint64_t quota;             // packets to send in this step (0: until stopped)
+    double pps;                 // packet rate of this thread (0: as fast as possible)
+    atomic_ullong packets;      // packets sent
+    atomic_ullong errors;       // packets the kernel refused
+    atomic_ullong syscalls;     // sendmmsg() calls
+    atomic_ullong late;         // batches that left more than one period behind schedule
+    atomic_int done;            // quota reached
+} senderThread;
+
+/**
+ * @brief Totals over all threads at one point in time
+ */
+typedef struct senderTotals
+{
+    uint64_t packets;
+    uint64_t errors;
+    uint64_t syscalls;
+    uint64_t late;
+    double cpuSeconds;          // process CPU time (user + system)
+} senderTotals;
+
+/** Global Variables */
+struct sockaddr_in server_addr;             // Destination address
+int num_samples = DEFAULT_NUM_SAMPLES;      // Samples per packet of the current step
+size_t packet_size = 0;                     // Bytes per packet of the current step
+unsigned int num_threads = 1;               // Sender threads
+unsigned int batch_size = DEFAULT_BATCH;    // Packets per sendmmsg() call
+senderThread senders[MAX_THREADS];          // Sender threads
+const uint32_t *recording = NULL;           // Mapped IQ recording, one 32-bit I/Q pair per sample (NULL: ramp)
+size_t recording_samples = 0;               // Samples in the recording
+size_t position = 0;                        // Next sample of the recording (single replay thread)
+int loop = 0;                               // Start over at the end of the recording
+int json = 0;                               // Machine-readable output (JSON lines on stdout)
+FILE *info = NULL;                          // Human-readable messages (stderr with -j)
+volatile sig_atomic_t stop = 0;             // Ctrl-C: stop everything
+atomic_int step_stop;                       // Stop the threads of the current step
 
 /* Prototype */
 void usage(const char *executableName);
+double sigmf_sample_rate(const char *dataPath);
+void *sender_task(void *arg);
+void replay_fill(dataPacket *packet);
+void collect_totals(senderTotals *totals);
+void report(const char *type, double elapsed, const senderTotals *now, const senderTotals *last, double seconds);
+void signalHandler(int sig);
 
 int main(int argc, char const *argv[])
 {
     char* ip        = NULL;
     int port        = -1;
-    int num_packets = -1;
+    long long num_packets = -1;
+    const char *replay_path = NULL; // IQ recording to replay (NULL: synthetic ramp)
+    double sample_rate = 0;         // pacing rate in samples/s (0: as fast as possible)
+    double speed    = 1.0;          // replay speed factor
+    double target_pps = 0;          // -R: packets/s over all threads
+    double target_bps = 0;          // -B: bits/s over all threads, UDP/IP headers included
+    int sweep_min = 0, sweep_max = 0, sweep_step = 0; // -S: samples per packet sweep
+    double duration = 0;            // -d: seconds per step (0: until num_packets are sent)
+    int report_ms = DEFAULT_REPORT_MS;
     int opt         = 0;
 
     // Parse command line arguments
-    while ((opt = getopt(argc, (char * const *)argv, "i:p:n:")) != -1) {
+    while ((opt = getopt(argc, (char * const *)argv, "i:p:n:s:f:r:x:lT:b:R:B:S:d:P:j")) != -1) {
         switch (opt) {
             case 'i':
                 ip = optarg; break;
             case 'p':
                 port = atoi(optarg); break;
             case 'n':
-                num_packets = atoi(optarg); break;
+                num_packets = atoll(optarg); break;
+            case 's':
+                num_samples = atoi(optarg); break;
+            case 'f':
+                replay_path = optarg; break;
+            case 'r':
+                sample_rate = atof(optarg); break;
+            case 'x':
+                speed = atof(optarg); break;
+            case 'l':
+                loop = 1; break;
+            case 'T':
+                num_threads = (unsigned int)atoi(optarg); break;
+            case 'b':
+                batch_size = (unsigned int)atoi(optarg); break;
+            case 'R':
+                target_pps = atof(optarg); break;
+            case 'B':
+                target_bps = atof(optarg); break;
+            case 'S':
+                if (sscanf(optarg, "%d:%d:%d", &sweep_min, &sweep_max, &sweep_step) != 3) {
+                    usage(argv[0]);
+                }
+                break;
+            case 'd':
+                duration = atof(optarg); break;
+            case 'P':
+                report_ms = atoi(optarg); break;
+            case 'j':
+                json = 1; break;
             default:
                 usage(argv[0]); return -1;
         }
     }
+    info = json ? stderr : stdout; // keep stdout machine-readable
 
-    if (ip == NULL || port < 0 || num_packets < 0) {
+    // without a packet count: a replay sends the whole recording, a timed run sends until -d runs out
+    if (ip == NULL || port < 0 || (num_packets < 0 && replay_path == NULL && duration <= 0)
+        || num_samples <= 0 || num_samples > MAX_NUM_SAMPLES || sample_rate < 0 || speed <= 0
+        || num_threads == 0 || num_threads > MAX_THREADS || batch_size == 0 || batch_size > MAX_BATCH
+        || target_pps < 0 || target_bps < 0 || duration < 0 || report_ms <= 0) {
         usage(argv[0]);
     }
-
-    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
-    if (sockfd < 0) {
-        perror("Error creating socket");
+    if (sweep_step != 0 && (sweep_min <= 0 || sweep_max > MAX_NUM_SAMPLES || sweep_min > sweep_max || sweep_step < 0)) {
+        usage(argv[0]);
+    }
+    if (sweep_step == 0) {
+        sweep_min = sweep_max = num_samples; // a single step
+        sweep_step = 1;
+    }
+    if (replay_path != NULL && num_threads > 1) {
+        fprintf(stderr, "A replay is sent by a single thread, the recording must stay in order\n");
         exit(EXIT_FAILURE);
     }
 
+    // map the recording, the page cache does the reading
+    if (replay_path != NULL) {
+        int fd = open(replay_path, O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            perror("Error opening recording");
+            exit(EXIT_FAILURE);
+        }
+        recording_samples = (size_t)st.st_size / sizeof(uint32_t);
+        if (recording_samples == 0) {
+            fprintf(stderr, "Recording %s holds no samples\n", replay_path);
+            exit(EXIT_FAILURE);
+        }
+        recording = mmap(NULL, recording_samples * sizeof(uint32_t), PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (recording == MAP_FAILED) {
+            perror("Error mapping recording");
+            exit(EXIT_FAILURE);
+        }
+        madvise((void *)recording, recording_samples * sizeof(uint32_t), MADV_SEQUENTIAL);
+        if (sample_rate == 0) {
+            sample_rate = sigmf_sample_rate(replay_path); // from the SigMF metadata, if there is one
+        }
+        fprintf(info, "Replaying %s: %zu samples at %.0f samples/s x %.2f%s\n", replay_path, recording_samples,
+                sample_rate, speed, loop ? ", looping" : "");
+    }
+
     // create a sockaddr_in structure to hold the server address
-    struct sockaddr_in server_addr;
     memset(&server_addr, 0, sizeof(server_addr));
     server_addr.sin_family = AF_INET;
     server_addr.sin_port = htons(port);
     if (inet_pton(AF_INET, ip, &server_addr.sin_addr) <= 0) {
         perror("Invalid IP address or IP Address not supported");
-        close(sockfd);
         exit(EXIT_FAILURE);
     }
 
-    printf("PACKET_SIZE: %d\n", PACKET_SIZE);
-    dataPacket packet;
-    packet.packetID = 0;
-    memset(packet.sdrData, 0, sizeof(packet.sdrData)); // Initialize sdrData to 0
-    for(int i = 0; i < NUM_SAMPLES; i++) // Fill the sdrData array with some sample data
-    {
-        packet.sdrData[i] = i;
+    // one connected socket per thread: its own source port, and no route lookup per send
+    for (unsigned int t = 0; t < num_threads; t++) {
+        senders[t].index = t;
+        senders[t].sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (senders[t].sockfd < 0 || connect(senders[t].sockfd, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
+            perror("Error creating socket");
+            exit(EXIT_FAILURE);
+        }
+        struct sockaddr_in local;
+        socklen_t len = sizeof(local);
+        getsockname(senders[t].sockfd, (struct sockaddr *)&local, &len);
+        senders[t].sourcePort = ntohs(local.sin_port);
     }
+    fprintf(info, "Sending to %s : %d from %u thread(s), source ports %u-%u, batch of %u\n", ip, port, num_threads,
+            senders[0].sourcePort, senders[num_threads - 1].sourcePort, batch_size);
 
-    // send packets to the server
-    for (int i = 0; i < num_packets; i++) 
-    {
-        packet.packetID = i;
-        ssize_t bytes_sent = sendto(sockfd, &packet, PACKET_SIZE, 0, (struct sockaddr *)&server_addr, sizeof(server_addr));
-        if (bytes_sent < 0) {
-            perror("Error sending packet");
-            close(sockfd);
-            exit(EXIT_FAILURE);
+    struct sigaction sigact;
+    memset(&sigact, 0, sizeof(sigact));
+    sigact.sa_handler = signalHandler;
+    sigaction(SIGINT, &sigact, NULL);
+    sigaction(SIGTERM, &sigact, NULL);
+
+    for (int step = sweep_min; step <= sweep_max && !stop; step += sweep_step) {
+        num_samples = step;
+        packet_size = PACKET_SIZE(num_samples);
+        position = 0;
+
+        // packet rate over all threads: -R, else -B, else the sample rate, else as fast as possible
+        double pps = target_pps;
+        if (pps == 0 && target_bps > 0) {
+            pps = target_bps / ((packet_size + UDP_IP_HEADER_SIZE) * 8.0);
+        }
+        if (pps == 0 && sample_rate > 0) {
+            pps = sample_rate * speed / num_samples;
+        }
+        uint64_t total = 0; // packets of this step (0: until stopped)
+        if (num_packets > 0) {
+            total = (uint64_t)num_packets;
+        } else if (num_packets < 0 && recording != NULL && !loop) {
+            total = (recording_samples + num_samples - 1) / num_samples; // the whole recording once
+        }
+        char rate[32] = "as fast as possible";
+        if (pps > 0) {
+            snprintf(rate, sizeof(rate), "%.0f packets/s", pps);
+        }
+        fprintf(info, "Step: %zu-byte packets (%d samples), %s, ", packet_size, num_samples, rate);
+        if (total > 0) {
+            fprintf(info, "%llu packets%s\n", (unsigned long long)total, duration > 0 ? " or until the step time runs out" : "");
+        } else {
+            fprintf(info, "until %s\n", duration > 0 ? "the step time runs out" : "stopped");
+        }
+
+        atomic_store(&step_stop, 0);
+        for (unsigned int t = 0; t < num_threads; t++) {
+            senderThread *st = &senders[t];
+            st->quota = total / num_threads + (t < total % num_threads ? 1 : 0);
+            st->pps = pps / num_threads;
+            atomic_store(&st->packets, 0);
+            atomic_store(&st->errors, 0);
+            atomic_store(&st->syscalls, 0);
+            atomic_store(&st->late, 0);
+            atomic_store(&st->done, total > 0 && st->quota == 0);
+        }
+
+        senderTotals first, last, now;
+        collect_totals(&first);
+        struct timespec start, tick;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (unsigned int t = 0; t < num_threads; t++) {
+            if (pthread_create(&senders[t].thread, NULL, sender_task, &senders[t]) != 0) {
+                perror("Failed to create sender thread");
+                exit(EXIT_FAILURE);
+            }
         }
-        printf("Sent packet ID: %d\n", i);
+
+        // report every interval until the quota is sent, the step time is up or Ctrl-C
+        last = first;
+        double elapsed = 0, lastReport = 0;
+        for (;;) {
+            usleep(10000);
+            clock_gettime(CLOCK_MONOTONIC, &tick);
+            elapsed = (tick.tv_sec - start.tv_sec) + (tick.tv_nsec - start.tv_nsec) / 1e9;
+            unsigned int done = 0;
+            for (unsigned int t = 0; t < num_threads; t++) {
+                done += atomic_load(&senders[t].done) ? 1 : 0;
+            }
+            if (done == num_threads || stop || (duration > 0 && elapsed >= duration)) {
+                break;
+            }
+            if (elapsed - lastReport >= report_ms / 1e3) {
+                collect_totals(&now);
+                report("interval", elapsed, &now, &last, elapsed - lastReport);
+                last = now;
+                lastReport = elapsed;
+            }
+        }
+        atomic_store(&step_stop, 1);
+        for (unsigned int t = 0; t < num_threads; t++) {
+            pthread_join(senders[t].thread, NULL);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &tick);
+        elapsed = (tick.tv_sec - start.tv_sec) + (tick.tv_nsec - start.tv_nsec) / 1e9;
+        collect_totals(&now);
+        report("step", elapsed, &now, &first, elapsed);
     }
 
-    printf("Sent %d packets to %s : %d\n", num_packets, ip, port);
-    close(sockfd);
+    for (unsigned int t = 0; t < num_threads; t++) {
+        close(senders[t].sockfd);
+    }
+    if (recording != NULL) {
+        munmap((void *)recording, recording_samples * sizeof(uint32_t));
+    }
 
     return 0;
 }
 
+/**
+ * @brief Sender thread: fill a batch, wait for its slot in the schedule, send it
+ *
+ * @param arg senderThread
+ */
+void *sender_task(void *arg)
+{
+    senderThread *st = arg;
+    dataPacket *packets = calloc(batch_size, packet_size);
+    struct mmsghdr *msgs = calloc(batch_size, sizeof(struct mmsghdr));
+    struct iovec *iovs = calloc(batch_size, sizeof(struct iovec));
+    if (packets == NULL || msgs == NULL || iovs == NULL) {
+        perror("Error allocating packets");
+        stop = 1;
+        atomic_store(&st->done, 1);
+        free(packets);
+        free(msgs);
+        free(iovs);
+        return NULL;
+    }
+    for (unsigned int i = 0; i < batch_size; i++) {
+        dataPacket *packet = (dataPacket *)((char *)packets + i * packet_size);
+        for (int s = 0; recording == NULL && s < 2 * num_samples; s++) // Fill the sdrData array with some sample data
+        {
+            packet->sdrData[s] = s;
+        }
+        iovs[i].iov_base = packet;
+        iovs[i].iov_len = packet_size;
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1; // connected socket, no address needed
+    }
+
+    // batch k leaves at start + k * batch * period; computed from k every time, so errors do not add up
+    double period_ns = st->pps > 0 ? 1e9 / st->pps : 0;
+    uint32_t packetID = st->index;
+    uint64_t sent = 0;
+    int reported = 0;
+    struct timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while (!stop && !atomic_load_explicit(&step_stop, memory_order_relaxed) && (st->quota == 0 || sent < st->quota)) {
+        unsigned int n = batch_size;
+        if (st->quota > 0 && st->quota - sent < n) {
+            n = (unsigned int)(st->quota - sent);
+        }
+        for (unsigned int i = 0; i < n; i++) {
+            dataPacket *packet = (dataPacket *)((char *)packets + i * packet_size);
+            packet->packetID = packetID;
+            packetID += num_threads; // IDs are striped across the threads
+            if (recording != NULL) {
+                replay_fill(packet);
+            }
+        }
+
+        if (period_ns > 0) {
+            uint64_t offset = (uint64_t)(sent * period_ns);
+            struct timespec due = start;
+            due.tv_sec += offset / 1000000000;
+            due.tv_nsec += offset % 1000000000;
+            if (due.tv_nsec >= 1000000000) {
+                due.tv_sec++;
+                due.tv_nsec -= 1000000000;
+            }
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            double behind_ns = (now.tv_sec - due.tv_sec) * 1e9 + (now.tv_nsec - due.tv_nsec);
+            if (behind_ns > n * period_ns) {
+                atomic_fetch_add_explicit(&st->late, 1, memory_order_relaxed);
+            }
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL) == EINTR && !stop) {
+            }
+        }
+
+        // a short count means message rc failed; its error comes back from the next call
+        for (unsigned int off = 0; off < n; ) {
+            int rc = sendmmsg(st->sockfd, msgs + off, n - off, 0);
+            atomic_fetch_add_explicit(&st->syscalls, 1, memory_order_relaxed);
+            if (rc < 0 && errno == EINTR) {
+                continue;
+            }
+            if (rc < 0) {
+                // a load test keeps going: count what the kernel refused (ENOBUFS, ECONNREFUSED, ...) and move on
+                if (!reported) {
+                    perror("Error sending packet");
+                    reported = 1;
+                }
+                atomic_fetch_add_explicit(&st->errors, 1, memory_order_relaxed);
+                off++;
+                continue;
+            }
+            atomic_fetch_add_explicit(&st->packets, rc, memory_order_relaxed);
+            off += rc;
+        }
+        sent += n;
+    }
+
+    atomic_store(&st->done, 1);
+    free(packets);
+    free(msgs);
+    free(iovs);
+    return NULL;
+}
+
+/**
+ * @brief Copy the next samples of the recording, wrapping around or zero padding at the end
+ */
+void replay_fill(dataPacket *packet)
+{
+    uint32_t *samples = (uint32_t *)packet->sdrData;
+    for (int n = 0; n < num_samples; ) {
+        if (position >= recording_samples) {
+            if (!loop) {
+                memset(&samples[n], 0, (num_samples - n) * sizeof(uint32_t));
+                break;
+            }
+            position = 0;
+        }
+        size_t chunk = recording_samples - position;
+        if (chunk > (size_t)(num_samples - n)) {
+            chunk = num_samples - n;
+        }
+        memcpy(&samples[n], &recording[position], chunk * sizeof(uint32_t));
+        position += chunk;
+        n += chunk;
+    }
+}
+
+/**
+ * @brief Sum the thread counters and read the process CPU time
+ */
+void collect_totals(senderTotals *totals)
+{
+    memset(totals, 0, sizeof(*totals));
+    for (unsigned int t = 0; t < num_threads; t++) {
+        totals->packets += atomic_load_explicit(&senders[t].packets, memory_order_relaxed);
+        totals->errors += atomic_load_explicit(&senders[t].errors, memory_order_relaxed);
+        totals->syscalls += atomic_load_explicit(&senders[t].syscalls, memory_order_relaxed);
+        totals->late += atomic_load_explicit(&senders[t].late, memory_order_relaxed);
+    }
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        totals->cpuSeconds = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6
+                           + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+    }
+}
+
+/**
+ * @brief Print the rates between two snapshots, as text or as one JSON line
+ *
+ * @param type "interval" or "step" (whole step summary)
+ * @param elapsed seconds since the step started
+ * @param now later snapshot
+ * @param last earlier snapshot
+ * @param seconds time between the snapshots
+ */
+void report(const char *type, double elapsed, const senderTotals *now, const senderTotals *last, double seconds)
+{
+    uint64_t packets = now->packets - last->packets;
+    uint64_t syscalls = now->syscalls - last->syscalls;
+    double pps = seconds > 0 ? packets / seconds : 0;
+    double mbps = pps * packet_size * 8 / 1e6; // UDP payload
+    double cpu = seconds > 0 ? 100.0 * (now->cpuSeconds - last->cpuSeconds) / seconds : 0;
+    if (json) {
+        printf("{\"type\":\"%s\",\"time\":%.3f,\"packet_bytes\":%zu,\"threads\":%u,\"batch\":%u,\"packets\":%llu,"
+               "\"pps\":%.1f,\"mbps\":%.3f,\"errors\":%llu,\"syscalls\":%llu,\"late\":%llu,\"cpu_percent\":%.1f}\n",
+               type, elapsed, packet_size, num_threads, batch_size, (unsigned long long)packets, pps, mbps,
+               (unsigned long long)(now->errors - last->errors), (unsigned long long)syscalls,
+               (unsigned long long)(now->late - last->late), cpu);
+    } else {
+        printf("%s%7.2f s  %5zu B x %u: %10.0f packets/s  %9.2f Mb/s  errors %llu  %.3f syscalls/packet  late %llu  CPU %.1f%%\n",
+               strcmp(type, "step") == 0 ? "Total " : "      ", elapsed, packet_size, num_threads, pps, mbps,
+               (unsigned long long)(now->errors - last->errors), packets ? (double)syscalls / packets : 0.0,
+               (unsigned long long)(now->late - last->late), cpu);
+    }
+    fflush(stdout);
+}
+
+/**
+ * @brief Stop all sender threads
+ */
+void signalHandler(int sig)
+{
+    (void)sig;
+    stop = 1;
+}
+
+/**
+ * @brief Look up core:sample_rate in the SigMF metadata next to a .sigmf-data file
+ *
+ * @param dataPath path of the recording
+ * @return double sample rate, DEFAULT_SAMPLE_RATE if there is no metadata
+ */
+double sigmf_sample_rate(const char *dataPath)
+{
+    char metaPath[4096];
+    const char *ext = strstr(dataPath, ".sigmf-data");
+    if (ext == NULL || (size_t)(ext - dataPath) + sizeof(".sigmf-meta") > sizeof(metaPath)) {
+        return DEFAULT_SAMPLE_RATE;
+    }
+    snprintf(metaPath, sizeof(metaPath), "%.*s.sigmf-meta", (int)(ext - dataPath), dataPath);
+
+    FILE *meta = fopen(metaPath, "r");
+    if (meta == NULL) {
+        return DEFAULT_SAMPLE_RATE;
+    }
+    double rate = DEFAULT_SAMPLE_RATE;
+    char line[256];
+    while (fgets(line, sizeof(line), meta) != NULL) {
+        const char *key = strstr(line, "\"core:sample_rate\"");
+        if (key != NULL) {
+            sscanf(key, "\"core:sample_rate\" : %lf", &rate);
+        }
+    }
+    fclose(meta);
+    return rate;
+}
+
 void usage(const char *executableName)
 {
-    printf("Usage: %s -i <ip> -p <port> -n <num_packets>\n", executableName);
+    printf("Usage: %s -i <ip> -p <port> -n <num_packets> [-s <num_samples>] [-f <file> [-l]] [-r <rate>] [-x <speed>]\n", executableName);
+    printf("       [-T <threads>] [-b <batch>] [-R <pps> | -B <bps>] [-S <min:max:step>] [-d <seconds>] [-P <ms>] [-j]\n");
     printf("  ip: The IP address of the server.\n");
     printf("  port: The port number of the server. The port must be greater than 0\n");
-    printf("  num_packets: The number of packets to send. num_packets must be greater than 0\n");
+    printf("  num_packets: The number of packets to send (per sweep step, over all threads); 0 with -d: until the time runs out\n");
+    printf("  num_samples: I/Q samples per packet, 1 to %d (default %d, 1028-byte packets)\n", MAX_NUM_SAMPLES, DEFAULT_NUM_SAMPLES);
+    printf("  file: replay this IQ recording (int16 pairs) instead of a ramp; num_packets defaults to the whole file\n");
+    printf("  -l: loop the recording, forever with -n 0\n");
+    printf("  rate: send at this many samples/s (replay default: core:sample_rate of the .sigmf-meta, else %d;\n", DEFAULT_SAMPLE_RATE);
+    printf("        ramp default: as fast as possible)\n");
+    printf("  speed: replay speed factor, e.g. 2 for twice real time (default 1)\n");
+    printf("  threads: sender threads, each with its own socket and source port, 1 to %d (default 1)\n", MAX_THREADS);
+    printf("  batch: packets per sendmmsg() call, 1 to %d (default %d)\n", MAX_BATCH, DEFAULT_BATCH);
+    printf("  pps: target packets/s over all threads (overrides the sample rate)\n");
+    printf("  bps: target bits/s over all threads, UDP/IP headers included\n");
+    printf("  min:max:step: sweep the samples per packet, one step after the other\n");
+    printf("  seconds: length of each step (default: until num_packets are sent)\n");
+    printf("  ms: report interval (default %d)\n", DEFAULT_REPORT_MS);
+    printf("  -j: print the reports as JSON lines on stdout, everything else goes to stderr\n");
     exit(EXIT_FAILURE);
 }
-
@@ -52,6 +52,16 @@
 #define AXI4_STREAM_FIFO_RDFR_RESET_MASK 0x000000FF // Reset mask for receive data FIFO
 #define AXI4_STREAM_FIFO_RDFR_RESET_KEY  0x000000A5 // Reset key for receive data FIFO
 
+/**
+ * @brief polling of the FIFO, the sleep after each drain is derived from the
+ * measured fill rate so the FIFO is about FIFO_TARGET_FILL words full at the next poll
+ */
+#define FIFO_DEPTH              4096    // receive FIFO depth in words
+#define FIFO_TARGET_FILL        2048    // fill level to wake up at
+#define FIFO_HIGH_WATER         3072    // spin instead of sleeping above this occupancy
+#define FIFO_MIN_SLEEP_US       50      // shortest sleep
+#define FIFO_MAX_SLEEP_US       50000   // longest sleep (the old fixed interval)
+
 /* Function Prototype */
 
 // the below code uses a device called /dev/mem to get a pointer to a physical
@@ -118,6 +128,29 @@ unsigned int fifo_get_data(volatile unsigned int *axi_fifo_base)
     return axi_fifo_base[AXI4_STREAM_FIFO_RDFD_OFFSET/4];
 }
 
+/**
+ * @brief Work out how long to sleep before the next occupancy poll
+ * 
+ * @param fillRate measured fill rate in words per microsecond (0: unknown)
+ * @param polled words in the FIFO at the poll, before the drain
+ * @param occupancy words left in the FIFO after the drain
+ * @return unsigned int sleep time in microseconds, 0 to poll again right away
+ */
+unsigned int fifo_next_poll_us(double fillRate, unsigned int polled, unsigned int occupancy)
+{
+    if (polled >= FIFO_HIGH_WATER) {
+        return 0; // nearly full at the poll, the sleeps are not keeping up: spin
+    }
+    if (fillRate <= 0) {
+        return FIFO_MAX_SLEEP_US;
+    }
+    double us = (FIFO_TARGET_FILL > occupancy ? FIFO_TARGET_FILL - occupancy : 0) / fillRate;
+    if (us < FIFO_MIN_SLEEP_US) {
+        return FIFO_MIN_SLEEP_US;
+    }
+    return us > FIFO_MAX_SLEEP_US ? FIFO_MAX_SLEEP_US : (unsigned int)us;
+}
+
 // ----------------------------------------------------------------------------------------------------
 
 /**
@@ -228,7 +261,10 @@ int main(int argc, char const *argv[])
 
     unsigned int numSamplesRead = 0;
     unsigned int targetSamples  = 480000;
-    struct timespec start_time, end_time;
+    struct timespec start_time, end_time, poll_time;
+    unsigned int peakOccupancy  = 0;    // highest occupancy seen at a poll
+    unsigned int pollInterval   = 0;    // last chosen poll interval in us
+    unsigned int numPolls       = 0;    // number of occupancy polls
 
     fifo_reset(axi_fifo_base); // reset the FIFO
 
@@ -237,6 +273,12 @@ int main(int argc, char const *argv[])
     while(numSamplesRead < targetSamples)
     {
         unsigned int occupancy = fifo_get_current_occupancy(axi_fifo_base); // get the current occupancy of the FIFO 
+        unsigned int polled = occupancy; // the drain below counts occupancy down
+        numPolls++;
+        if(occupancy > peakOccupancy)
+        {
+            peakOccupancy = occupancy;
+        }
         while(occupancy > 0 && numSamplesRead < targetSamples) // read data from the FIFO until it is empty or we have read enough samples
         {
             fifo_get_data(axi_fifo_base);
@@ -247,13 +289,23 @@ int main(int argc, char const *argv[])
         {
             break; // exit the loop if we have read enough samples
         }
-        usleep(50000); // sleep for 50ms to avoid busy waiting
+        // average fill rate since the start, in words per microsecond
+        clock_gettime(CLOCK_MONOTONIC, &poll_time);
+        double elapsed_us = (poll_time.tv_sec - start_time.tv_sec) * 1e6 + (poll_time.tv_nsec - start_time.tv_nsec) / 1e3;
+        double fillRate = elapsed_us > 0 ? (numSamplesRead + occupancy) / elapsed_us : 0;
+        pollInterval = fifo_next_poll_us(fillRate, polled, occupancy);
+        if(pollInterval > 0)
+        {
+            usleep(pollInterval); // sleep until the FIFO should be FIFO_TARGET_FILL words full
+        }
     }
 
     clock_gettime(CLOCK_MONOTONIC, &end_time); // get the end time
     double elapsed_time = (end_time.tv_sec - start_time.tv_sec);
     elapsed_time += (end_time.tv_nsec - start_time.tv_nsec) / 1e9; // calculate the elapsed time in seconds
     printf("Elapsed time: %.9f seconds\n", elapsed_time);
+    printf("Occupancy polls: %u, last poll interval: %u us, peak occupancy: %u of %u words\n",
+           numPolls, pollInterval, peakOccupancy, FIFO_DEPTH);
 
     printf("I have read %u samples from the FIFO\n", numSamplesRead);
     printf("Disabling the radio tuner stream\r\n");
@@ -0,0 +1,474 @@
+/**
+ * @file axiFifo.c
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Access to the AXI4-Stream FIFO (PG080) receive path
+ * @details Every AXI-Lite read of RDFD is a separate bus transaction, so the
+ *          drain path reads as many words as it can per call: the word count
+ *          comes from the occupancy register (RDFO) or from the receive length
+ *          register (RLR), and the words are either read with an unrolled loop
+ *          or, when the bitstream exposes the AXI4 data interface, copied out
+ *          of the AXI4 window so the interconnect can issue burst reads.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* Include */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // ppoll
+#endif
+#include "axiFifo.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/mman.h>
+
+/**
+ * @brief Map `size` bytes of physical address space through /dev/mem
+ *
+ * @param phys_addr physical address (page aligned)
+ * @param size number of bytes to map
+ * @return volatile unsigned int* pointer to the mapping, NULL on failure
+ */
+static volatile unsigned int * map_physical(unsigned int phys_addr, size_t size)
+{
+    int mem_fd = open("/dev/mem", O_RDWR | O_SYNC);
+    if (mem_fd < 0) {
+        perror("Failed to open /dev/mem");
+        return NULL;
+    }
+    void *map_base = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, mem_fd, phys_addr);
+    if (map_base == MAP_FAILED) {
+        perror("mmap failed");
+        close(mem_fd);
+        return NULL;
+    }
+    close(mem_fd); // close the file descriptor after mapping
+    return (volatile unsigned int *)map_base;
+}
+
+// the below code uses a device called /dev/mem to get a pointer to a physical
+// address.  We will use this pointer to read/write the custom peripheral
+volatile unsigned int * get_a_pointer(unsigned int phys_addr)
+{
+    return map_physical(phys_addr, AXI_FIFO_MAP_SIZE);
+}
+
+/**
+ * @brief Get a pointer to the AXI FIFO base address in user space
+ *
+ * @return volatile unsigned int* Pointer to the AXI FIFO base address
+ */
+volatile unsigned int * get_pointer_to_axi_fifo()
+{
+    volatile unsigned int *axi_fifo_base = get_a_pointer(AXI4_STREAM_FIFO_BASE_ADDR);
+    if (axi_fifo_base == NULL) {
+        fprintf(stderr, "Failed to map AXI FIFO base address\n");
+        return NULL;
+    }
+    return axi_fifo_base;
+}
+
+void fifo_reset(volatile unsigned int *axi_fifo_base)
+{
+    // reset the FIFO by writing the reset key to the reset register
+    axi_fifo_base[AXI4_STREAM_FIFO_RDFR_OFFSET/4] = AXI4_STREAM_FIFO_RDFR_RESET_KEY;
+}
+
+unsigned int fifo_get_current_occupancy(volatile unsigned int *axi_fifo_base)
+{
+    // get the current occupancy of the FIFO by reading the occupancy register
+    unsigned int occupancy = axi_fifo_base[AXI4_STREAM_FIFO_RDFO_OFFSET/4];
+    //printf("FIFO occupancy: %u\n", occupancy); // print the occupancy for debugging
+    return occupancy;
+}
+
+unsigned int fifo_get_data(volatile unsigned int *axi_fifo_base)
+{
+    // get the data from the FIFO by reading the data register
+    return axi_fifo_base[AXI4_STREAM_FIFO_RDFD_OFFSET/4];
+}
+
+/**
+ * @brief Read the receive length register
+ * @details Reading RLR pops the length of the next received packet, so it must
+ *          be followed by exactly that many RDFD reads.
+ *
+ * @return unsigned int packet length in 32-bit words
+ */
+unsigned int fifo_get_packet_length(volatile unsigned int *axi_fifo_base)
+{
+    unsigned int bytes = axi_fifo_base[AXI4_STREAM_FIFO_RLR_OFFSET/4] & AXI4_STREAM_FIFO_RLR_LENGTH_MASK;
+    return bytes / 4;
+}
+
+/**
+ * @brief Read numWords words from RDFD with an unrolled loop
+ * @details The eight loads of each iteration are issued back to back into
+ *          registers before they are stored, so the core is not waiting on the
+ *          loop counter between AXI-Lite transactions.
+ */
+static inline __attribute__((always_inline))
+void fifo_read_burst_inline(volatile unsigned int *axi_fifo_base, uint32_t *dst, unsigned int numWords)
+{
+    volatile unsigned int *rdfd = &axi_fifo_base[AXI4_STREAM_FIFO_RDFD_OFFSET/4];
+    unsigned int i = 0;
+    for (; i + 8 <= numWords; i += 8) {
+        uint32_t d0 = *rdfd, d1 = *rdfd, d2 = *rdfd, d3 = *rdfd;
+        uint32_t d4 = *rdfd, d5 = *rdfd, d6 = *rdfd, d7 = *rdfd;
+        dst[i + 0] = d0; dst[i + 1] = d1; dst[i + 2] = d2; dst[i + 3] = d3;
+        dst[i + 4] = d4; dst[i + 5] = d5; dst[i + 6] = d6; dst[i + 7] = d7;
+    }
+    for (; i < numWords; i++) {
+        dst[i] = *rdfd; // remaining words
+    }
+}
+
+void fifo_read_burst(volatile unsigned int *axi_fifo_base, uint32_t *dst, unsigned int numWords)
+{
+    fifo_read_burst_inline(axi_fifo_base, dst, numWords);
+}
+
+/**
+ * @brief Copy numWords words out of the AXI4 data window
+ * @details The window is read through a non-volatile pointer so the compiler
+ *          is free to use multi-register loads, which the interconnect turns
+ *          into AXI burst reads. The barrier stops it from reusing values
+ *          across passes over the same window addresses.
+ */
+static inline __attribute__((always_inline))
+void fifo_read_axi4(volatile unsigned int *window, uint32_t *dst, unsigned int numWords)
+{
+    const uint32_t *src = (const uint32_t *)window;
+    while (numWords > 0) {
+        unsigned int chunk = numWords < AXI4_STREAM_FIFO_AXI4_WINDOW_WORDS ? numWords : AXI4_STREAM_FIFO_AXI4_WINDOW_WORDS;
+        unsigned int i = 0;
+        __asm__ __volatile__("" ::: "memory"); // every pass must hit the bus again
+        for (; i + 8 <= chunk; i += 8) {
+            dst[i + 0] = src[i + 0]; dst[i + 1] = src[i + 1]; dst[i + 2] = src[i + 2]; dst[i + 3] = src[i + 3];
+            dst[i + 4] = src[i + 4]; dst[i + 5] = src[i + 5]; dst[i + 6] = src[i + 6]; dst[i + 7] = src[i + 7];
+        }
+        for (; i < chunk; i++) {
+            dst[i] = src[i];
+        }
+        dst += chunk;
+        numWords -= chunk;
+    }
+}
+
+/**
+ * @brief Burst copy of numWords words through the AXI4 window or RDFD
+ * @details Always inlined, so a call with a constant count is compiled into a
+ *          fully unrolled copy without the remainder loop.
+ */
+static inline __attribute__((always_inline))
+void fifo_copy(axiFifo *fifo, uint32_t *dst, unsigned int numWords)
+{
+    if (fifo->data != NULL) {
+        fifo_read_axi4(fifo->data, dst, numWords);
+    } else {
+        fifo_read_burst_inline(fifo->regs, dst, numWords);
+    }
+}
+
+/**
+ * @brief Size of the first memory map of a UIO device
+ * @details Read from /sys/class/uio/uioN/maps/map0/size, one page if unknown.
+ */
+static size_t uio_map_size(const char *uioPath)
+{
+    const char *name = strrchr(uioPath, '/');
+    name = (name != NULL) ? name + 1 : uioPath;
+
+    char sysPath[128];
+    snprintf(sysPath, sizeof(sysPath), "/sys/class/uio/%s/maps/map0/size", name);
+    FILE *fp = fopen(sysPath, "r");
+    if (fp == NULL) {
+        return AXI_FIFO_MAP_SIZE;
+    }
+    unsigned long size = 0;
+    if (fscanf(fp, "%lx", &size) != 1 || size == 0) {
+        size = AXI_FIFO_MAP_SIZE;
+    }
+    fclose(fp);
+    return size;
+}
+
+/**
+ * @brief Map the FIFO registers through a UIO device and enable the receive interrupts
+ */
+static int uio_open(axiFifo *fifo, const char *uioPath)
+{
+    fifo->uioFd = open(uioPath, O_RDWR);
+    if (fifo->uioFd < 0) {
+        perror("Failed to open UIO device");
+        return -1;
+    }
+    fifo->regsSize = uio_map_size(uioPath);
+    void *map_base = mmap(0, fifo->regsSize, PROT_READ | PROT_WRITE, MAP_SHARED, fifo->uioFd, 0); // map0
+    if (map_base == MAP_FAILED) {
+        perror("UIO mmap failed");
+        close(fifo->uioFd);
+        fifo->uioFd = -1;
+        return -1;
+    }
+    fifo->regs = (volatile unsigned int *)map_base;
+    fifo->uioPath = uioPath;
+
+    // RFPF fires at the programmable-full level chosen when the IP was built, RC on a TLAST packet;
+    // neither follows the fill target, axiFifo_waitForData() times its sleep for that
+    fifo->regs[AXI4_STREAM_FIFO_ISR_OFFSET/4] = AXI4_STREAM_FIFO_INT_ALL;
+    fifo->regs[AXI4_STREAM_FIFO_IER_OFFSET/4] = AXI4_STREAM_FIFO_INT_RFPF | AXI4_STREAM_FIFO_INT_RC;
+    return 0;
+}
+
+/**
+ * @brief Map the FIFO registers (and the AXI4 data window if requested)
+ *
+ * @param fifo FIFO to open
+ * @param mode drain mode
+ * @param dataAddr physical base of the AXI4 data interface, 0 if not exposed
+ * @param uioPath UIO device bound to the FIFO, NULL to poll through /dev/mem
+ * @return int 0 on success, -1 on failure
+ */
+int axiFifo_open(axiFifo *fifo, fifoDrainMode mode, unsigned int dataAddr, const char *uioPath)
+{
+    memset(fifo, 0, sizeof(*fifo));
+    fifo->mode = mode;
+    fifo->uioFd = -1;
+    if (uioPath != NULL) {
+        if (uio_open(fifo, uioPath) != 0) {
+            return -1;
+        }
+    } else {
+        fifo->regs = get_pointer_to_axi_fifo();
+        fifo->regsSize = AXI_FIFO_MAP_SIZE;
+        if (fifo->regs == NULL) {
+            return -1;
+        }
+    }
+    if (dataAddr != 0) {
+        volatile unsigned int *data_base = map_physical(dataAddr, AXI4_STREAM_FIFO_AXI4_MAP_SIZE);
+        if (data_base == NULL) {
+            fprintf(stderr, "Failed to map AXI4 data interface at 0x%08x\n", dataAddr);
+            axiFifo_close(fifo);
+            return -1;
+        }
+        fifo->data = data_base + AXI4_STREAM_FIFO_AXI4_RDFD_OFFSET/4;
+    }
+    return 0;
+}
+
+/**
+ * @brief Unmap the FIFO
+ */
+void axiFifo_close(axiFifo *fifo)
+{
+    if (fifo->data != NULL) {
+        munmap((void *)(fifo->data - AXI4_STREAM_FIFO_AXI4_RDFD_OFFSET/4), AXI4_STREAM_FIFO_AXI4_MAP_SIZE);
+        fifo->data = NULL;
+    }
+    if (fifo->regs != NULL) {
+        if (fifo->uioFd >= 0) {
+            fifo->regs[AXI4_STREAM_FIFO_IER_OFFSET/4] = 0; // leave the interrupt disabled
+        }
+        munmap((void *)fifo->regs, fifo->regsSize);
+        fifo->regs = NULL;
+    }
+    if (fifo->uioFd >= 0) {
+        close(fifo->uioFd);
+        fifo->uioFd = -1;
+    }
+}
+
+/**
+ * @brief Read and clear the receive error bits of the ISR
+ * @details One AXI-Lite read per drain; the bits are kept in rxErrorBits so
+ *          the caller can tell where in the stream they showed up.
+ */
+static void take_rx_errors(axiFifo *fifo)
+{
+    uint32_t errors = fifo->regs[AXI4_STREAM_FIFO_ISR_OFFSET/4] & AXI4_STREAM_FIFO_INT_RX_ERRORS;
+    if (errors != 0) {
+        fifo->regs[AXI4_STREAM_FIFO_ISR_OFFSET/4] = errors; // write 1 to clear
+        fifo->rxErrorBits |= errors;
+    }
+}
+
+/**
+ * @brief Sleep on the UIO device until the FIFO interrupt fires
+ * @details The ISR is cleared before the interrupt is re-armed, otherwise the
+ *          level interrupt would fire again straight away. If the FIFO already
+ *          holds `threshold` words after re-arming there is no need to sleep.
+ *          The programmable-full level of PG080 is fixed when the IP is built
+ *          and a radio stream without TLAST never raises RC, so the sleep also
+ *          ends when the missing words should have arrived at `wordsPerSecond`.
+ *
+ * @param fifo FIFO opened with a UIO device
+ * @param threshold occupancy that counts as "data ready"
+ * @param wordsPerSecond rate the FIFO fills at
+ * @param timeoutMs longest wait in milliseconds
+ * @return int 1 if data is ready, 0 on timeout or signal, -1 on error
+ */
+int axiFifo_waitForData(axiFifo *fifo, unsigned int threshold, unsigned int wordsPerSecond, int timeoutMs)
+{
+    uint32_t irqOn = 1;
+    take_rx_errors(fifo); // keep the error bits, the next line clears them
+    fifo->regs[AXI4_STREAM_FIFO_ISR_OFFSET/4] = AXI4_STREAM_FIFO_INT_ALL; // clear old events
+    if (write(fifo->uioFd, &irqOn, sizeof(irqOn)) != sizeof(irqOn)) {      // re-enable the interrupt
+        perror("Failed to re-enable UIO interrupt");
+        return -1;
+    }
+    unsigned int occupancy = fifo_get_current_occupancy(fifo->regs);
+    if (occupancy >= threshold) {
+        return 1; // crossed the threshold before the interrupt was armed
+    }
+
+    uint64_t waitNs = (uint64_t)timeoutMs * 1000000ULL;
+    if (wordsPerSecond > 0) {
+        uint64_t fillNs = (uint64_t)(threshold - occupancy) * 1000000000ULL / wordsPerSecond;
+        if (fillNs < waitNs) {
+            waitNs = fillNs;
+        }
+    }
+    struct timespec wait = { .tv_sec = (time_t)(waitNs / 1000000000ULL), .tv_nsec = (long)(waitNs % 1000000000ULL) };
+    struct pollfd pfd = { .fd = fifo->uioFd, .events = POLLIN };
+    fifo->irqWaits++;
+    int rc = ppoll(&pfd, 1, &wait, NULL);
+    if (rc < 0) {
+        return (errno == EINTR) ? 0 : -1;
+    }
+    if (rc == 0) {
+        fifo->irqTimeouts++;
+        return 0;
+    }
+
+    uint32_t irqCount;
+    if (read(fifo->uioFd, &irqCount, sizeof(irqCount)) != sizeof(irqCount)) {
+        perror("Failed to read UIO interrupt count");
+        return -1;
+    }
+    fifo->irqWakeups++;
+    return 1;
+}
+
+/**
+ * @brief Read up to maxWords words from the FIFO straight into dst
+ *
+ * @param fifo FIFO
+ * @param dst destination (usually the packet payload)
+ * @param maxWords room left in dst
+ * @return unsigned int number of words read (0 if the FIFO is empty)
+ */
+unsigned int axiFifo_drain(axiFifo *fifo, uint32_t *dst, unsigned int maxWords)
+{
+    unsigned int available = fifo_get_current_occupancy(fifo->regs);
+    fifo->lastOccupancy = available; // kept for the poll pacing
+
+    if (fifo->mode == FIFO_DRAIN_RLR && available > 0) {
+        if (fifo->rlrRemaining == 0) {
+            fifo->rlrRemaining = fifo_get_packet_length(fifo->regs); // start the next received packet
+        }
+        available = fifo->rlrRemaining < available ? fifo->rlrRemaining : available;
+    }
+
+    unsigned int numWords = available < maxWords ? available : maxWords;
+    if (numWords == 0) {
+        fifo->lastDrainNs = 0;
+        take_rx_errors(fifo);
+        return 0;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if (fifo->mode == FIFO_DRAIN_WORD) {
+        for (unsigned int i = 0; i < numWords; i++) {
+            dst[i] = fifo_get_data(fifo->regs); // one call per word
+        }
+    } else {
+        // whole packets of the common sizes get a copy with the count known at compile time
+        switch (numWords) {
+            case AXI_FIFO_FAST_PATH_1: fifo_copy(fifo, dst, AXI_FIFO_FAST_PATH_1); break;
+            case AXI_FIFO_FAST_PATH_2: fifo_copy(fifo, dst, AXI_FIFO_FAST_PATH_2); break;
+            case AXI_FIFO_FAST_PATH_3: fifo_copy(fifo, dst, AXI_FIFO_FAST_PATH_3); break;
+            case AXI_FIFO_FAST_PATH_4: fifo_copy(fifo, dst, AXI_FIFO_FAST_PATH_4); break;
+            case AXI_FIFO_FAST_PATH_5: fifo_copy(fifo, dst, AXI_FIFO_FAST_PATH_5); break;
+            case AXI_FIFO_FAST_PATH_6: fifo_copy(fifo, dst, AXI_FIFO_FAST_PATH_6); break;
+            default:                   fifo_copy(fifo, dst, numWords); break;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    fifo->lastDrainNs = (uint64_t)(end.tv_sec - start.tv_sec) * 1000000000ull + (end.tv_nsec - start.tv_nsec);
+    fifo->drainNs += fifo->lastDrainNs;
+    fifo->wordsDrained += numWords;
+    fifo->drainCalls++;
+    if (fifo->mode == FIFO_DRAIN_RLR) {
+        fifo->rlrRemaining -= numWords;
+    }
+    take_rx_errors(fifo); // after the reads, so errors they caused show up now
+
+    return numWords;
+}
+
+/**
+ * @brief Parse a drain mode name (word, burst, rlr)
+ *
+ * @return int 0 on success, -1 if the name is unknown
+ */
+int axiFifo_parseDrainMode(const char *name, fifoDrainMode *mode)
+{
+    if (strcmp(name, "word") == 0) {
+        *mode = FIFO_DRAIN_WORD;
+    } else if (strcmp(name, "burst") == 0) {
+        *mode = FIFO_DRAIN_BURST;
+    } else if (strcmp(name, "rlr") == 0) {
+        *mode = FIFO_DRAIN_RLR;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Human readable drain mode name
+ */
+const char *axiFifo_drainModeName(fifoDrainMode mode)
+{
+    switch (mode) {
+        case FIFO_DRAIN_WORD:  return "word";
+        case FIFO_DRAIN_BURST: return "burst";
+        case FIFO_DRAIN_RLR:   return "rlr";
+        default:               return "unknown";
+    }
+}
+
+/**
+ * @brief Print the drain counters
+ *
+ * @param fifo FIFO
+ * @param elapsedSeconds wall time the FIFO was being drained
+ */
+void axiFifo_printStats(const axiFifo *fifo, double elapsedSeconds)
+{
+    double drainSeconds = fifo->drainNs / 1e9;
+    printf("FIFO drain summary (%s%s, %s backend):\n", axiFifo_drainModeName(fifo->mode),
+           fifo->data != NULL ? ", AXI4 data window" : "", fifo->uioFd >= 0 ? "UIO interrupt" : "/dev/mem polling");
+    printf("    Words drained: %llu\n", (unsigned long long)fifo->wordsDrained);
+    printf("    Drain calls: %llu (%.1f words/call)\n", (unsigned long long)fifo->drainCalls,
+           fifo->drainCalls ? (double)fifo->wordsDrained / fifo->drainCalls : 0.0);
+    printf("    Bus read rate: %.0f words/s\n", drainSeconds > 0 ? fifo->wordsDrained / drainSeconds : 0.0);
+    printf("    Stream rate: %.0f words/s\n", elapsedSeconds > 0 ? fifo->wordsDrained / elapsedSeconds : 0.0);
+    if (fifo->uioFd >= 0) {
+        printf("    Interrupt waits: %llu (%llu interrupts, %llu timed wake-ups)\n", (unsigned long long)fifo->irqWaits,
+               (unsigned long long)fifo->irqWakeups, (unsigned long long)fifo->irqTimeouts);
+    }
+}
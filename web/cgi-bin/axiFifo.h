@@ -0,0 +1,126 @@
+/**
+ * @file axiFifo.h
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Access to the AXI4-Stream FIFO (PG080) receive path
+ * @details Register definitions and the drain helpers shared by both UDP FIFO
+ *          streamers.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef _AXI_FIFO_H_
+#define _AXI_FIFO_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief The transmit path of the IP core is not enabled.
+ * PS is not able to transmit data to PL.
+ */
+#define AXI4_STREAM_FIFO_BASE_ADDR       0x43c10000 // Base address of the AXI FIFO
+
+// refer to AXI4-Stream FIFO LogiCORE IP Product Guide (PG080)
+// https://docs.amd.com/r/en-US/pg080-axi-fifo-mm-s/Register-Space
+#define AXI4_STREAM_FIFO_ISR_OFFSET      0x00 // Interrupt status register (write 1 to clear)
+#define AXI4_STREAM_FIFO_IER_OFFSET      0x04 // Interrupt enable register
+#define AXI4_STREAM_FIFO_RDFR_OFFSET     0x18 // Receive data FIFO reset offset
+#define AXI4_STREAM_FIFO_RDFO_OFFSET     0x1C // Receive data FIFO occupancy offset
+#define AXI4_STREAM_FIFO_RDFD_OFFSET     0x20 // Receive data FIFO data offset
+#define AXI4_STREAM_FIFO_RLR_OFFSET      0x24 // Receive Length offset
+
+#define AXI4_STREAM_FIFO_RDFR_RESET_MASK 0x000000FF // Reset mask for receive data FIFO
+#define AXI4_STREAM_FIFO_RDFR_RESET_KEY  0x000000A5 // Reset key for receive data FIFO
+
+#define AXI4_STREAM_FIFO_RLR_LENGTH_MASK 0x007FFFFF // Receive length in bytes (bits 22:0)
+
+#define AXI4_STREAM_FIFO_INT_RPURE       0x80000000 // Receive packet underrun read error
+#define AXI4_STREAM_FIFO_INT_RPORE       0x40000000 // Receive packet overrun read error
+#define AXI4_STREAM_FIFO_INT_RPUE        0x20000000 // Receive packet underrun error
+#define AXI4_STREAM_FIFO_INT_RX_ERRORS   0xE0000000 // Every receive error bit (reads the FIFO could not serve)
+#define AXI4_STREAM_FIFO_INT_RC          0x04000000 // Receive complete (a TLAST packet is available)
+#define AXI4_STREAM_FIFO_INT_RFPF        0x00100000 // Receive FIFO programmable full (level fixed in the IP)
+#define AXI4_STREAM_FIFO_INT_ALL         0xFFFFFFFF // Every status bit, used to clear the ISR
+
+#define AXI_FIFO_IRQ_TIMEOUT_MS          20     // Longest UIO wait, keeps shutdown responsive
+
+/**
+ * @brief AXI4 (full) data interface, only present when the IP is built with
+ * "AXI4 Data Interface" enabled. Reads anywhere in the window pop the receive
+ * data FIFO, so a plain block copy turns into AXI burst reads.
+ */
+#define AXI4_STREAM_FIFO_AXI4_RDFD_OFFSET 0x1000 // Receive data window inside the AXI4 data space
+#define AXI4_STREAM_FIFO_AXI4_MAP_SIZE    0x2000 // Bytes to map for the AXI4 data space
+#define AXI4_STREAM_FIFO_AXI4_WINDOW_WORDS 1024  // Words readable in one pass over the window
+
+#define AXI_FIFO_MAP_SIZE                4096   // Bytes mapped for the AXI-Lite register space
+
+/**
+ * @brief Drain sizes with a compile-time specialized copy: the payload sizes
+ * (in words) of the common streamer packets
+ */
+#define AXI_FIFO_FAST_PATH_1             256    // default packet
+#define AXI_FIFO_FAST_PATH_2             356    // largest packet in a 1500-byte MTU (48-byte header)
+#define AXI_FIFO_FAST_PATH_3             367    // largest packet in a 1500-byte MTU (legacy header)
+#define AXI_FIFO_FAST_PATH_4             1024
+#define AXI_FIFO_FAST_PATH_5             2231   // largest packet in a 9000-byte (jumbo) MTU (48-byte header)
+#define AXI_FIFO_FAST_PATH_6             2242   // largest packet in a 9000-byte (jumbo) MTU (legacy header)
+
+/**
+ * @brief How the receive FIFO is drained
+ */
+typedef enum fifoDrainMode
+{
+    FIFO_DRAIN_WORD = 0,    // one fifo_get_data() call per word (original behaviour)
+    FIFO_DRAIN_BURST,       // unrolled multi-word reads sized by the occupancy register
+    FIFO_DRAIN_RLR          // unrolled multi-word reads sized by the receive length register
+} fifoDrainMode;
+
+/**
+ * @brief Receive side of the AXI4-Stream FIFO
+ * @details The registers are mapped either through /dev/mem (the reader polls
+ *          the occupancy) or through a UIO device bound to the FIFO (the
+ *          reader sleeps on the UIO fd until the FIFO raises its receive
+ *          interrupts).
+ */
+typedef struct axiFifo
+{
+    volatile unsigned int *regs;    // AXI-Lite register space
+    size_t regsSize;                // bytes mapped for regs
+    int uioFd;                      // UIO device, -1 for the /dev/mem backend
+    const char *uioPath;            // UIO device path (for reporting)
+    volatile unsigned int *data;    // AXI4 data window, NULL when the bitstream does not expose it
+    fifoDrainMode mode;             // drain mode
+    unsigned int rlrRemaining;      // words left of the packet announced by RLR
+    unsigned int lastOccupancy;     // occupancy read by the last drain call
+    uint64_t wordsDrained;          // total words read from the FIFO
+    uint64_t drainCalls;            // drain calls that moved at least one word
+    uint64_t drainNs;               // time spent inside those drain calls
+    uint64_t lastDrainNs;           // time the last drain call spent copying (0: it moved nothing)
+    uint32_t rxErrorBits;           // receive error bits found in the ISR, until fifoLoss takes them
+    uint64_t irqWaits;              // times the reader slept on the UIO fd
+    uint64_t irqWakeups;            // wake-ups caused by a FIFO interrupt
+    uint64_t irqTimeouts;           // waits that ended without an interrupt
+} axiFifo;
+
+/**  Function Prototype */
+volatile unsigned int * get_a_pointer(unsigned int phys_addr);
+volatile unsigned int * get_pointer_to_axi_fifo();
+void fifo_reset(volatile unsigned int *axi_fifo_base);
+unsigned int fifo_get_current_occupancy(volatile unsigned int *axi_fifo_base);
+unsigned int fifo_get_data(volatile unsigned int *axi_fifo_base);
+unsigned int fifo_get_packet_length(volatile unsigned int *axi_fifo_base);
+void fifo_read_burst(volatile unsigned int *axi_fifo_base, uint32_t *dst, unsigned int numWords);
+
+int axiFifo_open(axiFifo *fifo, fifoDrainMode mode, unsigned int dataAddr, const char *uioPath);
+void axiFifo_close(axiFifo *fifo);
+int axiFifo_waitForData(axiFifo *fifo, unsigned int threshold, unsigned int wordsPerSecond, int timeoutMs);
+unsigned int axiFifo_drain(axiFifo *fifo, uint32_t *dst, unsigned int maxWords);
+int axiFifo_parseDrainMode(const char *name, fifoDrainMode *mode);
+const char *axiFifo_drainModeName(fifoDrainMode mode);
+void axiFifo_printStats(const axiFifo *fifo, double elapsedSeconds);
+
+#endif /* _AXI_FIFO_H_ */
@@ -5,7 +5,8 @@
  * @details this program is generated by transfer the python script to C code
  *          to configure the radio tuner and set the ADC frequency, else well
  *          set the stream enable bit in the control register to enable the 
- *          radio tuner stream
+ *          radio tuner stream. The registers belong to radioDaemon, this
+ *          program sends it the whole setting as one batched request.
  * @date 2025-04-26
  * 
  * @copyright Copyright (c) 2025
@@ -17,36 +18,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
-#include <fcntl.h>
-#include <unistd.h>
-#include <sys/mman.h>
-
-/* Definitions */
-/** 
- * @brief definition of the radio tuner peripheral
- */
-#define RADIO_PERIPH_ADDRESS 0x43c00000
-#define RADIO_TUNER_FAKE_ADC_PINC_OFFSET    0
-#define RADIO_TUNER_TUNER_PINC_OFFSET       1
-#define RADIO_TUNER_CONTROL_REG_OFFSET      2
-#define RADIO_TUNER_TIMER_REG_OFFSET        3
-#define RADIO_TUNER_CTRL_RESET_MASK         0x00000001 // mask for reset bit in the control register
-#define RADIO_TUNER_CTRL_RESET_ON           0x1         // reset on value for the control register
-#define RADIO_TUNER_CTRL_RESET_OFF          0x0         // reset off value for the control register
-#define RADIO_TUNER_CTRL_STREAM_EN_MASK     0x00000002 // mask for stream enable bit in the control register
-#define RADIO_TUNER_CTRL_STREAM_EN_ON       0x1         // stream enable on value for the control register
-#define RADIO_TUNER_CTRL_STREAM_EN_OFF      0x0         // stream enable off value for the control register
-
 
+#include "radioClient.h"
 
 /* Function Prototypes */
-volatile unsigned int * get_a_pointer(unsigned int phys_addr);
-volatile unsigned int * get_radio_tuner();
-void disable_radio_tuner(volatile unsigned int *radio_base);
-void enable_radio_tuner(volatile unsigned int *radio_base);
-void set_radio_tuner_stream(volatile unsigned int *radio_base, int enable);
-void radioTuner_setMixerFreq(volatile unsigned int *ptrToRadio, float tune_frequency);
-void radioTuner_setAdcFreq(volatile unsigned int* ptrToRadio, float freq);
 void cgi_callback(void);
 
 /* Global Variables */
@@ -58,22 +33,23 @@ int main(void)
 {
     cgi_callback(); // call the cgi callback function to handle the request
 
-    // get a pointer to the radio tuner peripheral
-    volatile unsigned int *radio_base = get_radio_tuner();
-    if (radio_base == NULL) {
-        fprintf(stderr, "Failed to get radio tuner base address\n");
-        return -1;
+    // run the tuner, then tune, set the ADC and the stream enable bit in one request
+    char request[RADIO_DAEMON_MSG_MAX];
+    char reply[RADIO_DAEMON_MSG_MAX];
+    double roundTripUs = 0;
+    snprintf(request, sizeof(request), "RESET 0\nTUNE %.3f\nADC %.3f\nSTREAM %d\n", tune_freq, adc_freq,
+             stream_en == 1);
+    int rc = radioClient_request(NULL, request, reply, sizeof(reply), &roundTripUs);
+    if (rc != 0) {
+        printf("<p>Radio daemon not running, press Initialize PL/Radio first</p>\n");
+    } else {
+        printf("<pre>%s</pre>\n", reply); // per-command latency in us
+        printf("<p>Round trip: %.0f us</p>\n", roundTripUs);
     }
 
-    enable_radio_tuner(radio_base); // enable the radio tuner
-    radioTuner_setMixerFreq(radio_base, tune_freq); // set the mixer frequency
-    radioTuner_setAdcFreq(radio_base, adc_freq); // set the ADC frequency
-    set_radio_tuner_stream(radio_base, stream_en); // set the stream enable bit in the control register
-
-    munmap((void *)radio_base, 4096); // unmap the radio tuner base address
-
-    return 0;
-
+    printf("</body>\n");
+    printf("</html>\n");
+    return rc == 0 ? 0 : -1;
 }
 
 void cgi_callback(void)
@@ -129,109 +105,4 @@ void cgi_callback(void)
     }
 
     printf("</h3>");
-    printf("</body>\n");
-    printf("</html>\n");
-}
-
-
-/**
- * @brief Get a pointer to the radio tuner base address in user space
- * 
- * @return volatile unsigned int* Pointer to the radio tuner base address
- */
-volatile unsigned int * get_radio_tuner()
-{
-    volatile unsigned int *radio_base = get_a_pointer(RADIO_PERIPH_ADDRESS);
-    if (radio_base == NULL) {
-        fprintf(stderr, "Failed to map radio tuner base address\n");
-        return NULL;
-    }
-    return radio_base;
-}
-
-/**
- * @brief disable the radio tuner
- * 
- * @param radio_base 
- */
-void disable_radio_tuner(volatile unsigned int *radio_base)
-{
-    // disable the radio tuner by writing 1 to the reset bit in the control register
-    *(radio_base + RADIO_TUNER_CONTROL_REG_OFFSET) |= RADIO_TUNER_CTRL_RESET_MASK;
-    //print_reg(radio_base, RADIO_TUNER_CONTROL_REG_OFFSET);
-}
-
-/**
- * @brief enable the radio tuner
- * 
- * @param radio_base 
- */
-void enable_radio_tuner(volatile unsigned int *radio_base)
-{
-    // enable the radio tuner by writing 0 to the reset bit in the control register
-    *(radio_base + RADIO_TUNER_CONTROL_REG_OFFSET) &= ~RADIO_TUNER_CTRL_RESET_MASK;
-    //print_reg(radio_base, RADIO_TUNER_CONTROL_REG_OFFSET);
-}
-
-/**
- * @brief Control the radio tuner stream flow
- * 
- * @param radio_base 
- * @param enable 
- */
-void set_radio_tuner_stream(volatile unsigned int *radio_base, int enable)
-{
-    if (enable) {
-        // enable the radio tuner stream by writing 1 to the stream enable bit in the control register
-        *(radio_base + RADIO_TUNER_CONTROL_REG_OFFSET) |= RADIO_TUNER_CTRL_STREAM_EN_MASK;
-    } else {
-        // disable the radio tuner stream by writing 0 to the stream enable bit in the control register
-        *(radio_base + RADIO_TUNER_CONTROL_REG_OFFSET) &= ~RADIO_TUNER_CTRL_STREAM_EN_MASK;
-    }
-    //print_reg(radio_base, RADIO_TUNER_CONTROL_REG_OFFSET);
-}
-
-/**
- * @brief Set the mixer frequency of the radio tuner
- * 
- * @param ptrToRadio Pointer to the radio tuner base address
- * @param tune_frequency Frequency to set in MHz
- */
-void radioTuner_setMixerFreq(volatile unsigned int *ptrToRadio, float tune_frequency)
-{
-	float pinc = tune_frequency*(float)(1<<27)/125.0e6;
-	*(ptrToRadio+RADIO_TUNER_TUNER_PINC_OFFSET)=(int)pinc;
-}
-
-/**
- * @brief Set the ADC frequency of the radio tuner
- * 
- * @param ptrToRadio Pointer to the radio tuner base address
- * @param freq Frequency to set in MHz
- */
-void radioTuner_setAdcFreq(volatile unsigned int* ptrToRadio, float freq)
-{
-	float pinc = freq*(float)(1<<27)/125.0e6;
-	*(ptrToRadio+RADIO_TUNER_FAKE_ADC_PINC_OFFSET) = (int)pinc;
 }
-
-// the below code uses a device called /dev/mem to get a pointer to a physical
-// address.  We will use this pointer to read/write the custom peripheral
-volatile unsigned int * get_a_pointer(unsigned int phys_addr)
-{
-
-	int mem_fd = open("/dev/mem", O_RDWR | O_SYNC); 
-    if (mem_fd < 0) {
-        perror("Failed to open /dev/mem");
-        return NULL;
-    }
-	void *map_base = mmap(0, 4096, PROT_READ | PROT_WRITE, MAP_SHARED, mem_fd, phys_addr); 
-    if (map_base == MAP_FAILED) {
-        perror("mmap failed");
-        close(mem_fd);
-        return NULL;
-    }
-	volatile unsigned int *radio_base = (volatile unsigned int *)map_base; 
-    close(mem_fd); // close the file descriptor after mapping
-	return (radio_base);
-}
\ No newline at end of file
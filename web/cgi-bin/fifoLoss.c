@@ -0,0 +1,153 @@
+/**
+ * @file fifoLoss.c
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Overflow and read-error detection on the AXI4-Stream FIFO
+ * @details See fifoLoss.h. The check runs after every poll on numbers the
+ *          reader has anyway (occupancy, words drained, the pacer's time
+ *          stamp); only the ISR read in axiFifo_drain() touches the bus.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* Include */
+#include "fifoLoss.h"
+
+#include <stdio.h>
+
+static uint64_t to_ns(const struct timespec *ts)
+{
+    return (uint64_t)ts->tv_sec * 1000000000ull + ts->tv_nsec;
+}
+
+/**
+ * @brief Remember where the stream breaks, for the packet that holds that word
+ */
+static void add_gap(fifoLoss *loss, uint64_t word)
+{
+    if (loss->numGaps == FIFO_LOSS_MAX_GAPS) {
+        return; // the earlier gaps still get their packets flagged
+    }
+    loss->gaps[loss->numGaps++] = word;
+}
+
+/**
+ * @brief Close the minutes that went by and add the events to the current one
+ */
+static void count_minute(fifoLoss *loss, uint64_t nowNs, unsigned int events)
+{
+    if (loss->minuteStartNs == 0) {
+        loss->minuteStartNs = nowNs;
+    }
+    while (nowNs - loss->minuteStartNs >= FIFO_LOSS_MINUTE_NS) {
+        loss->lastMinuteEvents = loss->minuteEvents;
+        if (loss->minuteEvents > loss->worstMinuteEvents) {
+            loss->worstMinuteEvents = loss->minuteEvents;
+        }
+        if (loss->minuteEvents > 0) {
+            loss->minutesWithEvents++;
+        }
+        loss->minutes++;
+        loss->minuteEvents = 0;
+        loss->minuteStartNs += FIFO_LOSS_MINUTE_NS;
+    }
+    loss->minuteEvents += events;
+}
+
+/**
+ * @brief Initialize the detector
+ *
+ * @param loss detector
+ * @param depth FIFO depth in words
+ * @param sampleRate words per second the radio writes into the FIFO
+ */
+void fifoLoss_init(fifoLoss *loss, unsigned int depth, unsigned int sampleRate)
+{
+    *loss = (fifoLoss){0};
+    loss->depth = depth;
+    loss->wordsPerNs = sampleRate / 1e9;
+}
+
+/**
+ * @brief Check one poll for lost samples and read errors
+ *
+ * @param loss detector
+ * @param fifo FIFO after the drain of this poll, its error bits are taken
+ * @param drained words read at this poll
+ * @param now CLOCK_MONOTONIC time of this poll (the pacer's)
+ * @return true an overflow or a read error was found at this poll
+ */
+bool fifoLoss_update(fifoLoss *loss, axiFifo *fifo, unsigned int drained, const struct timespec *now)
+{
+    unsigned int occupancy = fifo->lastOccupancy;
+    unsigned int events = 0;
+    if (loss->started && occupancy + FIFO_LOSS_FULL_SLACK >= loss->depth) {
+        // full: the radio was held off, what it produced in the meantime is gone
+        double expected = (to_ns(now) - to_ns(&loss->lastPoll)) * loss->wordsPerNs;
+        unsigned int arrived = occupancy > loss->residual ? occupancy - loss->residual : 0;
+        if (expected > arrived + FIFO_LOSS_TOLERANCE) {
+            loss->overflows++;
+            loss->lostSamples += (uint64_t)(expected - arrived + 0.5);
+            add_gap(loss, fifo->wordsDrained - drained + occupancy); // right after what the FIFO held
+            events++;
+        }
+    }
+    if (fifo->rxErrorBits != 0) {
+        // the words read around the error cannot be trusted
+        loss->readErrors++;
+        loss->errorBits |= fifo->rxErrorBits;
+        fifo->rxErrorBits = 0;
+        add_gap(loss, fifo->wordsDrained > 0 ? fifo->wordsDrained - 1 : 0);
+        events++;
+    }
+
+    loss->residual = occupancy > drained ? occupancy - drained : 0;
+    loss->lastPoll = *now;
+    loss->started = true;
+    count_minute(loss, to_ns(now), events);
+    return events > 0;
+}
+
+/**
+ * @brief A packet was completed, does it hold a gap
+ *
+ * @param loss detector
+ * @param wordsDrained FIFO words drained so far, the packet ends with the last of them
+ * @return true flag the packet as a discontinuity
+ */
+bool fifoLoss_packetDone(fifoLoss *loss, uint64_t wordsDrained)
+{
+    unsigned int done = 0;
+    while (done < loss->numGaps && loss->gaps[done] < wordsDrained) {
+        done++;
+    }
+    if (done == 0) {
+        return false;
+    }
+    for (unsigned int i = done; i < loss->numGaps; i++) {
+        loss->gaps[i - done] = loss->gaps[i];
+    }
+    loss->numGaps -= done;
+    loss->flaggedPackets++;
+    return true;
+}
+
+/**
+ * @brief Print the loss statistics
+ */
+void fifoLoss_printStats(const fifoLoss *loss, double elapsedSeconds)
+{
+    uint64_t events = loss->overflows + loss->readErrors;
+    uint64_t worst = loss->minuteEvents > loss->worstMinuteEvents ? loss->minuteEvents : loss->worstMinuteEvents;
+    printf("FIFO loss summary:\n");
+    printf("    Overflows: %llu (%llu samples lost)\n", (unsigned long long)loss->overflows,
+           (unsigned long long)loss->lostSamples);
+    printf("    Read errors: %llu (ISR bits 0x%08x)\n", (unsigned long long)loss->readErrors, loss->errorBits);
+    printf("    Discontinuities: %llu packets flagged\n", (unsigned long long)loss->flaggedPackets);
+    printf("    Events per minute: mean %.2f, worst %llu, last %llu (%llu of %llu minutes with events)\n",
+           elapsedSeconds > 0 ? events * 60.0 / elapsedSeconds : 0.0, (unsigned long long)worst,
+           (unsigned long long)loss->lastMinuteEvents, (unsigned long long)loss->minutesWithEvents,
+           (unsigned long long)loss->minutes);
+}
@@ -0,0 +1,70 @@
+/**
+ * @file fifoLoss.h
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Overflow and read-error detection on the AXI4-Stream FIFO
+ * @details The receive side of PG080 has no overflow status: a full FIFO
+ *          deasserts TREADY and whatever the radio produces meanwhile is lost
+ *          upstream. A poll that finds the FIFO full is therefore checked
+ *          against the sample clock: the words that should have arrived since
+ *          the last poll minus the words that did are the lost samples. The
+ *          read errors the core does flag in its ISR (RPURE, RPORE, RPUE) are
+ *          read and cleared by axiFifo_drain() on every drain.
+ *
+ *          Each event leaves a gap at a known FIFO word index, right after
+ *          the words that were in the FIFO when it was found. The packet that
+ *          holds that word is flagged SDR_FLAG_DISCONTINUITY.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef _FIFO_LOSS_H_
+#define _FIFO_LOSS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "axiFifo.h"
+
+#define FIFO_LOSS_FULL_SLACK    8       // occupancy this close to the depth counts as full
+#define FIFO_LOSS_TOLERANCE     8       // missing words within this are timing noise, not loss
+#define FIFO_LOSS_MAX_GAPS      32      // gaps waiting for their packet (further ones go unflagged)
+#define FIFO_LOSS_MINUTE_NS     60000000000ull
+
+/**
+ * @brief Loss detector state (owned by the reader thread)
+ */
+typedef struct fifoLoss
+{
+    unsigned int depth;             // FIFO depth in words
+    double wordsPerNs;              // rate the radio fills the FIFO at
+    unsigned int residual;          // words left in the FIFO after the last drain
+    struct timespec lastPoll;       // time of the last poll
+    bool started;                   // lastPoll is valid
+    uint64_t gaps[FIFO_LOSS_MAX_GAPS]; // FIFO word index of each gap not yet in a packet, oldest first
+    unsigned int numGaps;           // entries in gaps
+
+    // statistics
+    uint64_t overflows;             // polls that found the FIFO full and words missing
+    uint64_t lostSamples;           // words the radio produced that never reached the FIFO
+    uint64_t readErrors;            // drains that found an ISR read error bit
+    uint32_t errorBits;             // every ISR error bit seen
+    uint64_t flaggedPackets;        // packets marked with a discontinuity
+    uint64_t minuteStartNs;         // start of the current minute (CLOCK_MONOTONIC)
+    uint64_t minuteEvents;          // events in the current minute
+    uint64_t lastMinuteEvents;      // events in the last full minute
+    uint64_t worstMinuteEvents;     // most events in one minute
+    uint64_t minutes;               // full minutes counted
+    uint64_t minutesWithEvents;     // of those, minutes with at least one event
+} fifoLoss;
+
+/**  Function Prototype */
+void fifoLoss_init(fifoLoss *loss, unsigned int depth, unsigned int sampleRate);
+bool fifoLoss_update(fifoLoss *loss, axiFifo *fifo, unsigned int drained, const struct timespec *now);
+bool fifoLoss_packetDone(fifoLoss *loss, uint64_t wordsDrained);
+void fifoLoss_printStats(const fifoLoss *loss, double elapsedSeconds);
+
+#endif /* _FIFO_LOSS_H_ */
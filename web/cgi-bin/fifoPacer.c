@@ -0,0 +1,141 @@
+/**
+ * @file fifoPacer.c
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Occupancy-driven polling of the AXI4-Stream FIFO
+ * @details The fill rate is estimated from consecutive occupancy readings:
+ *          the words that arrived since the last poll are the current
+ *          occupancy minus what was left behind by the last drain.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* Include */
+#include "fifoPacer.h"
+
+#include <stdio.h>
+
+/**
+ * @brief Initialize the pacer
+ *
+ * @param pacer pacer
+ * @param depth FIFO depth in words
+ * @param target fill level (words) the reader should wake up at
+ */
+void fifoPacer_init(fifoPacer *pacer, unsigned int depth, unsigned int target)
+{
+    *pacer = (fifoPacer){0};
+    pacer->depth = depth;
+    pacer->highWater = FIFO_PACER_HIGH_WATER(depth);
+    pacer->target = target < pacer->highWater ? target : pacer->highWater / 2;
+}
+
+/**
+ * @brief Move the target fill level, keeping the measured fill rate
+ */
+void fifoPacer_setTarget(fifoPacer *pacer, unsigned int target)
+{
+    pacer->target = target < pacer->highWater ? target : pacer->highWater / 2;
+}
+
+/**
+ * @brief Record one poll of the FIFO
+ *
+ * @param pacer pacer
+ * @param occupancy occupancy read at this poll
+ * @param drained words read from the FIFO at this poll
+ */
+void fifoPacer_update(fifoPacer *pacer, unsigned int occupancy, unsigned int drained)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if (pacer->started) {
+        uint64_t elapsedNs = (uint64_t)(now.tv_sec - pacer->lastPoll.tv_sec) * 1000000000ull
+                           + (now.tv_nsec - pacer->lastPoll.tv_nsec);
+        unsigned int arrived = occupancy > pacer->residual ? occupancy - pacer->residual : 0;
+        pacer->windowWords += arrived;
+        pacer->windowNs += elapsedNs;
+        if (pacer->windowNs >= FIFO_PACER_RATE_WINDOW_NS) {
+            double rate = pacer->windowWords * 1000.0 / pacer->windowNs; // words per microsecond
+            // exponential average, new window weighted 1/4
+            pacer->fillRate = (pacer->fillRate == 0) ? rate : pacer->fillRate + (rate - pacer->fillRate) / 4;
+            pacer->windowWords = 0;
+            pacer->windowNs = 0;
+        }
+    }
+    pacer->lastPoll = now;
+    pacer->started = 1;
+
+    // wake-up latency: how long ago the FIFO crossed the target fill level
+    if (occupancy > pacer->target && pacer->fillRate > 0) {
+        double lateUs = (occupancy - pacer->target) / pacer->fillRate;
+        pacer->lateWakeups++;
+        pacer->lateUsTotal += lateUs;
+        if (lateUs > pacer->lateUsMax) {
+            pacer->lateUsMax = lateUs;
+        }
+    }
+
+    pacer->polled = occupancy;
+    pacer->residual = occupancy > drained ? occupancy - drained : 0;
+    if (occupancy > pacer->peakOccupancy) {
+        pacer->peakOccupancy = occupancy;
+    }
+    pacer->polls++;
+}
+
+/**
+ * @brief Sleep until the FIFO is expected to reach the target fill level
+ * @details Returns immediately (spin mode) when the last poll found the FIFO
+ *          at the high-water mark: the sleeps are not keeping up, and the
+ *          drain itself took long enough for the FIFO to refill. The drain
+ *          usually empties the FIFO, so the residual alone would never spin.
+ */
+void fifoPacer_wait(fifoPacer *pacer)
+{
+    if (pacer->polled >= pacer->highWater) {
+        pacer->pollIntervalUs = 0;
+        pacer->spins++;
+        return; // nearly full, poll again right away
+    }
+
+    unsigned int sleepUs = FIFO_PACER_MAX_SLEEP_US;
+    if (pacer->fillRate > 0) {
+        double us = (pacer->target > pacer->residual ? pacer->target - pacer->residual : 0) / pacer->fillRate;
+        if (us < FIFO_PACER_MAX_SLEEP_US) {
+            sleepUs = (unsigned int)us;
+        }
+    }
+    if (sleepUs < FIFO_PACER_MIN_SLEEP_US) {
+        sleepUs = FIFO_PACER_MIN_SLEEP_US;
+    }
+
+    pacer->pollIntervalUs = sleepUs;
+    pacer->sleeps++;
+    pacer->sleepUsTotal += sleepUs;
+
+    struct timespec ts = { .tv_sec = sleepUs / 1000000, .tv_nsec = (sleepUs % 1000000) * 1000 };
+    nanosleep(&ts, NULL); // an early wake-up by a signal is harmless
+}
+
+/**
+ * @brief Print the pacing statistics
+ */
+void fifoPacer_printStats(const fifoPacer *pacer)
+{
+    printf("FIFO pacing summary:\n");
+    printf("    Target fill: %u of %u words (spin above %u)\n", pacer->target, pacer->depth, pacer->highWater);
+    printf("    Fill rate: %.0f words/s\n", pacer->fillRate * 1e6);
+    printf("    Polls: %llu (%llu sleeps, %llu spins)\n", (unsigned long long)pacer->polls,
+           (unsigned long long)pacer->sleeps, (unsigned long long)pacer->spins);
+    printf("    Poll interval: last %u us, mean %.0f us\n", pacer->pollIntervalUs,
+           pacer->sleeps ? (double)pacer->sleepUsTotal / pacer->sleeps : 0.0);
+    printf("    Wake-up latency: mean %.0f us, max %.0f us over %llu late polls\n",
+           pacer->lateWakeups ? pacer->lateUsTotal / pacer->lateWakeups : 0.0, pacer->lateUsMax,
+           (unsigned long long)pacer->lateWakeups);
+    printf("    Peak occupancy: %u words (%.1f%%)\n", pacer->peakOccupancy,
+           pacer->depth ? 100.0 * pacer->peakOccupancy / pacer->depth : 0.0);
+}
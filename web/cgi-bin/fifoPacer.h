@@ -0,0 +1,63 @@
+/**
+ * @file fifoPacer.h
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Occupancy-driven polling of the AXI4-Stream FIFO
+ * @details Instead of sleeping a fixed time after every occupancy check, the
+ *          pacer measures how fast the FIFO fills and sleeps just long enough
+ *          for it to reach a target fill level. Close to the high-water mark
+ *          it stops sleeping and polls back to back.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef _FIFO_PACER_H_
+#define _FIFO_PACER_H_
+
+#include <stdint.h>
+#include <time.h>
+
+#define FIFO_DEFAULT_DEPTH          4096    // Receive FIFO depth in words (bitstream setting)
+#define FIFO_PACER_MIN_SLEEP_US     50      // Shortest sleep worth a context switch
+#define FIFO_PACER_MAX_SLEEP_US     20000   // Longest sleep, keeps shutdown responsive
+#define FIFO_PACER_RATE_WINDOW_NS   1000000 // Collect at least 1 ms before updating the fill rate
+#define FIFO_PACER_HIGH_WATER(depth) ((depth) - (depth) / 4) // Spin once the FIFO is three quarters full
+
+/**
+ * @brief Pacing controller state
+ */
+typedef struct fifoPacer
+{
+    unsigned int depth;             // FIFO depth in words
+    unsigned int target;            // fill level to wake up at
+    unsigned int highWater;         // occupancy at a poll above which the reader spins
+    double fillRate;                // smoothed fill rate in words per microsecond
+    unsigned int polled;            // words in the FIFO at the last poll, before the drain
+    unsigned int residual;          // words left in the FIFO after the last drain
+    uint64_t windowWords;           // words arrived in the current rate window
+    uint64_t windowNs;              // length of the current rate window
+    struct timespec lastPoll;       // time of the last poll
+    int started;                    // lastPoll is valid
+
+    // statistics
+    unsigned int peakOccupancy;     // highest occupancy seen at a poll
+    unsigned int pollIntervalUs;    // interval chosen after the last poll (0: spin)
+    uint64_t polls;                 // occupancy polls
+    uint64_t sleeps;                // polls followed by a sleep
+    uint64_t spins;                 // polls followed by an immediate re-poll
+    uint64_t sleepUsTotal;          // total time requested in sleeps
+    uint64_t lateWakeups;           // polls that found the FIFO above the target fill
+    double lateUsTotal;             // time the FIFO had been above the target at those polls
+    double lateUsMax;               // worst case of the above
+} fifoPacer;
+
+/**  Function Prototype */
+void fifoPacer_init(fifoPacer *pacer, unsigned int depth, unsigned int target);
+void fifoPacer_setTarget(fifoPacer *pacer, unsigned int target);
+void fifoPacer_update(fifoPacer *pacer, unsigned int occupancy, unsigned int drained);
+void fifoPacer_wait(fifoPacer *pacer);
+void fifoPacer_printStats(const fifoPacer *pacer);
+
+#endif /* _FIFO_PACER_H_ */
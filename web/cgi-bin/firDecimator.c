@@ -0,0 +1,310 @@
+/**
+ * @file firDecimator.c
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Polyphase FIR decimation of the drained FIFO samples
+ * @details See firDecimator.h.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* Include */
+#include "firDecimator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define FIR_NEON 1
+#endif
+
+/**
+ * @brief Design a lowpass for decimation by N (Hamming-windowed sinc, unity gain at DC)
+ */
+static void design_taps(double *taps, unsigned int numTaps, unsigned int decimation)
+{
+    double cutoff = FIR_CUTOFF / decimation; // cycles per input sample
+    double center = (numTaps - 1) / 2.0;
+    double sum = 0;
+    for (unsigned int k = 0; k < numTaps; k++) {
+        double t = k - center;
+        double sinc = (t == 0) ? 2 * cutoff : sin(2 * M_PI * cutoff * t) / (M_PI * t);
+        double window = (numTaps > 1) ? 0.54 - 0.46 * cos(2 * M_PI * k / (numTaps - 1)) : 1.0;
+        taps[k] = sinc * window;
+        sum += taps[k];
+    }
+    for (unsigned int k = 0; k < numTaps; k++) {
+        taps[k] /= sum;
+    }
+}
+
+/**
+ * @brief Read floating-point taps, separated by white space or commas
+ * @return int number of taps, -1 on failure
+ */
+static int load_taps(const char *path, double *taps)
+{
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        perror("Failed to open the FIR taps file");
+        return -1;
+    }
+    int numTaps = 0;
+    double value;
+    while (numTaps < FIR_MAX_TAPS && fscanf(file, " %lf ,", &value) == 1) {
+        taps[numTaps++] = value;
+    }
+    int end = fscanf(file, " %lf", &value); // anything left is either too many taps or not a number
+    fclose(file);
+    if (numTaps == 0 || end != EOF) {
+        fprintf(stderr, "Invalid FIR taps file %s (1 to %d numbers)\n", path, FIR_MAX_TAPS);
+        return -1;
+    }
+    return numTaps;
+}
+
+/**
+ * @brief Set up the filter
+ *
+ * @param fir decimator
+ * @param decimation keep 1 of every N samples (1 to FIR_MAX_DECIMATION)
+ * @param tapsPath text file of taps, NULL to design them
+ * @return int 0 on success, -1 on failure
+ */
+int firDecimator_init(firDecimator *fir, unsigned int decimation, const char *tapsPath)
+{
+    memset(fir, 0, sizeof(*fir));
+    fir->cycleFd = -2;
+    if (decimation == 0 || decimation > FIR_MAX_DECIMATION) {
+        fprintf(stderr, "Invalid decimation: %u (1 to %d)\n", decimation, FIR_MAX_DECIMATION);
+        return -1;
+    }
+    fir->decimation = decimation;
+
+    double taps[FIR_MAX_TAPS];
+    if (tapsPath != NULL) {
+        int numTaps = load_taps(tapsPath, taps);
+        if (numTaps < 0) {
+            return -1;
+        }
+        fir->numTaps = (unsigned int)numTaps;
+        fir->loaded = true;
+    } else {
+        fir->numTaps = FIR_TAPS_PER_PHASE * decimation;
+        if (fir->numTaps > FIR_MAX_TAPS) {
+            fir->numTaps = FIR_MAX_TAPS;
+        }
+        design_taps(taps, fir->numTaps, decimation);
+    }
+    fir->paddedTaps = (fir->numTaps + 7) & ~7u;
+
+    // one spare vector behind the block: the zero taps of the padding read past the newest sample
+    size_t lineLength = fir->numTaps - 1 + FIR_BLOCK + 8;
+    fir->taps = calloc(fir->paddedTaps, sizeof(int16_t));
+    fir->lineI = calloc(lineLength, sizeof(int16_t));
+    fir->lineQ = calloc(lineLength, sizeof(int16_t));
+    if (fir->taps == NULL || fir->lineI == NULL || fir->lineQ == NULL) {
+        fprintf(stderr, "Failed to allocate the FIR decimator\n");
+        firDecimator_close(fir);
+        return -1;
+    }
+    for (unsigned int k = 0; k < fir->numTaps; k++) {
+        long q15 = lround(taps[fir->numTaps - 1 - k] * 32768.0); // reversed: taps[0] meets the oldest sample
+        fir->taps[k] = (int16_t)(q15 > 32767 ? 32767 : (q15 < -32768 ? -32768 : q15));
+    }
+    return 0;
+}
+
+/**
+ * @brief Inputs that produce exactly `outputs` more outputs
+ * @details Feed at most this many so the outputs of one call fit the space left in a packet.
+ */
+unsigned int firDecimator_inputsFor(const firDecimator *fir, unsigned int outputs)
+{
+    return (outputs == 0) ? 0 : outputs * fir->decimation - fir->phase;
+}
+
+/**
+ * @brief Saturate a Q15 accumulator to int16 with rounding
+ */
+static inline int16_t round_q15(int32_t acc)
+{
+    int32_t value = (acc + (1 << 14)) >> 15;
+    return (int16_t)(value > 32767 ? 32767 : (value < -32768 ? -32768 : value));
+}
+
+/**
+ * @brief One output: dot product of the taps with the window starting at `start`, as a raw FIFO word
+ */
+static inline uint32_t filter_at(const firDecimator *fir, unsigned int start)
+{
+    const int16_t *lineI = fir->lineI + start;
+    const int16_t *lineQ = fir->lineQ + start;
+#ifdef FIR_NEON
+    int32x4_t accI = vdupq_n_s32(0);
+    int32x4_t accQ = vdupq_n_s32(0);
+    for (unsigned int k = 0; k < fir->paddedTaps; k += 8) {
+        int16x8_t h = vld1q_s16(fir->taps + k);
+        int16x8_t xi = vld1q_s16(lineI + k);
+        int16x8_t xq = vld1q_s16(lineQ + k);
+        accI = vmlal_s16(accI, vget_low_s16(h), vget_low_s16(xi));
+        accI = vmlal_s16(accI, vget_high_s16(h), vget_high_s16(xi));
+        accQ = vmlal_s16(accQ, vget_low_s16(h), vget_low_s16(xq));
+        accQ = vmlal_s16(accQ, vget_high_s16(h), vget_high_s16(xq));
+    }
+    int32x2_t sumI = vadd_s32(vget_low_s32(accI), vget_high_s32(accI));
+    int32x2_t sumQ = vadd_s32(vget_low_s32(accQ), vget_high_s32(accQ));
+    int32x2_t sums = vpadd_s32(sumI, sumQ); // lane 0: I, lane 1: Q
+    int32_t i = vget_lane_s32(sums, 0);
+    int32_t q = vget_lane_s32(sums, 1);
+#else
+    int32_t i = 0;
+    int32_t q = 0;
+    for (unsigned int k = 0; k < fir->numTaps; k++) {
+        i += (int32_t)fir->taps[k] * lineI[k];
+        q += (int32_t)fir->taps[k] * lineQ[k];
+    }
+#endif
+    return ((uint32_t)(uint16_t)round_q15(i) << 16) | (uint16_t)round_q15(q);
+}
+
+/**
+ * @brief Split raw FIFO words (I high, Q low) into the two delay lines
+ */
+static void deinterleave(const uint32_t *in, unsigned int count, int16_t *lineI, int16_t *lineQ)
+{
+    unsigned int n = 0;
+#ifdef FIR_NEON
+    for (; n + 8 <= count; n += 8) {
+        int16x8x2_t v = vld2q_s16((const int16_t *)(in + n)); // val[0]: Q, val[1]: I
+        vst1q_s16(lineI + n, v.val[1]);
+        vst1q_s16(lineQ + n, v.val[0]);
+    }
+#endif
+    for (; n < count; n++) {
+        lineI[n] = (int16_t)(in[n] >> 16);
+        lineQ[n] = (int16_t)in[n];
+    }
+}
+
+/**
+ * @brief Open a cycle counter for the calling thread
+ */
+static int open_cycle_counter(void)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/**
+ * @brief Read the cycle counter, 0 if there is none
+ */
+static uint64_t read_cycles(int fd)
+{
+    uint64_t cycles = 0;
+    if (fd >= 0 && read(fd, &cycles, sizeof(cycles)) != sizeof(cycles)) {
+        cycles = 0;
+    }
+    return cycles;
+}
+
+/**
+ * @brief Filter and decimate a run of raw FIFO words
+ * @details The first call opens the cycle counter, so it counts the thread
+ *          that does the filtering.
+ *
+ * @param fir decimator
+ * @param in raw FIFO words
+ * @param count number of words
+ * @param out raw FIFO words at the decimated rate (room for (count + phase) / N)
+ * @return unsigned int number of outputs
+ */
+unsigned int firDecimator_process(firDecimator *fir, const uint32_t *in, unsigned int count, uint32_t *out)
+{
+    if (fir->cycleFd == -2) {
+        fir->cycleFd = open_cycle_counter(); // -1 without perf events, the time is still measured
+    }
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    uint64_t startCycles = read_cycles(fir->cycleFd);
+
+    unsigned int history = fir->numTaps - 1;
+    unsigned int produced = 0;
+    fir->stats.inputs += count;
+    while (count > 0) {
+        unsigned int n = (count < FIR_BLOCK) ? count : FIR_BLOCK;
+        deinterleave(in, n, fir->lineI + history, fir->lineQ + history);
+        // the newest sample of the window for new sample j sits at history + j, the window starts at j
+        for (unsigned int j = fir->decimation - 1 - fir->phase; j < n; j += fir->decimation) {
+            out[produced++] = filter_at(fir, j);
+        }
+        fir->phase = (fir->phase + n) % fir->decimation;
+        memmove(fir->lineI, fir->lineI + n, history * sizeof(int16_t));
+        memmove(fir->lineQ, fir->lineQ + n, history * sizeof(int16_t));
+        in += n;
+        count -= n;
+    }
+    fir->stats.outputs += produced;
+
+    fir->stats.cycles += read_cycles(fir->cycleFd) - startCycles;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    fir->stats.nanoseconds += (uint64_t)((end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec));
+    return produced;
+}
+
+/**
+ * @brief Free the taps and delay lines
+ */
+void firDecimator_close(firDecimator *fir)
+{
+    if (fir->cycleFd >= 0) {
+        close(fir->cycleFd);
+    }
+    fir->cycleFd = -2;
+    free(fir->taps);
+    free(fir->lineI);
+    free(fir->lineQ);
+    fir->taps = NULL;
+    fir->lineI = NULL;
+    fir->lineQ = NULL;
+}
+
+/**
+ * @brief Print the decimator counters and its cost per output sample
+ */
+void firDecimator_printStats(const firDecimator *fir)
+{
+    printf("FIR decimator summary (by %u, %u taps %s, %s):\n", fir->decimation, fir->numTaps,
+           fir->loaded ? "loaded" : "designed",
+#ifdef FIR_NEON
+           "NEON"
+#else
+           "scalar"
+#endif
+           );
+    printf("    Samples: %llu in, %llu out\n", (unsigned long long)fir->stats.inputs,
+           (unsigned long long)fir->stats.outputs);
+    if (fir->stats.outputs > 0) {
+        double nsPerOutput = (double)fir->stats.nanoseconds / fir->stats.outputs;
+        bool measured = (fir->stats.cycles > 0);
+        double cyclesPerOutput = measured ? (double)fir->stats.cycles / fir->stats.outputs
+                                          : nsPerOutput * FIR_NOMINAL_CPU_HZ / 1e9;
+        printf("    Cost: %.1f ns, %.0f cycles per output sample (%s)\n", nsPerOutput, cyclesPerOutput,
+               measured ? "cycle counter" : "estimated from the time");
+    }
+}
@@ -0,0 +1,73 @@
+/**
+ * @file firDecimator.h
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Polyphase FIR decimation of the drained FIFO samples
+ * @details Sits between the FIFO drain and the packetizer: raw FIFO words go
+ *          in, raw FIFO words at 1/N of the rate come out, so the format
+ *          conversion and everything after it are unchanged. Only every Nth
+ *          output is computed (the polyphase form of a decimating FIR, with
+ *          the commutator folded into the delay-line index), each as an int16
+ *          dot product of the Q15 taps with the last numTaps inputs, 8 taps per
+ *          NEON step on the board.
+ *
+ *          The taps are either designed at startup (Hamming-windowed sinc,
+ *          FIR_TAPS_PER_PHASE taps per phase, cut off at FIR_CUTOFF of the
+ *          output rate, unity gain at DC) or loaded from a text file of
+ *          floating-point coefficients (1.0 = unity), e.g. from a filter
+ *          design tool.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef _FIR_DECIMATOR_H_
+#define _FIR_DECIMATOR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define FIR_MAX_DECIMATION  64              // largest decimation factor
+#define FIR_MAX_TAPS        1024            // longest filter
+#define FIR_TAPS_PER_PHASE  16              // designed filter length per decimation phase
+#define FIR_CUTOFF          0.4             // designed cutoff, fraction of the output sample rate
+#define FIR_BLOCK           1024            // input samples per delay-line update
+#define FIR_NOMINAL_CPU_HZ  666666687.0     // Zynq-7000 CPU clock, for cycle estimates without a counter
+
+/**
+ * @brief Decimator counters
+ */
+typedef struct firDecimatorStats
+{
+    uint64_t inputs;            // samples in
+    uint64_t outputs;           // samples out
+    uint64_t nanoseconds;       // time spent in firDecimator_process()
+    uint64_t cycles;            // CPU cycles spent in it (0: no cycle counter)
+} firDecimatorStats;
+
+/**
+ * @brief Decimating FIR filter
+ */
+typedef struct firDecimator
+{
+    unsigned int decimation;    // keep 1 of every N samples
+    unsigned int numTaps;       // filter length
+    unsigned int paddedTaps;    // numTaps rounded up to a multiple of 8, zero taps at the end
+    bool loaded;                // taps came from a file
+    int16_t *taps;              // Q15 taps, reversed to match the delay line
+    int16_t *lineI;             // I delay line: numTaps - 1 old samples, then the new block
+    int16_t *lineQ;             // Q delay line
+    unsigned int phase;         // inputs since the last output
+    int cycleFd;                // cycle counter of the processing thread (-1: none, -2: not opened yet)
+    firDecimatorStats stats;    // counters
+} firDecimator;
+
+/**  Function Prototype */
+int firDecimator_init(firDecimator *fir, unsigned int decimation, const char *tapsPath);
+unsigned int firDecimator_inputsFor(const firDecimator *fir, unsigned int outputs);
+unsigned int firDecimator_process(firDecimator *fir, const uint32_t *in, unsigned int count, uint32_t *out);
+void firDecimator_close(firDecimator *fir);
+void firDecimator_printStats(const firDecimator *fir);
+
+#endif /* _FIR_DECIMATOR_H_ */
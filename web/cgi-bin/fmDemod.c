@@ -0,0 +1,279 @@
+/**
+ * @file fmDemod.c
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief FM demodulation of the drained FIFO samples to 16-bit PCM audio
+ * @details See fmDemod.h.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* Include */
+#include "fmDemod.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define FM_DEMOD_NEON 1
+#endif
+
+// atan(z) on [0, 1], odd polynomial in z (max error about 1e-5 rad)
+#define ATAN_C1     0.99997726f
+#define ATAN_C3     -0.33262347f
+#define ATAN_C5     0.19354346f
+#define ATAN_C7     -0.11643287f
+#define ATAN_C9     0.05265332f
+#define ATAN_C11    -0.01172120f
+
+/**
+ * @brief Set up the demodulator
+ *
+ * @param fm demodulator
+ * @param iqRate IQ samples per second in
+ * @param audioRate audio samples per second out (divides iqRate)
+ * @param deemphasisUs de-emphasis time constant in microseconds (0: off)
+ * @return int 0 on success, -1 on invalid rates
+ */
+int fmDemod_init(fmDemod *fm, unsigned int iqRate, unsigned int audioRate, unsigned int deemphasisUs)
+{
+    memset(fm, 0, sizeof(*fm));
+    if (audioRate == 0 || audioRate > iqRate || iqRate % audioRate != 0) {
+        fprintf(stderr, "Invalid audio rate: %u (must divide the IQ rate of %u)\n", audioRate, iqRate);
+        return -1;
+    }
+    fm->iqRate = iqRate;
+    fm->audioRate = audioRate;
+    fm->decimation = iqRate / audioRate;
+    fm->deemphasisUs = deemphasisUs;
+    // a phase step of 2 pi * deviation / iqRate is full scale, the dump divides the sum by N
+    fm->gain = (float)(32767.0 * iqRate / (2 * M_PI * FM_DEVIATION_HZ) / fm->decimation);
+    fm->alpha = (deemphasisUs == 0) ? 1.0f : (float)(1.0 - exp(-1e6 / ((double)audioRate * deemphasisUs)));
+    return 0;
+}
+
+/**
+ * @brief IQ samples that produce exactly `outputs` more audio samples
+ */
+unsigned int fmDemod_inputsFor(const fmDemod *fm, unsigned int outputs)
+{
+    return (outputs == 0) ? 0 : outputs * fm->decimation - fm->phase;
+}
+
+/**
+ * @brief atan2(y, x) from the polynomial, same operations as the NEON kernel
+ */
+static inline float fast_atan2(float y, float x)
+{
+    float ax = fabsf(x);
+    float ay = fabsf(y);
+    float big = (ax > ay) ? ax : ay;
+    float small = (ax > ay) ? ay : ax;
+    float z = small / (big > 1e-30f ? big : 1e-30f);
+    float z2 = z * z;
+    float r = ATAN_C11;
+    r = ATAN_C9 + r * z2;
+    r = ATAN_C7 + r * z2;
+    r = ATAN_C5 + r * z2;
+    r = ATAN_C3 + r * z2;
+    r = ATAN_C1 + r * z2;
+    r *= z;
+    if (ay > ax) {
+        r = (float)M_PI_2 - r;
+    }
+    if (x < 0) {
+        r = (float)M_PI - r;
+    }
+    return (y < 0) ? -r : r;
+}
+
+/**
+ * @brief Phase step between a sample and the one before it
+ */
+static inline float phase_step(uint32_t word, uint32_t previous)
+{
+    float i = (int16_t)(word >> 16);
+    float q = (int16_t)word;
+    float pi = (int16_t)(previous >> 16);
+    float pq = (int16_t)previous;
+    // x[n] * conj(x[n-1])
+    return fast_atan2(q * pi - i * pq, i * pi + q * pq);
+}
+
+/**
+ * @brief Polar discriminator one sample at a time
+ * @details The reference for the NEON kernel, the fallback on other CPUs and
+ *          the tail of every pass.
+ *
+ * @param in raw FIFO words
+ * @param previous the word before in[0]
+ * @param count number of words
+ * @param steps phase step of every word, in radians
+ */
+void fmDemod_discriminateScalar(const uint32_t *in, uint32_t previous, unsigned int count, float *steps)
+{
+    for (unsigned int n = 0; n < count; n++) {
+        steps[n] = phase_step(in[n], previous);
+        previous = in[n];
+    }
+}
+
+#ifdef FM_DEMOD_NEON
+/**
+ * @brief Widen 4 int16 to float
+ */
+static inline float32x4_t to_float(int16x4_t v)
+{
+    return vcvtq_f32_s32(vmovl_s16(v));
+}
+
+/**
+ * @brief atan2 of 4 lanes, same steps as fast_atan2()
+ */
+static inline float32x4_t atan2_neon(float32x4_t y, float32x4_t x)
+{
+    float32x4_t ax = vabsq_f32(x);
+    float32x4_t ay = vabsq_f32(y);
+    float32x4_t big = vmaxq_f32(vmaxq_f32(ax, ay), vdupq_n_f32(1e-30f));
+    float32x4_t small = vminq_f32(ax, ay);
+    // reciprocal estimate refined by two Newton-Raphson steps
+    float32x4_t inv = vrecpeq_f32(big);
+    inv = vmulq_f32(vrecpsq_f32(big, inv), inv);
+    inv = vmulq_f32(vrecpsq_f32(big, inv), inv);
+    float32x4_t z = vmulq_f32(small, inv);
+    float32x4_t z2 = vmulq_f32(z, z);
+    float32x4_t r = vdupq_n_f32(ATAN_C11);
+    r = vmlaq_f32(vdupq_n_f32(ATAN_C9), r, z2);
+    r = vmlaq_f32(vdupq_n_f32(ATAN_C7), r, z2);
+    r = vmlaq_f32(vdupq_n_f32(ATAN_C5), r, z2);
+    r = vmlaq_f32(vdupq_n_f32(ATAN_C3), r, z2);
+    r = vmlaq_f32(vdupq_n_f32(ATAN_C1), r, z2);
+    r = vmulq_f32(r, z);
+    r = vbslq_f32(vcgtq_f32(ay, ax), vsubq_f32(vdupq_n_f32((float)M_PI_2), r), r);
+    r = vbslq_f32(vcltq_f32(x, vdupq_n_f32(0)), vsubq_f32(vdupq_n_f32((float)M_PI), r), r);
+    return vbslq_f32(vcltq_f32(y, vdupq_n_f32(0)), vnegq_f32(r), r);
+}
+
+/**
+ * @brief Phase steps of 4 samples from their I/Q and the I/Q of the samples before them
+ */
+static inline float32x4_t steps_neon(int16x4_t i, int16x4_t q, int16x4_t pi, int16x4_t pq)
+{
+    float32x4_t fi = to_float(i);
+    float32x4_t fq = to_float(q);
+    float32x4_t fpi = to_float(pi);
+    float32x4_t fpq = to_float(pq);
+    float32x4_t re = vmlaq_f32(vmulq_f32(fi, fpi), fq, fpq);
+    float32x4_t im = vmlsq_f32(vmulq_f32(fq, fpi), fi, fpq);
+    return atan2_neon(im, re);
+}
+#endif
+
+/**
+ * @brief Polar discriminator, 8 samples per NEON iteration on the board
+ *
+ * @param in raw FIFO words
+ * @param previous the word before in[0]
+ * @param count number of words
+ * @param steps phase step of every word, in radians
+ */
+void fmDemod_discriminate(const uint32_t *in, uint32_t previous, unsigned int count, float *steps)
+{
+    unsigned int n = 0;
+#ifdef FM_DEMOD_NEON
+    if (count > 0) {
+        steps[0] = phase_step(in[0], previous); // in[-1] does not exist, the rest read one word back
+        n = 1;
+    }
+    for (; n + 8 <= count; n += 8) {
+        int16x8x2_t x = vld2q_s16((const int16_t *)(in + n));      // val[0]: Q, val[1]: I
+        int16x8x2_t p = vld2q_s16((const int16_t *)(in + n - 1));  // the samples before them
+        vst1q_f32(steps + n, steps_neon(vget_low_s16(x.val[1]), vget_low_s16(x.val[0]),
+                                        vget_low_s16(p.val[1]), vget_low_s16(p.val[0])));
+        vst1q_f32(steps + n + 4, steps_neon(vget_high_s16(x.val[1]), vget_high_s16(x.val[0]),
+                                            vget_high_s16(p.val[1]), vget_high_s16(p.val[0])));
+    }
+    if (n > 0) {
+        previous = in[n - 1];
+    }
+#endif
+    fmDemod_discriminateScalar(in + n, previous, count - n, steps + n);
+}
+
+/**
+ * @brief Which discriminator fmDemod_discriminate() runs ("NEON" or "scalar")
+ */
+const char *fmDemod_backend(void)
+{
+#ifdef FM_DEMOD_NEON
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
+
+/**
+ * @brief Demodulate a run of raw FIFO words to audio
+ *
+ * @param fm demodulator
+ * @param in raw FIFO words
+ * @param count number of words
+ * @param out audio samples (room for (count + phase) / N)
+ * @return unsigned int number of audio samples
+ */
+unsigned int fmDemod_process(fmDemod *fm, const uint32_t *in, unsigned int count, int16_t *out)
+{
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    unsigned int produced = 0;
+    fm->stats.inputs += count;
+    while (count > 0) {
+        unsigned int n = (count < FM_BLOCK) ? count : FM_BLOCK;
+        fmDemod_discriminate(in, fm->previous, n, fm->steps);
+        fm->previous = in[n - 1];
+        for (unsigned int k = 0; k < n; k++) {
+            fm->sum += fm->steps[k];
+            if (++fm->phase < fm->decimation) {
+                continue;
+            }
+            // dump, de-emphasize and scale one audio sample
+            fm->deemphasis += fm->alpha * (fm->sum - fm->deemphasis);
+            long value = lrintf(fm->deemphasis * fm->gain);
+            if (value > 32767 || value < -32768) {
+                value = (value > 0) ? 32767 : -32768;
+                fm->stats.clipped++;
+            }
+            out[produced++] = (int16_t)value;
+            fm->sum = 0;
+            fm->phase = 0;
+        }
+        in += n;
+        count -= n;
+    }
+    fm->stats.outputs += produced;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    fm->stats.nanoseconds += (uint64_t)((end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec));
+    return produced;
+}
+
+/**
+ * @brief Print the demodulator counters and its throughput on the reader's core
+ */
+void fmDemod_printStats(const fmDemod *fm)
+{
+    printf("FM demodulator summary (%u to %u samples/s, %u us de-emphasis, %s discriminator):\n",
+           fm->iqRate, fm->audioRate, fm->deemphasisUs, fmDemod_backend());
+    printf("    Samples: %llu IQ in, %llu audio out, %llu clipped\n", (unsigned long long)fm->stats.inputs,
+           (unsigned long long)fm->stats.outputs, (unsigned long long)fm->stats.clipped);
+    if (fm->stats.nanoseconds > 0) {
+        printf("    Throughput: %.2f MSamples/s of IQ per core (%.1f ns per sample)\n",
+               fm->stats.inputs * 1e3 / fm->stats.nanoseconds, (double)fm->stats.nanoseconds / fm->stats.inputs);
+    }
+}
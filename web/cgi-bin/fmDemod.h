@@ -0,0 +1,76 @@
+/**
+ * @file fmDemod.h
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief FM demodulation of the drained FIFO samples to 16-bit PCM audio
+ * @details Turns raw FIFO words (complex int16, I in the high half) into mono
+ *          audio for thin clients that only play the stream:
+ *
+ *            1. polar discriminator: the phase step between neighbouring
+ *               samples, arg(x[n] * conj(x[n-1])), with a polynomial atan2
+ *               (about 1e-5 rad error), 8 samples per NEON iteration;
+ *            2. integrate and dump: the mean of every N phase steps, which
+ *               brings the IQ rate down to the audio rate;
+ *            3. de-emphasis: a one-pole low-pass with the broadcast time
+ *               constant, at the audio rate;
+ *            4. scaling so FM_DEVIATION_HZ of deviation is full scale, saturated
+ *               to int16.
+ *
+ *          The audio rate has to divide the IQ rate. State is carried across
+ *          calls, so the stream can be fed in any block sizes.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef _FM_DEMOD_H_
+#define _FM_DEMOD_H_
+
+#include <stdint.h>
+
+#define FM_DEFAULT_AUDIO_RATE       12000   // audio samples per second
+#define FM_DEFAULT_DEEMPHASIS_US    75      // de-emphasis time constant (75 us Americas, 50 us Europe, 0: off)
+#define FM_DEVIATION_HZ             5000    // deviation that gives full-scale audio (narrowband FM)
+#define FM_BLOCK                    1024    // phase steps per discriminator pass
+
+/**
+ * @brief Demodulator counters
+ */
+typedef struct fmDemodStats
+{
+    uint64_t inputs;            // IQ samples in
+    uint64_t outputs;           // audio samples out
+    uint64_t clipped;           // audio samples saturated to int16
+    uint64_t nanoseconds;       // time spent in fmDemod_process()
+} fmDemodStats;
+
+/**
+ * @brief FM demodulator
+ */
+typedef struct fmDemod
+{
+    unsigned int iqRate;        // IQ samples per second in
+    unsigned int audioRate;     // audio samples per second out
+    unsigned int decimation;    // IQ samples per audio sample
+    unsigned int deemphasisUs;  // de-emphasis time constant (0: off)
+    float gain;                 // mean phase step (radians) to int16 audio
+    float alpha;                // de-emphasis smoothing factor (1: off)
+    uint32_t previous;          // last IQ word of the previous call
+    unsigned int phase;         // phase steps summed toward the next audio sample
+    float sum;                  // their sum
+    float deemphasis;           // de-emphasis filter state
+    float steps[FM_BLOCK];      // phase steps of the current pass
+    fmDemodStats stats;         // counters
+} fmDemod;
+
+/**  Function Prototype */
+int fmDemod_init(fmDemod *fm, unsigned int iqRate, unsigned int audioRate, unsigned int deemphasisUs);
+unsigned int fmDemod_inputsFor(const fmDemod *fm, unsigned int outputs);
+unsigned int fmDemod_process(fmDemod *fm, const uint32_t *in, unsigned int count, int16_t *out);
+void fmDemod_discriminate(const uint32_t *in, uint32_t previous, unsigned int count, float *steps);
+void fmDemod_discriminateScalar(const uint32_t *in, uint32_t previous, unsigned int count, float *steps);
+const char *fmDemod_backend(void);
+void fmDemod_printStats(const fmDemod *fm);
+
+#endif /* _FM_DEMOD_H_ */
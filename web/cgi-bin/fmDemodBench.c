@@ -0,0 +1,143 @@
+/**
+ * @file fmDemodBench.c
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Throughput benchmark of the FM demodulator
+ * @details Demodulates the same block of a synthetic FM signal (a 1 kHz tone
+ *          at 3 kHz deviation) over and over on one core, once with the scalar
+ *          discriminator, once with fmDemod_discriminate() (NEON on the board)
+ *          and once through the whole fmDemod_process() chain, and prints the
+ *          IQ samples/s of each. The NEON phase steps are checked against the
+ *          scalar ones first. Runs without the FPGA.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+
+#include "fmDemod.h"
+#include "radioTuner.h"
+
+#define DEFAULT_SAMPLES     FM_BLOCK    // IQ samples per call
+#define DEFAULT_PASSES      20000       // calls per measurement
+#define TEST_TONE_HZ        1000.0      // modulating tone
+#define TEST_DEVIATION_HZ   3000.0      // its deviation
+#define MAX_STEP_ERROR      1e-4        // NEON vs scalar phase steps, radians
+
+volatile float sink;                    // keeps the compiler from dropping the work
+
+void usage(const char *executableName);
+
+/**
+ * @brief Seconds since `start`
+ */
+static double seconds_since(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main(int argc, char const *argv[])
+{
+    unsigned int num_samples = DEFAULT_SAMPLES;
+    unsigned int num_passes = DEFAULT_PASSES;
+    unsigned int audio_rate = FM_DEFAULT_AUDIO_RATE;
+    int opt = 0;
+    while ((opt = getopt(argc, (char * const *)argv, "s:n:a:h")) != -1) {
+        switch (opt) {
+            case 's': num_samples = (unsigned int)atoi(optarg); break;
+            case 'n': num_passes = (unsigned int)atoi(optarg); break;
+            case 'a': audio_rate = (unsigned int)atoi(optarg); break;
+            case 'h': usage(argv[0]); return 0;
+            default:  usage(argv[0]); return -1;
+        }
+    }
+    if (num_samples == 0 || num_passes == 0) {
+        usage(argv[0]);
+        return -1;
+    }
+    fmDemod fm;
+    if (fmDemod_init(&fm, RADIO_SAMPLE_RATE, audio_rate, FM_DEFAULT_DEEMPHASIS_US) != 0) {
+        return -1;
+    }
+
+    uint32_t *iq = malloc((size_t)num_samples * sizeof(uint32_t));
+    float *steps = malloc((size_t)num_samples * sizeof(float));
+    float *ref = malloc((size_t)num_samples * sizeof(float));
+    int16_t *audio = malloc((size_t)num_samples * sizeof(int16_t));
+    if (iq == NULL || steps == NULL || ref == NULL || audio == NULL) {
+        fprintf(stderr, "Failed to allocate the buffers\n");
+        return -1;
+    }
+    double phase = 0;
+    for (unsigned int n = 0; n < num_samples; n++) {
+        phase += 2 * M_PI * TEST_DEVIATION_HZ / RADIO_SAMPLE_RATE * sin(2 * M_PI * TEST_TONE_HZ / RADIO_SAMPLE_RATE * n);
+        int16_t i = (int16_t)lrint(20000 * cos(phase));
+        int16_t q = (int16_t)lrint(20000 * sin(phase));
+        iq[n] = ((uint32_t)(uint16_t)i << 16) | (uint16_t)q;
+    }
+
+    fmDemod_discriminateScalar(iq, iq[0], num_samples, ref);
+    fmDemod_discriminate(iq, iq[0], num_samples, steps);
+    double worst = 0;
+    for (unsigned int n = 0; n < num_samples; n++) {
+        double error = fabs(steps[n] - ref[n]);
+        worst = (error > worst) ? error : worst;
+    }
+    printf("Demodulating %u calls of %u IQ samples on one core, discriminator: %s (max difference %.2g rad)\n",
+           num_passes, num_samples, fmDemod_backend(), worst);
+    if (worst > MAX_STEP_ERROR) {
+        printf("MISMATCH between %s and scalar phase steps\n", fmDemod_backend());
+        return -1;
+    }
+
+    double total = (double)num_passes * num_samples;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (unsigned int p = 0; p < num_passes; p++) {
+        fmDemod_discriminateScalar(iq, iq[0], num_samples, steps);
+        sink += steps[p % num_samples];
+    }
+    double scalarSeconds = seconds_since(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (unsigned int p = 0; p < num_passes; p++) {
+        fmDemod_discriminate(iq, iq[0], num_samples, steps);
+        sink += steps[p % num_samples];
+    }
+    double vectorSeconds = seconds_since(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (unsigned int p = 0; p < num_passes; p++) {
+        unsigned int produced = fmDemod_process(&fm, iq, num_samples, audio);
+        sink += (produced > 0) ? audio[produced - 1] : 0;
+    }
+    double processSeconds = seconds_since(&start);
+
+    printf("%-14s %10.2f MSamples/s scalar, %10.2f MSamples/s %s (x%.2f)\n", "discriminator",
+           total / scalarSeconds / 1e6, total / vectorSeconds / 1e6, fmDemod_backend(), scalarSeconds / vectorSeconds);
+    printf("%-14s %10.2f MSamples/s to %u Hz audio, %.0f times the radio rate per core\n", "full chain",
+           total / processSeconds / 1e6, audio_rate, total / processSeconds / RADIO_SAMPLE_RATE);
+
+    free(audio);
+    free(ref);
+    free(steps);
+    free(iq);
+    return 0;
+}
+
+void usage(const char *executableName)
+{
+    printf("Usage: %s [-s <samples>] [-n <calls>] [-a <audio rate>]\n", executableName);
+    printf("  samples: IQ samples per call (default %d)\n", DEFAULT_SAMPLES);
+    printf("  calls: calls per measurement (default %d)\n", DEFAULT_PASSES);
+    printf("  audio rate: audio samples/s, divides %d (default %d)\n", RADIO_SAMPLE_RATE, FM_DEFAULT_AUDIO_RATE);
+}
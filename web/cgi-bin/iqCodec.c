@@ -0,0 +1,296 @@
+/**
+ * @file iqCodec.c
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Lossless per-packet compression of raw FIFO words for thin uplinks
+ * @details See iqCodec.h. The encoder runs on the board, the decoder on the
+ *          receivers (udpCapture builds it in).
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* Include */
+#include "iqCodec.h"
+
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define IQ_CODEC_NEON 1
+#endif
+
+#define WIDTH_BITS  5               // bits of a block width
+
+/**
+ * @brief Bit stream writer, LSB first
+ */
+typedef struct bitWriter
+{
+    uint8_t *out;                   // next byte to write
+    uint64_t acc;                   // bits not written yet
+    unsigned int fill;              // number of them
+} bitWriter;
+
+/**
+ * @brief Bit stream reader, LSB first, bounded
+ */
+typedef struct bitReader
+{
+    const uint8_t *in;              // next byte to read
+    const uint8_t *end;             // end of the stream
+    uint64_t acc;                   // bits read ahead
+    unsigned int fill;              // number of them
+} bitReader;
+
+static inline void put_bits(bitWriter *w, uint32_t value, unsigned int bits)
+{
+    w->acc |= (uint64_t)value << w->fill;
+    w->fill += bits;
+    while (w->fill >= 8) {
+        *w->out++ = (uint8_t)w->acc;
+        w->acc >>= 8;
+        w->fill -= 8;
+    }
+}
+
+static inline int get_bits(bitReader *r, unsigned int bits, uint32_t *value)
+{
+    while (r->fill < bits) {
+        if (r->in >= r->end) {
+            return -1;
+        }
+        r->acc |= (uint64_t)*r->in++ << r->fill;
+        r->fill += 8;
+    }
+    *value = (uint32_t)(r->acc & ((1ull << bits) - 1));
+    r->acc >>= bits;
+    r->fill -= bits;
+    return 0;
+}
+
+static inline uint32_t zigzag(int32_t r)
+{
+    return ((uint32_t)r << 1) ^ (uint32_t)(r >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t z)
+{
+    return (int32_t)(z >> 1) ^ -(int32_t)(z & 1);
+}
+
+/**
+ * @brief Sample n of a channel (0: Q, the low half; 1: I, the high half), 0 before the packet
+ */
+static inline int32_t sample_at(const uint32_t *raw, unsigned int channel, int n)
+{
+    return (n < 0) ? 0 : (int16_t)(channel ? raw[n] >> 16 : raw[n]);
+}
+
+/**
+ * @brief Zigzag-mapped prediction residuals of one channel
+ */
+static void residuals(const uint32_t *raw, unsigned int count, unsigned int channel, unsigned int order, uint32_t *z)
+{
+    unsigned int n = 0;
+#ifdef IQ_CODEC_NEON
+    // the first two samples reach before the packet, the vectors start after them
+    for (; n < 2 && n < count; n++) {
+        int32_t x = sample_at(raw, channel, n);
+        int32_t p1 = sample_at(raw, channel, (int)n - 1);
+        int32_t p2 = sample_at(raw, channel, (int)n - 2);
+        z[n] = zigzag(order == 0 ? x : (order == 1 ? x - p1 : x - 2 * p1 + p2));
+    }
+    for (; n + 8 <= count; n += 8) {
+        int16x8_t x = vld2q_s16((const int16_t *)(raw + n)).val[channel];
+        int16x8_t p1 = vld2q_s16((const int16_t *)(raw + n - 1)).val[channel];
+        int16x8_t p2 = vld2q_s16((const int16_t *)(raw + n - 2)).val[channel];
+        int32x4_t lo, hi;
+        if (order == 0) {
+            lo = vmovl_s16(vget_low_s16(x));
+            hi = vmovl_s16(vget_high_s16(x));
+        } else if (order == 1) {
+            lo = vsubl_s16(vget_low_s16(x), vget_low_s16(p1));
+            hi = vsubl_s16(vget_high_s16(x), vget_high_s16(p1));
+        } else {
+            // (x - p1) - (p1 - p2)
+            lo = vsubq_s32(vsubl_s16(vget_low_s16(x), vget_low_s16(p1)), vsubl_s16(vget_low_s16(p1), vget_low_s16(p2)));
+            hi = vsubq_s32(vsubl_s16(vget_high_s16(x), vget_high_s16(p1)), vsubl_s16(vget_high_s16(p1), vget_high_s16(p2)));
+        }
+        // zigzag: (r << 1) ^ (r >> 31)
+        vst1q_u32(z + n, veorq_u32(vreinterpretq_u32_s32(vshlq_n_s32(lo, 1)), vreinterpretq_u32_s32(vshrq_n_s32(lo, 31))));
+        vst1q_u32(z + n + 4, veorq_u32(vreinterpretq_u32_s32(vshlq_n_s32(hi, 1)), vreinterpretq_u32_s32(vshrq_n_s32(hi, 31))));
+    }
+#endif
+    for (; n < count; n++) {
+        int32_t x = sample_at(raw, channel, n);
+        int32_t p1 = sample_at(raw, channel, (int)n - 1);
+        int32_t p2 = sample_at(raw, channel, (int)n - 2);
+        z[n] = zigzag(order == 0 ? x : (order == 1 ? x - p1 : x - 2 * p1 + p2));
+    }
+}
+
+/**
+ * @brief Bit width of every block, returns the bits the channel packs into
+ */
+static size_t block_widths(const uint32_t *z, unsigned int count, uint8_t *widths)
+{
+    size_t bits = 0;
+    for (unsigned int b = 0, start = 0; start < count; b++, start += IQ_CODEC_BLOCK) {
+        unsigned int length = (count - start < IQ_CODEC_BLOCK) ? count - start : IQ_CODEC_BLOCK;
+        uint32_t any = 0;
+        for (unsigned int k = 0; k < length; k++) {
+            any |= z[start + k];
+        }
+        widths[b] = (any == 0) ? 0 : (uint8_t)(32 - __builtin_clz(any));
+        bits += WIDTH_BITS + (size_t)length * widths[b];
+    }
+    return bits;
+}
+
+/**
+ * @brief Compress one packet of raw FIFO words
+ *
+ * @param raw raw FIFO words (I high, Q low)
+ * @param count number of words (up to IQ_CODEC_MAX_SAMPLES)
+ * @param out compressed payload (room for IQ_CODEC_MAX_BYTES(count))
+ * @return size_t bytes written
+ */
+size_t iqCodec_encode(const uint32_t *raw, unsigned int count, uint8_t *out)
+{
+    uint32_t z[2][IQ_CODEC_MAX_SAMPLES];
+    uint8_t widths[2][IQ_CODEC_MAX_SAMPLES / IQ_CODEC_BLOCK];
+    unsigned int orders[2] = { 0, 0 };
+    size_t bits = 0;
+
+    // pick the predictor that packs smallest for each channel, keep its residuals
+    for (unsigned int channel = 0; channel < 2; channel++) {
+        size_t best = (size_t)-1;
+        for (unsigned int order = 0; order <= IQ_CODEC_MAX_ORDER; order++) {
+            uint32_t trial[IQ_CODEC_MAX_SAMPLES];
+            uint8_t trialWidths[IQ_CODEC_MAX_SAMPLES / IQ_CODEC_BLOCK];
+            residuals(raw, count, channel, order, trial);
+            size_t size = block_widths(trial, count, trialWidths);
+            if (size < best) {
+                best = size;
+                orders[channel] = order;
+                memcpy(z[channel], trial, count * sizeof(uint32_t));
+                memcpy(widths[channel], trialWidths, (count + IQ_CODEC_BLOCK - 1) / IQ_CODEC_BLOCK);
+            }
+        }
+        bits += best;
+    }
+
+    size_t bytes = IQ_CODEC_HEADER_BYTES + (bits + 7) / 8;
+    if (bytes >= IQ_CODEC_MAX_BYTES(count)) {
+        // noise-like packet, send it as it is
+        bytes = IQ_CODEC_MAX_BYTES(count);
+        out[0] = (uint8_t)bytes;
+        out[1] = (uint8_t)(bytes >> 8);
+        out[2] = IQ_CODEC_STORED;
+        out[3] = IQ_CODEC_BLOCK;
+        memcpy(out + IQ_CODEC_HEADER_BYTES, raw, (size_t)count * 4);
+        return bytes;
+    }
+    out[0] = (uint8_t)bytes;
+    out[1] = (uint8_t)(bytes >> 8);
+    out[2] = (uint8_t)(orders[1] | (orders[0] << 2)); // I (channel 1) in the low bits
+    out[3] = IQ_CODEC_BLOCK;
+
+    bitWriter w = { out + IQ_CODEC_HEADER_BYTES, 0, 0 };
+    for (int channel = 1; channel >= 0; channel--) {
+        for (unsigned int b = 0, start = 0; start < count; b++, start += IQ_CODEC_BLOCK) {
+            unsigned int length = (count - start < IQ_CODEC_BLOCK) ? count - start : IQ_CODEC_BLOCK;
+            unsigned int width = widths[channel][b];
+            put_bits(&w, width, WIDTH_BITS);
+            for (unsigned int k = 0; width > 0 && k < length; k++) {
+                put_bits(&w, z[channel][start + k], width);
+            }
+        }
+    }
+    if (w.fill > 0) {
+        *w.out++ = (uint8_t)w.acc;
+    }
+    return bytes;
+}
+
+/**
+ * @brief Compressed payload bytes, from its header
+ */
+size_t iqCodec_encodedBytes(const uint8_t *in)
+{
+    return (size_t)in[0] | ((size_t)in[1] << 8);
+}
+
+/**
+ * @brief Decompress one packet
+ * @details Everything is checked against the datagram, so a corrupt or
+ *          truncated payload is rejected instead of read past.
+ *
+ * @param in compressed payload
+ * @param bytes payload bytes received
+ * @param count samples in the packet (the header's sampleCount)
+ * @param raw raw FIFO words out (count words)
+ * @return int 0 on success, -1 if the payload is malformed
+ */
+int iqCodec_decode(const uint8_t *in, size_t bytes, unsigned int count, uint32_t *raw)
+{
+    if (bytes < IQ_CODEC_HEADER_BYTES || iqCodec_encodedBytes(in) != bytes || in[3] != IQ_CODEC_BLOCK
+        || count > IQ_CODEC_MAX_SAMPLES) {
+        return -1;
+    }
+    if (in[2] == IQ_CODEC_STORED) {
+        if (bytes != IQ_CODEC_MAX_BYTES(count)) {
+            return -1;
+        }
+        memcpy(raw, in + IQ_CODEC_HEADER_BYTES, (size_t)count * 4);
+        return 0;
+    }
+    unsigned int orders[2] = { (in[2] >> 2) & 3u, in[2] & 3u };
+    if (in[2] > 0x0F || orders[0] > IQ_CODEC_MAX_ORDER || orders[1] > IQ_CODEC_MAX_ORDER) {
+        return -1;
+    }
+
+    bitReader r = { in + IQ_CODEC_HEADER_BYTES, in + bytes, 0, 0 };
+    memset(raw, 0, (size_t)count * 4);
+    for (int channel = 1; channel >= 0; channel--) {
+        int32_t p1 = 0;
+        int32_t p2 = 0;
+        unsigned int order = orders[channel];
+        for (unsigned int start = 0; start < count; start += IQ_CODEC_BLOCK) {
+            unsigned int length = (count - start < IQ_CODEC_BLOCK) ? count - start : IQ_CODEC_BLOCK;
+            uint32_t width;
+            if (get_bits(&r, WIDTH_BITS, &width) != 0 || width > 19) {
+                return -1; // order-2 residuals of int16 fit in 19 bits
+            }
+            for (unsigned int k = 0; k < length; k++) {
+                uint32_t value = 0;
+                if (width > 0 && get_bits(&r, width, &value) != 0) {
+                    return -1;
+                }
+                int32_t residual = unzigzag(value);
+                int32_t x = (order == 0) ? residual : (order == 1 ? p1 + residual : 2 * p1 - p2 + residual);
+                if (x < -32768 || x > 32767) {
+                    return -1;
+                }
+                raw[start + k] |= channel ? (uint32_t)(uint16_t)x << 16 : (uint16_t)x;
+                p2 = p1;
+                p1 = x;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Which residual kernel the encoder runs ("NEON" or "scalar")
+ */
+const char *iqCodec_backend(void)
+{
+#ifdef IQ_CODEC_NEON
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,54 @@
+/**
+ * @file iqCodec.h
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Lossless per-packet compression of raw FIFO words for thin uplinks
+ * @details The int16 I and Q samples rarely use all of their bits, and
+ *          neighbouring samples are close. Each channel of a packet is
+ *          predicted from the samples before it (order 0, 1 or 2, whichever
+ *          packs smallest, chosen per packet and channel), the zigzag-mapped
+ *          residuals are cut into blocks of IQ_CODEC_BLOCK, and every block is
+ *          bit-packed at the width of its largest residual. The residuals of
+ *          8 samples are computed per NEON step on the board.
+ *
+ *          Every packet is coded on its own (the predictors start from zero),
+ *          so a lost datagram never affects the packets after it. A packet
+ *          that would not shrink is stored as is.
+ *
+ *          Payload layout (little endian):
+ *
+ *              u16 bytes       compressed payload bytes, this header included
+ *              u8  mode        order of I in bits 0-1, of Q in bits 2-3;
+ *                              IQ_CODEC_STORED: raw words follow
+ *              u8  block       IQ_CODEC_BLOCK
+ *              bit stream      LSB first: for I, then for Q, every block is a
+ *                              5-bit width w and IQ_CODEC_BLOCK (fewer in the
+ *                              last block) residuals of w bits
+ *
+ *          Decoding gives back the raw FIFO words (SDR_FORMAT_CS16_QI).
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef _IQ_CODEC_H_
+#define _IQ_CODEC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define IQ_CODEC_BLOCK          16      // residuals per bit-packed block
+#define IQ_CODEC_HEADER_BYTES   4       // bytes, mode and block size
+#define IQ_CODEC_MAX_SAMPLES    4096    // most samples per packet
+#define IQ_CODEC_MAX_ORDER      2       // highest predictor order
+#define IQ_CODEC_STORED         0xFF    // mode of a packet sent uncompressed
+#define IQ_CODEC_MAX_BYTES(count) (IQ_CODEC_HEADER_BYTES + (size_t)(count) * 4) // worst case: stored
+
+/**  Function Prototype */
+size_t iqCodec_encode(const uint32_t *raw, unsigned int count, uint8_t *out);
+size_t iqCodec_encodedBytes(const uint8_t *in);
+int iqCodec_decode(const uint8_t *in, size_t bytes, unsigned int count, uint32_t *raw);
+const char *iqCodec_backend(void);
+
+#endif /* _IQ_CODEC_H_ */
@@ -0,0 +1,205 @@
+/**
+ * @file iqCodecBench.c
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Compression ratio and speed of the lossless IQ codec
+ * @details Encodes and decodes packets of test signals (or of a recording
+ *          with -f) over and over, checks that every packet comes back bit
+ *          exact, and prints the compression ratio and the encode and decode
+ *          rates in MB/s of raw samples. Runs without the FPGA.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+
+#include "iqCodec.h"
+
+#define DEFAULT_SAMPLES     256         // samples per packet, as the streamers
+#define DEFAULT_PACKETS     64          // distinct packets per signal
+#define DEFAULT_PASSES      200         // times each packet set is coded per measurement
+
+volatile uint32_t sink;                 // keeps the compiler from dropping the work
+
+void usage(const char *executableName);
+
+/**
+ * @brief Seconds since `start`
+ */
+static double seconds_since(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * @brief Uniform noise of +-amplitude
+ */
+static double noise(double amplitude)
+{
+    return amplitude * (2.0 * rand() / RAND_MAX - 1.0);
+}
+
+/**
+ * @brief A tone of `toneAmplitude` in noise of `noiseAmplitude`, as raw FIFO words
+ */
+static void make_signal(uint32_t *raw, size_t count, double toneAmplitude, double noiseAmplitude)
+{
+    for (size_t n = 0; n < count; n++) {
+        double phase = 2 * M_PI * 0.0123 * n;
+        long i = lround(toneAmplitude * cos(phase) + noise(noiseAmplitude));
+        long q = lround(toneAmplitude * sin(phase) + noise(noiseAmplitude));
+        i = i > 32767 ? 32767 : (i < -32768 ? -32768 : i);
+        q = q > 32767 ? 32767 : (q < -32768 ? -32768 : q);
+        raw[n] = ((uint32_t)(uint16_t)i << 16) | (uint16_t)q;
+    }
+}
+
+/**
+ * @brief Code the packets, check the round trip and print one result line
+ * @return int 0 if every packet decoded bit exact
+ */
+static int measure(const char *name, const uint32_t *raw, unsigned int numPackets, unsigned int numSamples,
+                   unsigned int numPasses)
+{
+    size_t slot = IQ_CODEC_MAX_BYTES(numSamples);
+    uint8_t *coded = malloc(slot * numPackets);
+    size_t *codedBytes = malloc(numPackets * sizeof(size_t));
+    uint32_t *decoded = malloc((size_t)numSamples * 4);
+    if (coded == NULL || codedBytes == NULL || decoded == NULL) {
+        fprintf(stderr, "Failed to allocate the buffers\n");
+        return -1;
+    }
+
+    size_t total = 0;
+    for (unsigned int p = 0; p < numPackets; p++) {
+        codedBytes[p] = iqCodec_encode(raw + (size_t)p * numSamples, numSamples, coded + p * slot);
+        total += codedBytes[p];
+        if (iqCodec_decode(coded + p * slot, codedBytes[p], numSamples, decoded) != 0
+            || memcmp(decoded, raw + (size_t)p * numSamples, (size_t)numSamples * 4) != 0) {
+            printf("%-16s ROUND TRIP FAILED at packet %u\n", name, p);
+            return -1;
+        }
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (unsigned int pass = 0; pass < numPasses; pass++) {
+        for (unsigned int p = 0; p < numPackets; p++) {
+            sink += iqCodec_encode(raw + (size_t)p * numSamples, numSamples, coded + p * slot);
+        }
+    }
+    double encodeSeconds = seconds_since(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (unsigned int pass = 0; pass < numPasses; pass++) {
+        for (unsigned int p = 0; p < numPackets; p++) {
+            sink += iqCodec_decode(coded + p * slot, codedBytes[p], numSamples, decoded) + decoded[p % numSamples];
+        }
+    }
+    double decodeSeconds = seconds_since(&start);
+
+    double rawMB = (double)numPasses * numPackets * numSamples * 4 / 1e6;
+    printf("%-16s ratio %5.2f (%6.1f bits/sample)  encode %7.1f MB/s  decode %7.1f MB/s\n", name,
+           (double)numPackets * numSamples * 4 / total, total * 8.0 / ((double)numPackets * numSamples),
+           rawMB / encodeSeconds, rawMB / decodeSeconds);
+
+    free(decoded);
+    free(codedBytes);
+    free(coded);
+    return 0;
+}
+
+int main(int argc, char const *argv[])
+{
+    unsigned int num_samples = DEFAULT_SAMPLES;
+    unsigned int num_packets = DEFAULT_PACKETS;
+    unsigned int num_passes = DEFAULT_PASSES;
+    const char *path = NULL;
+    int opt = 0;
+    while ((opt = getopt(argc, (char * const *)argv, "s:n:f:h")) != -1) {
+        switch (opt) {
+            case 's': num_samples = (unsigned int)atoi(optarg); break;
+            case 'n': num_passes = (unsigned int)atoi(optarg); break;
+            case 'f': path = optarg; break;
+            case 'h': usage(argv[0]); return 0;
+            default:  usage(argv[0]); return -1;
+        }
+    }
+    if (num_samples == 0 || num_samples > IQ_CODEC_MAX_SAMPLES || num_passes == 0) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    size_t count = (size_t)num_packets * num_samples;
+    uint32_t *raw = NULL;
+    if (path != NULL) {
+        // any file of 4-byte complex int16 samples: udpCapture -o output or a .sigmf-data recording
+        FILE *file = fopen(path, "rb");
+        if (file == NULL) {
+            perror("Failed to open the recording");
+            return -1;
+        }
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        num_packets = (unsigned int)(size / 4 / num_samples);
+        count = (size_t)num_packets * num_samples;
+        raw = malloc(count * 4 + 4);
+        if (num_packets == 0 || raw == NULL || fread(raw, 4, count, file) != count) {
+            fprintf(stderr, "The recording holds less than one packet\n");
+            fclose(file);
+            return -1;
+        }
+        fclose(file);
+    } else {
+        raw = malloc(count * 4);
+        if (raw == NULL) {
+            fprintf(stderr, "Failed to allocate the samples\n");
+            return -1;
+        }
+    }
+
+    printf("Coding %u packets of %u samples %u times, residuals: %s\n", num_packets, num_samples, num_passes,
+           iqCodec_backend());
+    if (path != NULL) {
+        return measure(path, raw, num_packets, num_samples, num_passes) == 0 ? 0 : -1;
+    }
+
+    static const struct
+    {
+        const char *name;
+        double tone;
+        double noise;
+    } signals[] = {
+        { "silence",        0,      0 },
+        { "weak tone",      300,    8 },
+        { "tone -20 dBFS",  3277,   64 },
+        { "tone -6 dBFS",   16384,  256 },
+        { "full-scale noise", 0,    32767 },
+    };
+    int rc = 0;
+    srand(1);
+    for (size_t s = 0; s < sizeof(signals) / sizeof(signals[0]); s++) {
+        make_signal(raw, count, signals[s].tone, signals[s].noise);
+        rc |= measure(signals[s].name, raw, num_packets, num_samples, num_passes);
+    }
+    free(raw);
+    return rc == 0 ? 0 : -1;
+}
+
+void usage(const char *executableName)
+{
+    printf("Usage: %s [-s <samples>] [-n <passes>] [-f <recording>]\n", executableName);
+    printf("  samples: samples per packet (default %d, up to %d)\n", DEFAULT_SAMPLES, IQ_CODEC_MAX_SAMPLES);
+    printf("  passes: times every packet is coded per measurement (default %d)\n", DEFAULT_PASSES);
+    printf("  recording: file of 4-byte complex int16 samples to code instead of the test signals\n");
+}
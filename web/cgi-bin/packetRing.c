@@ -0,0 +1,433 @@
+/**
+ * @file packetRing.c
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Lock-free single-producer/single-consumer packet ring
+ * @details See packetRing.h. The only blocking calls are the semaphores used to
+ *          put an idle consumer (or a producer in RING_BLOCK mode) to sleep;
+ *          the packet hand-off itself never waits on the other thread.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* Include */
+#include "packetRing.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+/**
+ * @brief Bump a counter that only the calling thread writes (no locked read-modify-write)
+ */
+static inline void count(atomic_ullong *counter)
+{
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + 1, memory_order_relaxed);
+}
+
+/**
+ * @brief Initialize an index queue that can hold at least `count` entries
+ *
+ * @param q queue
+ * @param count number of entries
+ * @return int 0 on success, -1 on allocation failure
+ */
+static int queue_init(ringQueue *q, unsigned int count)
+{
+    unsigned int capacity = 1;
+    while (capacity < count) {
+        capacity <<= 1; // round up to a power of two so the index can be masked
+    }
+    q->slots = calloc(capacity, sizeof(atomic_uint));
+    if (q->slots == NULL) {
+        return -1;
+    }
+    q->mask = capacity - 1;
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    return 0;
+}
+
+/**
+ * @brief Push a buffer index (only one thread pushes to a given queue)
+ * @details The queue is sized for every buffer in the ring, so a push can never
+ *          overwrite an entry that has not been popped.
+ */
+static void queue_push(ringQueue *q, unsigned int value)
+{
+    unsigned int head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    atomic_store_explicit(&q->slots[head & q->mask], value, memory_order_relaxed);
+    atomic_store_explicit(&q->head, head + 1, memory_order_release); // publish the entry and the buffer contents
+}
+
+/**
+ * @brief Pop the oldest buffer index
+ * @details tail is claimed with a compare-and-swap, so the producer may pop
+ *          from the ready queue concurrently with the consumer. Whoever wins
+ *          the CAS owns the buffer.
+ *
+ * @return int 1 if an index was popped, 0 if the queue is empty
+ */
+static int queue_pop(ringQueue *q, unsigned int *value)
+{
+    unsigned int tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    for (;;) {
+        unsigned int head = atomic_load_explicit(&q->head, memory_order_acquire);
+        if (tail == head) {
+            return 0; // empty
+        }
+        unsigned int v = atomic_load_explicit(&q->slots[tail & q->mask], memory_order_relaxed);
+        if (atomic_compare_exchange_weak_explicit(&q->tail, &tail, tail + 1,
+                                                  memory_order_acq_rel, memory_order_acquire)) {
+            *value = v;
+            return 1;
+        }
+        // tail was reloaded by the failed CAS, try again
+    }
+}
+
+/**
+ * @brief Stop waiting on a semaphore that may still owe a post
+ * @details A waker that cleared the flag has posted (or is about to post) the
+ *          semaphore, take that post back so the count never runs ahead.
+ */
+static void stop_waiting(atomic_int *waiting, sem_t *sem)
+{
+    if (!atomic_exchange(waiting, 0)) {
+        sem_trywait(sem);
+    }
+}
+
+/**
+ * @brief Sleep until the other side pushes to the queue
+ * @details The flag is raised before the queue is checked one last time, and
+ *          wake() checks the flag after pushing, so either the sleeper sees the
+ *          entry or the waker sees the flag. The semaphore is only posted for a
+ *          sleeper, so it never counts packets that were popped without waiting.
+ *
+ * @param q queue to pop from
+ * @param value popped index
+ * @param waiting flag of the sleeping side
+ * @param sem semaphore the other side posts
+ * @param deadline absolute CLOCK_REALTIME deadline, or NULL to wait forever
+ * @return int 1 if an index was popped, 0 to look again, -1 on timeout or error (errno set)
+ */
+static int sleep_for(ringQueue *q, unsigned int *value, atomic_int *waiting, sem_t *sem, const struct timespec *deadline)
+{
+    atomic_store_explicit(waiting, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst); // pairs with the fence in wake()
+    if (queue_pop(q, value)) {
+        stop_waiting(waiting, sem);
+        return 1;
+    }
+    int rc = (deadline != NULL) ? sem_timedwait(sem, deadline) : sem_wait(sem);
+    if (rc == 0) {
+        atomic_store_explicit(waiting, 0, memory_order_relaxed); // packetRing_close() posts without clearing it
+        return 0;
+    }
+    int err = errno;
+    stop_waiting(waiting, sem);
+    errno = err;
+    return (err == EINTR) ? 0 : -1;
+}
+
+/**
+ * @brief Post the semaphore if the other side sleeps on it (call after a push)
+ */
+static void wake(atomic_int *waiting, sem_t *sem)
+{
+    atomic_thread_fence(memory_order_seq_cst); // pairs with the fence in sleep_for()
+    if (atomic_load_explicit(waiting, memory_order_relaxed) && atomic_exchange(waiting, 0)) {
+        sem_post(sem);
+    }
+}
+
+/**
+ * @brief Initialize the ring and preallocate its buffers
+ *
+ * @param ring ring to initialize
+ * @param numSlots number of preallocated buffers (at least RING_MIN_SLOTS)
+ * @param bufferSize size of one buffer in bytes
+ * @param policy overrun policy
+ * @return int 0 on success, -1 on failure
+ */
+int packetRing_init(packetRing *ring, unsigned int numSlots, size_t bufferSize, ringOverrunPolicy policy)
+{
+    memset(ring, 0, sizeof(*ring));
+    if (numSlots < RING_MIN_SLOTS) {
+        fprintf(stderr, "Packet ring needs at least %d slots\n", RING_MIN_SLOTS);
+        return -1;
+    }
+
+    ring->numSlots = numSlots;
+    ring->policy = policy;
+    ring->stride = (bufferSize + RING_CACHE_LINE - 1) & ~((size_t)RING_CACHE_LINE - 1); // keep buffers on separate cache lines
+    atomic_init(&ring->closed, 0);
+    atomic_init(&ring->readyWaiting, 0);
+    atomic_init(&ring->freeWaiting, 0);
+
+    void *mem = NULL;
+    if (posix_memalign(&mem, RING_CACHE_LINE, ring->stride * numSlots) != 0) {
+        fprintf(stderr, "Failed to allocate packet ring buffers\n");
+        return -1;
+    }
+    ring->buffers = mem;
+    memset(ring->buffers, 0, ring->stride * numSlots); // touch every page up front
+
+    if (queue_init(&ring->ready, numSlots) != 0 || queue_init(&ring->free, numSlots) != 0) {
+        fprintf(stderr, "Failed to allocate packet ring queues\n");
+        packetRing_destroy(ring);
+        return -1;
+    }
+    if (sem_init(&ring->readySem, 0, 0) != 0 || sem_init(&ring->freeSem, 0, 0) != 0) {
+        perror("Failed to initialize packet ring semaphore");
+        packetRing_destroy(ring);
+        return -1;
+    }
+
+    // every buffer starts out free, the producer takes the first one
+    for (unsigned int i = 1; i < numSlots; i++) {
+        queue_push(&ring->free, i);
+    }
+    ring->fill = 0;
+
+    return 0;
+}
+
+/**
+ * @brief Pin the packet buffers in RAM
+ * @details Zero-copy sends read straight from the buffers, so they should
+ *          never be paged out or faulted in on the send path.
+ *
+ * @return int 0 on success, -1 if mlock() failed (e.g. RLIMIT_MEMLOCK)
+ */
+int packetRing_lock(packetRing *ring)
+{
+    if (mlock(ring->buffers, ring->stride * ring->numSlots) != 0) {
+        perror("Failed to lock packet ring buffers");
+        return -1;
+    }
+    ring->locked = 1;
+    return 0;
+}
+
+/**
+ * @brief Release the ring memory (both threads must have stopped)
+ */
+void packetRing_destroy(packetRing *ring)
+{
+    if (ring->locked) {
+        munlock(ring->buffers, ring->stride * ring->numSlots);
+        ring->locked = 0;
+    }
+    sem_destroy(&ring->readySem);
+    sem_destroy(&ring->freeSem);
+    free(ring->ready.slots);
+    free(ring->free.slots);
+    free(ring->buffers);
+    ring->ready.slots = NULL;
+    ring->free.slots = NULL;
+    ring->buffers = NULL;
+}
+
+/**
+ * @brief Shut the ring down and wake both sides
+ * @details The consumer still receives the packets that are already queued.
+ */
+void packetRing_close(packetRing *ring)
+{
+    atomic_store(&ring->closed, 1);
+    sem_post(&ring->readySem);
+    sem_post(&ring->freeSem);
+}
+
+/**
+ * @brief Get the buffer the producer is currently filling
+ * @details The pointer stays valid until the next packetRing_publish().
+ */
+void *packetRing_acquire(packetRing *ring)
+{
+    return ring->buffers + (size_t)ring->fill * ring->stride;
+}
+
+/**
+ * @brief Hand the filled buffer to the consumer and move on to a free one
+ * @details When no free buffer is left the overrun policy decides what happens:
+ *          RING_DROP_NEWEST keeps the current buffer (the packet is discarded),
+ *          RING_DROP_OLDEST publishes it and reclaims the oldest queued packet,
+ *          RING_BLOCK waits for the consumer to release a buffer.
+ *
+ * @return int 0 on success, -1 if the ring was closed while waiting
+ */
+int packetRing_publish(packetRing *ring)
+{
+    unsigned int next;
+
+    if (queue_pop(&ring->free, &next)) {
+        queue_push(&ring->ready, ring->fill);
+        ring->fill = next;
+        count(&ring->stats.producer.published);
+        wake(&ring->readyWaiting, &ring->readySem); // wake the consumer if it sleeps
+        return 0;
+    }
+
+    switch (ring->policy) {
+        case RING_DROP_NEWEST:
+            count(&ring->stats.producer.droppedNewest); // the current buffer gets overwritten by the next packet
+            return 0;
+
+        case RING_DROP_OLDEST:
+            queue_push(&ring->ready, ring->fill);
+            count(&ring->stats.producer.published);
+            wake(&ring->readyWaiting, &ring->readySem);
+            for (;;) {
+                if (queue_pop(&ring->ready, &next)) {
+                    count(&ring->stats.producer.droppedOldest); // reclaimed a packet the consumer never saw
+                    ring->fill = next;
+                    return 0;
+                }
+                if (queue_pop(&ring->free, &next)) {
+                    ring->fill = next; // the consumer released a buffer in the meantime
+                    return 0;
+                }
+                if (atomic_load(&ring->closed)) {
+                    return -1;
+                }
+                sched_yield(); // every other buffer is held by the consumer
+            }
+
+        case RING_BLOCK:
+        default:
+            count(&ring->stats.producer.blocked);
+            while (!queue_pop(&ring->free, &next)) {
+                if (atomic_load(&ring->closed)) {
+                    return -1;
+                }
+                int rc = sleep_for(&ring->free, &next, &ring->freeWaiting, &ring->freeSem, NULL);
+                if (rc > 0) {
+                    break;
+                }
+                if (rc < 0) {
+                    return -1;
+                }
+            }
+            queue_push(&ring->ready, ring->fill);
+            ring->fill = next;
+            count(&ring->stats.producer.published);
+            wake(&ring->readyWaiting, &ring->readySem);
+            return 0;
+    }
+}
+
+/**
+ * @brief Count a popped packet and return its buffer
+ */
+static void *take(packetRing *ring, unsigned int idx)
+{
+    count(&ring->stats.consumer.consumed);
+    return ring->buffers + (size_t)idx * ring->stride;
+}
+
+/**
+ * @brief Pop the oldest published packet without blocking
+ *
+ * @return void* packet buffer, or NULL if nothing is queued
+ */
+void *packetRing_pop(packetRing *ring)
+{
+    unsigned int idx;
+    if (!queue_pop(&ring->ready, &idx)) {
+        return NULL;
+    }
+    return take(ring, idx);
+}
+
+/**
+ * @brief Pop the oldest published packet, sleeping until one is available
+ *
+ * @param ring ring
+ * @param deadline absolute CLOCK_REALTIME deadline, or NULL to wait forever
+ * @return void* packet buffer, or NULL with errno set to ETIMEDOUT (deadline
+ *         expired) or ECANCELED (ring closed and empty)
+ */
+void *packetRing_wait(packetRing *ring, const struct timespec *deadline)
+{
+    for (;;) {
+        void *buffer = packetRing_pop(ring);
+        if (buffer != NULL) {
+            return buffer;
+        }
+        if (atomic_load(&ring->closed)) {
+            errno = ECANCELED;
+            return NULL;
+        }
+        // a wake-up may find the queue empty when the producer reclaimed the packet, so loop
+        unsigned int idx;
+        int rc = sleep_for(&ring->ready, &idx, &ring->readyWaiting, &ring->readySem, deadline);
+        if (rc > 0) {
+            return take(ring, idx);
+        }
+        if (rc < 0) {
+            return NULL; // ETIMEDOUT or a real error
+        }
+    }
+}
+
+/**
+ * @brief Give a popped buffer back to the producer
+ */
+void packetRing_release(packetRing *ring, void *buffer)
+{
+    unsigned int idx = (unsigned int)(((unsigned char *)buffer - ring->buffers) / ring->stride);
+    queue_push(&ring->free, idx);
+    if (ring->policy == RING_BLOCK) {
+        wake(&ring->freeWaiting, &ring->freeSem); // only a blocking producer ever sleeps on this
+    }
+}
+
+/**
+ * @brief Number of packets waiting for the consumer
+ */
+unsigned int packetRing_depth(packetRing *ring)
+{
+    unsigned int head = atomic_load_explicit(&ring->ready.head, memory_order_acquire);
+    unsigned int tail = atomic_load_explicit(&ring->ready.tail, memory_order_acquire);
+    return head - tail;
+}
+
+/**
+ * @brief Parse an overrun policy name (oldest, newest, block)
+ *
+ * @return int 0 on success, -1 if the name is unknown
+ */
+int packetRing_parsePolicy(const char *name, ringOverrunPolicy *policy)
+{
+    if (strcmp(name, "oldest") == 0) {
+        *policy = RING_DROP_OLDEST;
+    } else if (strcmp(name, "newest") == 0) {
+        *policy = RING_DROP_NEWEST;
+    } else if (strcmp(name, "block") == 0) {
+        *policy = RING_BLOCK;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Human readable overrun policy name
+ */
+const char *packetRing_policyName(ringOverrunPolicy policy)
+{
+    switch (policy) {
+        case RING_DROP_OLDEST: return "drop-oldest";
+        case RING_DROP_NEWEST: return "drop-newest";
+        case RING_BLOCK:       return "block";
+        default:               return "unknown";
+    }
+}
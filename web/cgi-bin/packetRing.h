@@ -0,0 +1,117 @@
+/**
+ * @file packetRing.h
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Lock-free single-producer/single-consumer packet ring
+ * @details The ring owns a pool of preallocated packet buffers. Buffers move
+ *          between two index queues: the "ready" queue (filled packets waiting
+ *          to be sent) and the "free" queue (buffers the producer may fill).
+ *          The producer (FIFO reader) always owns exactly one buffer that it is
+ *          filling, the consumer (UDP sender) owns the buffers it popped until
+ *          it releases them. No buffer is ever written while someone else owns
+ *          it, so neither side takes a lock.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef _PACKET_RING_H_
+#define _PACKET_RING_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <semaphore.h>
+#include <time.h>
+
+#define RING_CACHE_LINE         64  // keep producer and consumer indices on separate cache lines
+#define RING_DEFAULT_SLOTS      64  // default number of preallocated packets
+#define RING_MIN_SLOTS          3   // one filling, one sending, at least one queued
+
+/**
+ * @brief What the producer does when every buffer is in use
+ */
+typedef enum ringOverrunPolicy
+{
+    RING_DROP_OLDEST = 0,   // reclaim the oldest unsent packet (keeps latency bounded)
+    RING_DROP_NEWEST,       // discard the packet that was just filled
+    RING_BLOCK              // wait until the consumer releases a buffer
+} ringOverrunPolicy;
+
+/**
+ * @brief Bounded queue of buffer indices
+ * @details head is only advanced by the pushing side, tail is advanced with a
+ *          compare-and-swap so the producer can reclaim the oldest entry of the
+ *          ready queue while the consumer is popping from it.
+ */
+typedef struct ringQueue
+{
+    _Alignas(RING_CACHE_LINE) atomic_uint head; // next position to write
+    _Alignas(RING_CACHE_LINE) atomic_uint tail; // next position to read
+    _Alignas(RING_CACHE_LINE) unsigned int mask; // capacity - 1 (capacity is a power of two)
+    atomic_uint *slots;                          // buffer indices
+} ringQueue;
+
+/**
+ * @brief Ring counters, each block written by a single thread on its own cache line
+ * @details Counters are relaxed atomics so the other thread (or the metrics)
+ *          may read them at any time; read them with packetRing_count().
+ */
+typedef struct ringStats
+{
+    _Alignas(RING_CACHE_LINE) struct {
+        atomic_ullong published;        // packets handed to the consumer
+        atomic_ullong droppedOldest;    // queued packets reclaimed before being sent
+        atomic_ullong droppedNewest;    // filled packets discarded because the ring was full
+        atomic_ullong blocked;          // times the producer had to wait for a free buffer
+    } producer;
+    _Alignas(RING_CACHE_LINE) struct {
+        atomic_ullong consumed;         // packets popped by the consumer
+    } consumer;
+} ringStats;
+
+/**
+ * @brief Packet ring
+ */
+typedef struct packetRing
+{
+    ringQueue ready;                // filled packets, producer -> consumer
+    ringQueue free;                 // empty buffers, consumer -> producer
+    _Alignas(RING_CACHE_LINE) unsigned char *buffers; // numSlots * stride bytes
+    size_t stride;                  // bytes per buffer (cache line aligned)
+    unsigned int numSlots;          // number of preallocated buffers
+    unsigned int fill;              // buffer currently owned by the producer
+    ringOverrunPolicy policy;       // overrun policy
+    int locked;                     // buffers are pinned with mlock()
+    atomic_int closed;              // set once the ring is shut down
+    sem_t readySem;                 // wakes the consumer when a packet is published
+    sem_t freeSem;                  // wakes a blocked producer when a buffer is released
+    atomic_int readyWaiting;        // the consumer is (about to go) asleep on readySem
+    atomic_int freeWaiting;         // the producer is (about to go) asleep on freeSem
+    ringStats stats;                // counters
+} packetRing;
+
+/**  Function Prototype */
+int packetRing_init(packetRing *ring, unsigned int numSlots, size_t bufferSize, ringOverrunPolicy policy);
+int packetRing_lock(packetRing *ring);
+void packetRing_destroy(packetRing *ring);
+void packetRing_close(packetRing *ring);
+void *packetRing_acquire(packetRing *ring);
+int packetRing_publish(packetRing *ring);
+void *packetRing_pop(packetRing *ring);
+void *packetRing_wait(packetRing *ring, const struct timespec *deadline);
+void packetRing_release(packetRing *ring, void *buffer);
+unsigned int packetRing_depth(packetRing *ring);
+int packetRing_parsePolicy(const char *name, ringOverrunPolicy *policy);
+const char *packetRing_policyName(ringOverrunPolicy policy);
+
+/**
+ * @brief Read a ring counter from any thread
+ */
+static inline uint64_t packetRing_count(const atomic_ullong *counter)
+{
+    return atomic_load_explicit((atomic_ullong *)counter, memory_order_relaxed);
+}
+
+#endif /* _PACKET_RING_H_ */
@@ -0,0 +1,72 @@
+/**
+ * @file radioClient.c
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Client side of the radioDaemon socket
+ * @details See radioClient.h.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* Include */
+#include "radioClient.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+/**
+ * @brief Send a request to the daemon and wait for its reply
+ *
+ * @param socketPath daemon socket (NULL: $RADIO_DAEMON_SOCKET if set, else RADIO_DAEMON_SOCKET)
+ * @param request commands, one per line
+ * @param reply reply out, null-terminated, one line per command
+ * @param replySize size of reply
+ * @param roundTripUs time from connect to reply in microseconds out (may be NULL)
+ * @return int 0 on success, -1 if the daemon could not be reached or did not answer
+ */
+int radioClient_request(const char *socketPath, const char *request, char *reply, size_t replySize,
+                        double *roundTripUs)
+{
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if (socketPath == NULL) {
+        socketPath = getenv("RADIO_DAEMON_SOCKET");
+    }
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", socketPath != NULL ? socketPath : RADIO_DAEMON_SOCKET);
+
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    struct timeval tv = { RADIO_DAEMON_TIMEOUT_MS / 1000, (RADIO_DAEMON_TIMEOUT_MS % 1000) * 1000 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0
+        || send(fd, request, strlen(request), 0) < 0) {
+        close(fd);
+        return -1;
+    }
+    ssize_t len = recv(fd, reply, replySize - 1, 0);
+    close(fd);
+    if (len <= 0) {
+        return -1;
+    }
+    reply[len] = '\0';
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (roundTripUs != NULL) {
+        *roundTripUs = (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) / 1e3;
+    }
+    return 0;
+}
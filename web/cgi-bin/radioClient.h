@@ -0,0 +1,25 @@
+/**
+ * @file radioClient.h
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Client side of the radioDaemon socket
+ * @details Sends one request (a batch of newline-separated commands, see
+ *          radioDaemon.h) and waits for the reply. Used by the CGI programs.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef _RADIO_CLIENT_H_
+#define _RADIO_CLIENT_H_
+
+#include <stddef.h>
+
+#include "radioDaemon.h"
+
+/**  Function Prototype */
+int radioClient_request(const char *socketPath, const char *request, char *reply, size_t replySize,
+                        double *roundTripUs);
+
+#endif /* _RADIO_CLIENT_H_ */
@@ -0,0 +1,387 @@
+/**
+ * @file radioDaemon.c
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Long-lived owner of the radio tuner registers
+ * @details Maps the radio tuner once and serves tuning and control requests on
+ *          a local socket (see radioDaemon.h for the protocol). Every command
+ *          is timed from the arrival of its request; the counts, mean and worst
+ *          latency per command are answered by STATS and printed on exit.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* Include */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "radioDaemon.h"
+#include "radioTuner.h"
+
+/* Definitions */
+/**
+ * @brief Commands of the protocol
+ */
+typedef enum radioCommand
+{
+    RADIO_CMD_TUNE = 0,
+    RADIO_CMD_ADC,
+    RADIO_CMD_STREAM,
+    RADIO_CMD_RESET,
+    RADIO_CMD_STATUS,
+    RADIO_CMD_STATS,
+    RADIO_CMD_COUNT
+} radioCommand;
+
+static const char *command_names[RADIO_CMD_COUNT] = { "TUNE", "ADC", "STREAM", "RESET", "STATUS", "STATS" };
+
+/**
+ * @brief Latency counters of one command
+ */
+typedef struct commandStats
+{
+    uint64_t count;             // commands applied
+    uint64_t errors;            // commands refused
+    uint64_t totalNs;           // sum of their latencies
+    uint64_t maxNs;             // worst latency
+} commandStats;
+
+/** Global Variables */
+volatile unsigned int *radio = NULL;            // Radio tuner registers, mapped once
+unsigned int simulated_regs[4];                 // Registers of -x, no FPGA needed
+const char *socket_path = RADIO_DAEMON_SOCKET;  // Where the clients connect
+commandStats command_stats[RADIO_CMD_COUNT];    // Latency per command
+uint64_t requests = 0;                          // Requests answered
+uint64_t batched = 0;                           // Requests with more than one command
+volatile sig_atomic_t terminate = 0;            // Termination flag
+
+/** Function Prototypes */
+void usage(const char *executableName);
+void signalHandler(int sig);
+
+static uint64_t ns_since(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)((now.tv_sec - start->tv_sec) * 1000000000LL + (now.tv_nsec - start->tv_nsec));
+}
+
+/**
+ * @brief Parse a 0|1 argument
+ */
+static int parse_bool(const char *arg, bool *value)
+{
+    if (arg == NULL || (strcmp(arg, "0") != 0 && strcmp(arg, "1") != 0)) {
+        return -1;
+    }
+    *value = (arg[0] == '1');
+    return 0;
+}
+
+/**
+ * @brief Parse a frequency argument in Hz
+ */
+static int parse_hz(const char *arg, double *hz)
+{
+    char *end = NULL;
+    if (arg == NULL) {
+        return -1;
+    }
+    *hz = strtod(arg, &end);
+    // anything past half the 125 MHz clock aliases
+    return (end == arg || *end != '\0' || *hz < -RADIO_TIMER_HZ / 2.0 || *hz > RADIO_TIMER_HZ / 2.0) ? -1 : 0;
+}
+
+/**
+ * @brief Apply one command line and append its reply line
+ */
+static void run_command(char *line, const struct timespec *arrival, char *reply, size_t replySize)
+{
+    size_t used = strlen(reply);
+    char *out = reply + used;
+    size_t outSize = replySize - used;
+    char *save = NULL;
+    char *verb = strtok_r(line, " \t", &save);
+    char *arg = strtok_r(NULL, " \t", &save);
+    char *extra = strtok_r(NULL, " \t", &save);
+
+    int cmd = 0;
+    while (cmd < RADIO_CMD_COUNT && strcmp(verb, command_names[cmd]) != 0) {
+        cmd++;
+    }
+    if (cmd == RADIO_CMD_COUNT) {
+        snprintf(out, outSize, "ERR unknown command %s\n", verb);
+        return;
+    }
+
+    double hz = 0;
+    bool on = false;
+    bool needsArg = (cmd == RADIO_CMD_TUNE || cmd == RADIO_CMD_ADC || cmd == RADIO_CMD_STREAM || cmd == RADIO_CMD_RESET);
+    if (extra != NULL || (needsArg && arg == NULL) || (!needsArg && arg != NULL)
+        || ((cmd == RADIO_CMD_TUNE || cmd == RADIO_CMD_ADC) && parse_hz(arg, &hz) != 0)
+        || ((cmd == RADIO_CMD_STREAM || cmd == RADIO_CMD_RESET) && parse_bool(arg, &on) != 0)) {
+        snprintf(out, outSize, "ERR usage: TUNE <hz> | ADC <hz> | STREAM 0|1 | RESET 0|1 | STATUS | STATS\n");
+        command_stats[cmd].errors++;
+        return;
+    }
+
+    // every write is read back, so the latency covers the write reaching the peripheral
+    char fields[RADIO_DAEMON_MSG_MAX / 2] = "";
+    switch (cmd) {
+        case RADIO_CMD_TUNE:
+            radioTuner_setTunerHz(radio, hz);
+            radioTuner_getTunerPinc(radio);
+            break;
+        case RADIO_CMD_ADC:
+            radioTuner_setAdcHz(radio, hz);
+            radioTuner_getAdcPinc(radio);
+            break;
+        case RADIO_CMD_STREAM:
+            radioTuner_setStream(radio, on);
+            radioTuner_getControl(radio);
+            break;
+        case RADIO_CMD_RESET:
+            radioTuner_setReset(radio, on);
+            radioTuner_getControl(radio);
+            break;
+        case RADIO_CMD_STATUS: {
+            uint32_t control = radioTuner_getControl(radio);
+            snprintf(fields, sizeof(fields), " adc=%.1f tune=%.1f reset=%u stream=%u timer=%u",
+                     radioTuner_pincToHz(radioTuner_getAdcPinc(radio)),
+                     radioTuner_pincToHz(radioTuner_getTunerPinc(radio)),
+                     (control & RADIO_TUNER_CTRL_RESET_MASK) ? 1u : 0u,
+                     (control & RADIO_TUNER_CTRL_STREAM_EN_MASK) ? 1u : 0u, radioTuner_getTimer(radio));
+            break;
+        }
+        case RADIO_CMD_STATS: {
+            int n = snprintf(fields, sizeof(fields), " requests=%llu", (unsigned long long)requests);
+            for (int c = 0; c < RADIO_CMD_COUNT && n > 0 && (size_t)n < sizeof(fields); c++) {
+                const commandStats *s = &command_stats[c];
+                if (s->count > 0) {
+                    // <command>=<count>/<mean us>/<max us>
+                    n += snprintf(fields + n, sizeof(fields) - n, " %s=%llu/%.1f/%.1f", command_names[c],
+                                  (unsigned long long)s->count, s->totalNs / 1e3 / s->count, s->maxNs / 1e3);
+                }
+            }
+            break;
+        }
+    }
+
+    uint64_t ns = ns_since(arrival);
+    commandStats *s = &command_stats[cmd];
+    s->count++;
+    s->totalNs += ns;
+    s->maxNs = ns > s->maxNs ? ns : s->maxNs;
+    snprintf(out, outSize, "OK %.1f%s\n", ns / 1e3, fields);
+}
+
+/**
+ * @brief Answer one request of a client
+ * @return int 0 to keep the connection, -1 to close it
+ */
+static int handle_request(int fd)
+{
+    char msg[RADIO_DAEMON_MSG_MAX + 1];
+    char reply[RADIO_DAEMON_MSG_MAX];
+    // MSG_TRUNC returns the full length of a message that did not fit
+    ssize_t len = recv(fd, msg, RADIO_DAEMON_MSG_MAX, MSG_TRUNC);
+    struct timespec arrival;
+    clock_gettime(CLOCK_MONOTONIC, &arrival);
+    if (len <= 0) {
+        return -1; // closed by the client
+    }
+    requests++;
+    reply[0] = '\0';
+
+    if (len > RADIO_DAEMON_MSG_MAX) {
+        snprintf(reply, sizeof(reply), "ERR request longer than %d bytes\n", RADIO_DAEMON_MSG_MAX);
+    } else {
+        msg[len] = '\0';
+        char *lines[RADIO_DAEMON_MAX_BATCH];
+        unsigned int count = 0;
+        char *save = NULL;
+        for (char *line = strtok_r(msg, "\r\n", &save); line != NULL; line = strtok_r(NULL, "\r\n", &save)) {
+            if (line[strspn(line, " \t")] == '\0') {
+                continue; // blank line
+            }
+            if (count == RADIO_DAEMON_MAX_BATCH) {
+                count++;
+                break;
+            }
+            lines[count++] = line;
+        }
+        if (count == 0 || count > RADIO_DAEMON_MAX_BATCH) {
+            snprintf(reply, sizeof(reply), "ERR 1 to %d commands per request\n", RADIO_DAEMON_MAX_BATCH);
+        } else {
+            batched += (count > 1);
+            for (unsigned int i = 0; i < count; i++) {
+                run_command(lines[i], &arrival, reply, sizeof(reply));
+            }
+        }
+    }
+    return send(fd, reply, strlen(reply), MSG_NOSIGNAL) < 0 ? -1 : 0;
+}
+
+/**
+ * @brief Create the listening socket, refuse to start twice
+ */
+static int open_socket(const char *path)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (fd < 0) {
+        perror("Failed to create the socket");
+        return -1;
+    }
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+        fprintf(stderr, "Another radioDaemon is serving %s\n", path);
+        close(fd);
+        return -1;
+    }
+    close(fd);
+
+    unlink(path); // left behind by a daemon that was killed
+    fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, RADIO_DAEMON_MAX_CLIENTS) != 0) {
+        perror("Failed to listen on the socket");
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Print the latency of every command
+ */
+static void print_stats(void)
+{
+    printf("Radio daemon summary:\n");
+    printf("    Requests: %llu (%llu batched)\n", (unsigned long long)requests, (unsigned long long)batched);
+    for (int c = 0; c < RADIO_CMD_COUNT; c++) {
+        const commandStats *s = &command_stats[c];
+        if (s->count > 0 || s->errors > 0) {
+            printf("    %-6s: %llu applied, %llu refused, mean %.1f us, max %.1f us\n", command_names[c],
+                   (unsigned long long)s->count, (unsigned long long)s->errors,
+                   s->count ? s->totalNs / 1e3 / s->count : 0.0, s->maxNs / 1e3);
+        }
+    }
+}
+
+int main(int argc, char const *argv[])
+{
+    int opt = 0;
+    bool simulate = false;
+    while ((opt = getopt(argc, (char * const *)argv, "s:xh")) != -1) {
+        switch (opt) {
+            case 's':
+                socket_path = optarg; break;
+            case 'x':
+                simulate = true; break;
+            case 'h':
+                usage(argv[0]); return 0;
+            default:
+                usage(argv[0]); return -1;
+        }
+    }
+
+    radio = simulate ? simulated_regs : radioTuner_open();
+    if (radio == NULL) {
+        return -1;
+    }
+    int listenFd = open_socket(socket_path);
+    if (listenFd < 0) {
+        if (!simulate) {
+            radioTuner_close(radio);
+        }
+        return -1;
+    }
+
+    // stop cleanly on Ctrl-C / kill so the summary gets printed
+    struct sigaction sigact;
+    memset(&sigact, 0, sizeof(sigact));
+    sigact.sa_handler = signalHandler;
+    sigaction(SIGINT, &sigact, NULL);
+    sigaction(SIGTERM, &sigact, NULL);
+
+    printf("Radio daemon listening on %s%s\n", socket_path, simulate ? " (simulated registers)" : "");
+    struct pollfd fds[1 + RADIO_DAEMON_MAX_CLIENTS];
+    unsigned int numClients = 0;
+    fds[0].fd = listenFd;
+    fds[0].events = POLLIN;
+    while (!terminate) {
+        if (poll(fds, 1 + numClients, -1) < 0) {
+            if (errno != EINTR) {
+                perror("poll failed");
+                break;
+            }
+            continue;
+        }
+        for (unsigned int i = 1; i <= numClients; i++) {
+            if (fds[i].revents == 0) {
+                continue;
+            }
+            if ((fds[i].revents & POLLIN) == 0 || handle_request(fds[i].fd) != 0) {
+                close(fds[i].fd);
+                fds[i--] = fds[numClients--]; // look at the one moved here next
+            }
+        }
+        if (fds[0].revents & POLLIN) {
+            int fd = accept(listenFd, NULL, NULL);
+            if (fd >= 0 && numClients == RADIO_DAEMON_MAX_CLIENTS) {
+                close(fd); // the client sees the connection drop and retries later
+            } else if (fd >= 0) {
+                numClients++;
+                fds[numClients].fd = fd;
+                fds[numClients].events = POLLIN;
+                fds[numClients].revents = 0;
+            }
+        }
+    }
+
+    for (unsigned int i = 1; i <= numClients; i++) {
+        close(fds[i].fd);
+    }
+    close(listenFd);
+    unlink(socket_path);
+    print_stats();
+    if (!simulate) {
+        radioTuner_close(radio);
+    }
+    return 0;
+}
+
+void signalHandler(int sig)
+{
+    (void)sig;
+    terminate = 1;
+}
+
+void usage(const char *executableName)
+{
+    fprintf(stderr, "Usage: %s [-s <socket>] [-x]\n\n", executableName);
+    fprintf(stderr, "  -s <socket>          : Socket the clients connect to (default: %s)\n\n", RADIO_DAEMON_SOCKET);
+    fprintf(stderr, "  -x                   : Simulate the registers in memory, no FPGA needed (for testing clients)\n\n");
+    fprintf(stderr, "  -h                   : Show this help message\n\n");
+}
@@ -0,0 +1,42 @@
+/**
+ * @file radioDaemon.h
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Long-lived owner of the radio tuner registers
+ * @details radioDaemon maps the radio once and applies tuning and control
+ *          commands that arrive on a local SOCK_SEQPACKET socket, so a click
+ *          in the web page costs a connect and a message instead of a process
+ *          that opens /dev/mem, maps the page and unmaps it again. It is the
+ *          only writer of the control register, so its read-modify-writes no
+ *          longer race.
+ *
+ *          A request is one message of up to RADIO_DAEMON_MAX_BATCH commands,
+ *          one per line, applied in order:
+ *
+ *              TUNE <hz>       mixer (center) frequency, may be negative
+ *              ADC <hz>        fake ADC tone frequency
+ *              STREAM 0|1      stream enable bit
+ *              RESET 0|1       hold the tuner in reset (1) or let it run (0)
+ *              STATUS          frequencies, control bits and timer
+ *              STATS           per-command latency counters
+ *
+ *          The reply is one message with one line per command, in the same
+ *          order: `OK <us> [fields]` or `ERR <reason>`, where <us> is the time
+ *          from the arrival of the request until the command was done.
+ *          Connections may stay open for more requests.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef _RADIO_DAEMON_H_
+#define _RADIO_DAEMON_H_
+
+#define RADIO_DAEMON_SOCKET         "/var/run/radioDaemon.sock" // default socket path
+#define RADIO_DAEMON_MSG_MAX        1024        // longest request or reply
+#define RADIO_DAEMON_MAX_BATCH      16          // commands per request
+#define RADIO_DAEMON_MAX_CLIENTS    16          // connections served at once
+#define RADIO_DAEMON_TIMEOUT_MS     1000        // longest wait of a client for its reply
+
+#endif /* _RADIO_DAEMON_H_ */
@@ -0,0 +1,154 @@
+/**
+ * @file radioTuner.c
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Access to the radio tuner peripheral
+ * @details See radioTuner.h.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* Include */
+#include "radioTuner.h"
+#include "axiFifo.h"
+
+#include <stdio.h>
+#include <sys/mman.h>
+
+/**
+ * @brief Map the radio tuner registers
+ *
+ * @return volatile unsigned int* register base, NULL on failure
+ */
+volatile unsigned int * radioTuner_open(void)
+{
+    volatile unsigned int *radio = get_a_pointer(RADIO_PERIPH_ADDRESS);
+    if (radio == NULL) {
+        fprintf(stderr, "Failed to map radio tuner base address\n");
+    }
+    return radio;
+}
+
+/**
+ * @brief Unmap the radio tuner registers
+ */
+void radioTuner_close(volatile unsigned int *radio)
+{
+    if (radio != NULL) {
+        munmap((void *)radio, AXI_FIFO_MAP_SIZE);
+    }
+}
+
+/**
+ * @brief Read the free-running timer (RADIO_TIMER_HZ, wraps every 34 s)
+ */
+uint32_t radioTuner_getTimer(volatile unsigned int *radio)
+{
+    return radio[RADIO_TUNER_TIMER_REG_OFFSET];
+}
+
+/**
+ * @brief Read the fake ADC phase increment
+ */
+uint32_t radioTuner_getAdcPinc(volatile unsigned int *radio)
+{
+    return radio[RADIO_TUNER_FAKE_ADC_PINC_OFFSET];
+}
+
+/**
+ * @brief Read the mixer phase increment
+ */
+uint32_t radioTuner_getTunerPinc(volatile unsigned int *radio)
+{
+    return radio[RADIO_TUNER_TUNER_PINC_OFFSET];
+}
+
+/**
+ * @brief Read the control register (RADIO_TUNER_CTRL_*)
+ */
+uint32_t radioTuner_getControl(volatile unsigned int *radio)
+{
+    return radio[RADIO_TUNER_CONTROL_REG_OFFSET];
+}
+
+/**
+ * @brief Set the fake ADC frequency
+ */
+void radioTuner_setAdcHz(volatile unsigned int *radio, double hz)
+{
+    radio[RADIO_TUNER_FAKE_ADC_PINC_OFFSET] = radioTuner_hzToPinc(hz);
+}
+
+/**
+ * @brief Set the mixer frequency
+ */
+void radioTuner_setTunerHz(volatile unsigned int *radio, double hz)
+{
+    radio[RADIO_TUNER_TUNER_PINC_OFFSET] = radioTuner_hzToPinc(hz);
+}
+
+/**
+ * @brief Set the mixer phase increment, for callers that precompute it
+ */
+void radioTuner_setTunerPinc(volatile unsigned int *radio, uint32_t pinc)
+{
+    radio[RADIO_TUNER_TUNER_PINC_OFFSET] = pinc;
+}
+
+/**
+ * @brief Hold the tuner in reset or let it run
+ */
+void radioTuner_setReset(volatile unsigned int *radio, bool reset)
+{
+    if (reset) {
+        radio[RADIO_TUNER_CONTROL_REG_OFFSET] |= RADIO_TUNER_CTRL_RESET_MASK;
+    } else {
+        radio[RADIO_TUNER_CONTROL_REG_OFFSET] &= ~RADIO_TUNER_CTRL_RESET_MASK;
+    }
+}
+
+/**
+ * @brief Turn the sample stream into the FIFO on or off
+ */
+void radioTuner_setStream(volatile unsigned int *radio, bool enable)
+{
+    if (enable) {
+        radio[RADIO_TUNER_CONTROL_REG_OFFSET] |= RADIO_TUNER_CTRL_STREAM_EN_MASK;
+    } else {
+        radio[RADIO_TUNER_CONTROL_REG_OFFSET] &= ~RADIO_TUNER_CTRL_STREAM_EN_MASK;
+    }
+}
+
+/**
+ * @brief Convert a phase increment to a frequency
+ * @details The accumulators are RADIO_PHASE_BITS wide, so increments past half
+ *          of the range are negative frequencies (the mixer is usually tuned
+ *          with one).
+ *
+ * @param pinc phase increment register value
+ * @return double frequency in Hz
+ */
+double radioTuner_pincToHz(uint32_t pinc)
+{
+    int32_t phase = (int32_t)(pinc & ((1u << RADIO_PHASE_BITS) - 1));
+    if (phase >= (1 << (RADIO_PHASE_BITS - 1))) {
+        phase -= (1 << RADIO_PHASE_BITS);
+    }
+    return phase * (double)RADIO_TIMER_HZ / (1 << RADIO_PHASE_BITS);
+}
+
+/**
+ * @brief Convert a frequency to a phase increment, rounded to the nearest step
+ * @details Negative frequencies wrap around as two's complement, as the
+ *          accumulators expect.
+ *
+ * @param hz frequency in Hz
+ * @return uint32_t phase increment register value
+ */
+uint32_t radioTuner_hzToPinc(double hz)
+{
+    double steps = hz * (1 << RADIO_PHASE_BITS) / RADIO_TIMER_HZ;
+    return (uint32_t)(int32_t)(steps + (steps >= 0 ? 0.5 : -0.5));
+}
@@ -0,0 +1,51 @@
+/**
+ * @file radioTuner.h
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Access to the radio tuner peripheral
+ * @details The streamers only read the radio: the phase increments to describe
+ *          the samples and the free-running timer to time-stamp them. Tuning
+ *          and the control register are written by radioDaemon alone, so the
+ *          read-modify-write of the control bits never races. The one exception
+ *          is the scan of udpFifoStreamer -Q, which steps the mixer increment
+ *          itself: a plain register write, timed to its packet boundaries.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef _RADIO_TUNER_H_
+#define _RADIO_TUNER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define RADIO_PERIPH_ADDRESS 0x43c00000
+#define RADIO_TUNER_FAKE_ADC_PINC_OFFSET    0
+#define RADIO_TUNER_TUNER_PINC_OFFSET       1
+#define RADIO_TUNER_CONTROL_REG_OFFSET      2
+#define RADIO_TUNER_TIMER_REG_OFFSET        3
+#define RADIO_TUNER_CTRL_RESET_MASK         0x00000001 // control register: tuner held in reset
+#define RADIO_TUNER_CTRL_STREAM_EN_MASK     0x00000002 // control register: stream enable
+
+#define RADIO_TIMER_HZ      125000000   // timer register clock
+#define RADIO_SAMPLE_RATE   48000       // output sample rate of the tuner (samples/s)
+#define RADIO_PHASE_BITS    27          // width of the DDS phase accumulators
+
+/**  Function Prototype */
+volatile unsigned int * radioTuner_open(void);
+void radioTuner_close(volatile unsigned int *radio);
+uint32_t radioTuner_getTimer(volatile unsigned int *radio);
+uint32_t radioTuner_getAdcPinc(volatile unsigned int *radio);
+uint32_t radioTuner_getTunerPinc(volatile unsigned int *radio);
+uint32_t radioTuner_getControl(volatile unsigned int *radio);
+void radioTuner_setAdcHz(volatile unsigned int *radio, double hz);
+void radioTuner_setTunerHz(volatile unsigned int *radio, double hz);
+void radioTuner_setTunerPinc(volatile unsigned int *radio, uint32_t pinc);
+void radioTuner_setReset(volatile unsigned int *radio, bool reset);
+void radioTuner_setStream(volatile unsigned int *radio, bool enable);
+double radioTuner_pincToHz(uint32_t pinc);
+uint32_t radioTuner_hzToPinc(double hz);
+
+#endif /* _RADIO_TUNER_H_ */
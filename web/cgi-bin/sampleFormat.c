@@ -0,0 +1,233 @@
+/**
+ * @file sampleFormat.c
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Bulk conversion of raw FIFO words to the packet sample formats
+ * @details See sampleFormat.h. Every kernel reads a block of raw words before
+ *          it writes the converted block, and walks the packet forwards, so the
+ *          output may overlap the input as laid out by sampleFormat_rawOffset().
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* Include */
+#include "sampleFormat.h"
+
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SAMPLE_FORMAT_NEON 1
+#endif
+
+/**
+ * @brief Format names for -F
+ */
+static const struct
+{
+    const char *name;
+    sdrSampleFormat format;
+} format_names[] = {
+    { "cs16_qi",    SDR_FORMAT_CS16_QI },
+    { "cs16_iq",    SDR_FORMAT_CS16_IQ },
+    { "cs16_iq_be", SDR_FORMAT_CS16_IQ_BE },
+    { "cs16_qi_be", SDR_FORMAT_CS16_QI_BE },
+    { "cs8",        SDR_FORMAT_CS8_IQ },
+    { "cf32",       SDR_FORMAT_CF32_IQ },
+};
+
+/**
+ * @brief Parse a format name (cs16_qi, cs16_iq, cs16_iq_be, cs16_qi_be, cs8, cf32)
+ *
+ * @return int 0 on success, -1 if the name is unknown
+ */
+int sampleFormat_parse(const char *name, sdrSampleFormat *format)
+{
+    for (size_t i = 0; i < sizeof(format_names) / sizeof(format_names[0]); i++) {
+        if (strcmp(name, format_names[i].name) == 0) {
+            *format = format_names[i].format;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Human readable format name
+ */
+const char *sampleFormat_name(sdrSampleFormat format)
+{
+    for (size_t i = 0; i < sizeof(format_names) / sizeof(format_names[0]); i++) {
+        if (format_names[i].format == format) {
+            return format_names[i].name;
+        }
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Which kernels sampleFormat_convert() runs ("NEON" or "scalar")
+ */
+const char *sampleFormat_backend(void)
+{
+#ifdef SAMPLE_FORMAT_NEON
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
+
+/**
+ * @brief Where to drain the raw words, relative to the payload, for an in-place conversion
+ * @details Formats up to 4 bytes per sample are written behind the read
+ *          position, so the raw words start at the payload. cf32 writes twice
+ *          as much as it reads, so the raw words go to the end of the buffer.
+ *
+ * @param format output format
+ * @param count samples per packet
+ * @return size_t byte offset from the payload start (a multiple of 4)
+ */
+size_t sampleFormat_rawOffset(sdrSampleFormat format, unsigned int count)
+{
+    unsigned int bytes = sdrPacket_sampleBytes(format);
+    return (bytes > SAMPLE_FORMAT_RAW_BYTES) ? (size_t)(bytes - SAMPLE_FORMAT_RAW_BYTES) * count : 0;
+}
+
+/**
+ * @brief Payload bytes a packet buffer needs to hold both the raw words and the converted samples
+ */
+size_t sampleFormat_bufferBytes(sdrSampleFormat format, unsigned int count)
+{
+    unsigned int bytes = sdrPacket_sampleBytes(format);
+    return (size_t)(bytes > SAMPLE_FORMAT_RAW_BYTES ? bytes : SAMPLE_FORMAT_RAW_BYTES) * count;
+}
+
+/**
+ * @brief Convert raw FIFO words one sample at a time
+ * @details The reference for the NEON kernels, the fallback on other CPUs and
+ *          the tail of every packet.
+ *
+ * @param format output format
+ * @param dst output samples
+ * @param src raw FIFO words (may overlap dst, see sampleFormat_rawOffset())
+ * @param count number of samples
+ */
+void sampleFormat_convertScalar(sdrSampleFormat format, void *dst, const uint32_t *src, unsigned int count)
+{
+    uint8_t *out = dst;
+    switch (format) {
+        case SDR_FORMAT_CS16_QI:
+            if (dst != (const void *)src) {
+                memmove(dst, src, (size_t)count * SAMPLE_FORMAT_RAW_BYTES);
+            }
+            break;
+        case SDR_FORMAT_CS16_IQ:
+            for (unsigned int i = 0; i < count; i++) {
+                uint32_t word = src[i];
+                ((uint32_t *)dst)[i] = (word << 16) | (word >> 16);
+            }
+            break;
+        case SDR_FORMAT_CS16_IQ_BE:
+            for (unsigned int i = 0; i < count; i++) {
+                ((uint32_t *)dst)[i] = __builtin_bswap32(src[i]); // I high, I low, Q high, Q low
+            }
+            break;
+        case SDR_FORMAT_CS16_QI_BE:
+            for (unsigned int i = 0; i < count; i++) {
+                uint32_t word = src[i];
+                ((uint32_t *)dst)[i] = ((word & 0x00FF00FF) << 8) | ((word >> 8) & 0x00FF00FF); // bytes of each int16 swapped
+            }
+            break;
+        case SDR_FORMAT_CS8_IQ:
+            for (unsigned int i = 0; i < count; i++) {
+                uint32_t word = src[i];
+                out[2 * i + 0] = (uint8_t)(word >> 24); // I >> 8
+                out[2 * i + 1] = (uint8_t)(word >> 8);  // Q >> 8
+            }
+            break;
+        case SDR_FORMAT_CF32_IQ:
+            for (unsigned int i = 0; i < count; i++) {
+                uint32_t word = src[i];
+                float sample[2] = { (int16_t)(word >> 16) * (1.0f / 32768.0f), (int16_t)word * (1.0f / 32768.0f) };
+                memcpy(out + 8 * i, sample, sizeof(sample));
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+#ifdef SAMPLE_FORMAT_NEON
+/**
+ * @brief NEON kernels, they return how many samples they converted (a whole number of blocks)
+ */
+static unsigned int convert_neon(sdrSampleFormat format, uint8_t *out, const uint32_t *src, unsigned int count)
+{
+    const uint8_t *in = (const uint8_t *)src;
+    unsigned int i = 0;
+    switch (format) {
+        case SDR_FORMAT_CS16_IQ:
+            // swap the two halves of every word
+            for (; i + 4 <= count; i += 4) {
+                uint16x8_t v = vld1q_u16((const uint16_t *)(in + 4 * i));
+                vst1q_u16((uint16_t *)(out + 4 * i), vrev32q_u16(v));
+            }
+            break;
+        case SDR_FORMAT_CS16_IQ_BE:
+            // reverse the bytes of every word: I high, I low, Q high, Q low
+            for (; i + 4 <= count; i += 4) {
+                vst1q_u8(out + 4 * i, vrev32q_u8(vld1q_u8(in + 4 * i)));
+            }
+            break;
+        case SDR_FORMAT_CS16_QI_BE:
+            // reverse the bytes of every int16
+            for (; i + 4 <= count; i += 4) {
+                vst1q_u8(out + 4 * i, vrev16q_u8(vld1q_u8(in + 4 * i)));
+            }
+            break;
+        case SDR_FORMAT_CS8_IQ:
+            // de-interleave the bytes of 16 words (Q low, Q high, I low, I high), keep the high bytes
+            for (; i + 16 <= count; i += 16) {
+                uint8x16x4_t v = vld4q_u8(in + 4 * i);
+                uint8x16x2_t iq = { { v.val[3], v.val[1] } };
+                vst2q_u8(out + 2 * i, iq);
+            }
+            break;
+        case SDR_FORMAT_CF32_IQ:
+            // de-interleave 8 samples into Q and I, widen and scale by 2^-15 in the conversion
+            for (; i + 8 <= count; i += 8) {
+                int16x8x2_t v = vld2q_s16((const int16_t *)(in + 4 * i));
+                float32x4x2_t lo = { { vcvtq_n_f32_s32(vmovl_s16(vget_low_s16(v.val[1])), 15),
+                                       vcvtq_n_f32_s32(vmovl_s16(vget_low_s16(v.val[0])), 15) } };
+                float32x4x2_t hi = { { vcvtq_n_f32_s32(vmovl_s16(vget_high_s16(v.val[1])), 15),
+                                       vcvtq_n_f32_s32(vmovl_s16(vget_high_s16(v.val[0])), 15) } };
+                vst2q_f32((float *)(out + 8 * i), lo);
+                vst2q_f32((float *)(out + 8 * i + 32), hi);
+            }
+            break;
+        default:
+            break;
+    }
+    return i;
+}
+#endif
+
+/**
+ * @brief Convert a packet of raw FIFO words to the output format
+ *
+ * @param format output format
+ * @param dst output samples (sdrPacket_sampleBytes(format) * count bytes)
+ * @param src raw FIFO words (may overlap dst, see sampleFormat_rawOffset())
+ * @param count number of samples
+ */
+void sampleFormat_convert(sdrSampleFormat format, void *dst, const uint32_t *src, unsigned int count)
+{
+    unsigned int done = 0;
+#ifdef SAMPLE_FORMAT_NEON
+    done = convert_neon(format, dst, src, count);
+#endif
+    unsigned int bytes = sdrPacket_sampleBytes(format);
+    sampleFormat_convertScalar(format, (uint8_t *)dst + (size_t)done * bytes, src + done, count - done);
+}
@@ -0,0 +1,45 @@
+/**
+ * @file sampleFormat.h
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Bulk conversion of raw FIFO words to the packet sample formats
+ * @details A raw FIFO word holds one complex sample, I in the high half and Q
+ *          in the low half, so in little-endian memory it already is
+ *          SDR_FORMAT_CS16_QI. The streamers drain whole packets of raw words
+ *          and convert them in one call to the format chosen at startup (-F),
+ *          which is then recorded in the packet header.
+ *
+ *          On ARM with NEON (the Zynq Cortex-A9, built with -mfpu=neon) every
+ *          format has a vector kernel that converts 4 to 16 samples per
+ *          iteration; elsewhere, and for the tail of a packet, a scalar loop
+ *          does the same work.
+ *
+ *          The conversion may run in place inside the packet buffer: drain the
+ *          raw words to payload + sampleFormat_rawOffset() and convert to the
+ *          payload start. The buffer then needs sampleFormat_bufferBytes().
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef _SAMPLE_FORMAT_H_
+#define _SAMPLE_FORMAT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "sdrPacket.h"
+
+#define SAMPLE_FORMAT_RAW_BYTES 4       // bytes per raw FIFO word
+
+/**  Function Prototype */
+int sampleFormat_parse(const char *name, sdrSampleFormat *format);
+const char *sampleFormat_name(sdrSampleFormat format);
+const char *sampleFormat_backend(void);
+size_t sampleFormat_rawOffset(sdrSampleFormat format, unsigned int count);
+size_t sampleFormat_bufferBytes(sdrSampleFormat format, unsigned int count);
+void sampleFormat_convert(sdrSampleFormat format, void *dst, const uint32_t *src, unsigned int count);
+void sampleFormat_convertScalar(sdrSampleFormat format, void *dst, const uint32_t *src, unsigned int count);
+
+#endif /* _SAMPLE_FORMAT_H_ */
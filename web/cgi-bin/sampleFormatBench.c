@@ -0,0 +1,133 @@
+/**
+ * @file sampleFormatBench.c
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Microbenchmark of the sample format conversion
+ * @details Converts the same packets of random FIFO words over and over, once
+ *          with the word-at-a-time swap loop the single-thread streamer used to
+ *          run, once with the scalar kernels and once with sampleFormat_convert()
+ *          (NEON on the board), and prints the samples/s of each. The NEON output
+ *          is checked against the scalar one first. Runs without the FPGA.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "sampleFormat.h"
+
+#define DEFAULT_SAMPLES     256         // samples per packet, as the streamers
+#define DEFAULT_PACKETS     200000      // packets converted per measurement
+
+volatile uint32_t sink;                 // keeps the compiler from dropping the work
+
+void usage(const char *executableName);
+
+/**
+ * @brief Seconds since `start`
+ */
+static double seconds_since(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * @brief The swap loop of the single-thread streamer, for reference
+ */
+static void swap_words(uint32_t *dst, const uint32_t *src, unsigned int count)
+{
+    for (unsigned int i = 0; i < count; i++) {
+        uint32_t temp = src[i];
+        dst[i] = ((temp & 0x0000FFFF) << 16) | ((temp & 0xFFFF0000) >> 16); // swap bytes inside each int16
+    }
+}
+
+int main(int argc, char const *argv[])
+{
+    unsigned int num_samples = DEFAULT_SAMPLES;
+    unsigned int num_packets = DEFAULT_PACKETS;
+    int opt = 0;
+    while ((opt = getopt(argc, (char * const *)argv, "s:n:h")) != -1) {
+        switch (opt) {
+            case 's': num_samples = (unsigned int)atoi(optarg); break;
+            case 'n': num_packets = (unsigned int)atoi(optarg); break;
+            case 'h': usage(argv[0]); return 0;
+            default:  usage(argv[0]); return -1;
+        }
+    }
+    if (num_samples == 0 || num_packets == 0) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    uint32_t *raw = malloc((size_t)num_samples * sizeof(uint32_t));
+    uint8_t *out = malloc((size_t)num_samples * 8);
+    uint8_t *ref = malloc((size_t)num_samples * 8);
+    if (raw == NULL || out == NULL || ref == NULL) {
+        fprintf(stderr, "Failed to allocate the packets\n");
+        return -1;
+    }
+    srand(1);
+    for (unsigned int i = 0; i < num_samples; i++) {
+        raw[i] = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+    }
+
+    printf("Converting %u packets of %u samples, backend: %s\n", num_packets, num_samples, sampleFormat_backend());
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (unsigned int p = 0; p < num_packets; p++) {
+        swap_words((uint32_t *)out, raw, num_samples);
+        sink += out[p % num_samples];
+    }
+    double loopSeconds = seconds_since(&start);
+    printf("%-12s %10.1f Msamples/s (word swap loop)\n", "cs16_iq", (double)num_packets * num_samples / loopSeconds / 1e6);
+
+    for (int format = SDR_FORMAT_CS16_QI; format <= SDR_FORMAT_CF32_IQ; format++) {
+        size_t bytes = (size_t)num_samples * sdrPacket_sampleBytes(format);
+        sampleFormat_convertScalar(format, ref, raw, num_samples);
+        sampleFormat_convert(format, out, raw, num_samples);
+        if (memcmp(ref, out, bytes) != 0) {
+            printf("%-12s MISMATCH between %s and scalar output\n", sampleFormat_name(format), sampleFormat_backend());
+            continue;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (unsigned int p = 0; p < num_packets; p++) {
+            sampleFormat_convertScalar(format, out, raw, num_samples);
+            sink += out[p % bytes];
+        }
+        double scalarSeconds = seconds_since(&start);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (unsigned int p = 0; p < num_packets; p++) {
+            sampleFormat_convert(format, out, raw, num_samples);
+            sink += out[p % bytes];
+        }
+        double convertSeconds = seconds_since(&start);
+
+        double total = (double)num_packets * num_samples;
+        printf("%-12s %10.1f Msamples/s scalar, %10.1f Msamples/s %s (x%.2f)\n", sampleFormat_name(format),
+               total / scalarSeconds / 1e6, total / convertSeconds / 1e6, sampleFormat_backend(),
+               scalarSeconds / convertSeconds);
+    }
+
+    free(ref);
+    free(out);
+    free(raw);
+    return 0;
+}
+
+void usage(const char *executableName)
+{
+    printf("Usage: %s [-s <samples>] [-n <packets>]\n", executableName);
+    printf("  samples: samples per packet (default %d)\n", DEFAULT_SAMPLES);
+    printf("  packets: packets converted per measurement (default %d)\n", DEFAULT_PACKETS);
+}
@@ -0,0 +1,290 @@
+/**
+ * @file scanScheduler.c
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Timed frequency scan of the DDC mixer
+ * @details See scanScheduler.h. The 32-bit timer register wraps every 34 s,
+ *          so it is extended to 64 bits at every poll; the reader polls far
+ *          more often than that.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* Include */
+#include "scanScheduler.h"
+#include "radioTuner.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * @brief Append one frequency to the plan
+ * @return int 0 on success, -1 if it is out of range or the plan is full
+ */
+static int add_step(scanScheduler *scan, double hz, double ms)
+{
+    // anything past half the 125 MHz clock aliases
+    if (hz < -RADIO_TIMER_HZ / 2.0 || hz > RADIO_TIMER_HZ / 2.0) {
+        fprintf(stderr, "Scan frequency out of range: %.1f Hz\n", hz);
+        return -1;
+    }
+    if (ms < SCAN_MIN_DWELL_MS || ms > SCAN_MAX_DWELL_MS) {
+        fprintf(stderr, "Invalid scan dwell: %g ms (%d to %d)\n", ms, SCAN_MIN_DWELL_MS, SCAN_MAX_DWELL_MS);
+        return -1;
+    }
+    if (scan->numSteps >= SCAN_MAX_STEPS) {
+        fprintf(stderr, "Too many scan steps (at most %d)\n", SCAN_MAX_STEPS);
+        return -1;
+    }
+    scanStep *step = &scan->steps[scan->numSteps++];
+    step->hz = hz;
+    step->pinc = radioTuner_hzToPinc(hz);
+    step->dwellTicks = (uint32_t)(ms * (RADIO_TIMER_HZ / 1000.0) + 0.5);
+    return 0;
+}
+
+/**
+ * @brief Parse "<hz>[@<ms>]"
+ * @return int 0 on success, -1 if it is not a number
+ */
+static int parse_item(const char *item, double *hz, double *ms)
+{
+    char *end = NULL;
+    *hz = strtod(item, &end);
+    if (end == item) {
+        return -1;
+    }
+    *ms = SCAN_DEFAULT_DWELL_MS;
+    if (*end == '@') {
+        const char *dwell = end + 1;
+        *ms = strtod(dwell, &end);
+        if (end == dwell) {
+            return -1;
+        }
+    }
+    return (*end == '\0') ? 0 : -1;
+}
+
+/**
+ * @brief Parse "<start>:<stop>:<step>[@<ms>]"
+ */
+static int parse_range(scanScheduler *scan, const char *plan)
+{
+    double start = 0, stop = 0, step = 0, ms = SCAN_DEFAULT_DWELL_MS;
+    char tail;
+    int n = sscanf(plan, "%lf:%lf:%lf%c%lf", &start, &stop, &step, &tail, &ms);
+    if ((n != 3 && n != 5) || (n == 5 && tail != '@') || step <= 0) {
+        fprintf(stderr, "Invalid scan range: %s\n", plan);
+        return -1;
+    }
+    double direction = (stop >= start) ? 1.0 : -1.0;
+    // both ends included, a rounding error short of the stop still counts
+    unsigned long count = (unsigned long)((stop - start) * direction / step + 1e-9) + 1;
+    if (count > SCAN_MAX_STEPS) {
+        fprintf(stderr, "Too many scan steps: %lu (at most %d)\n", count, SCAN_MAX_STEPS);
+        return -1;
+    }
+    for (unsigned long k = 0; k < count; k++) {
+        if (add_step(scan, start + direction * step * k, ms) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Parse "<hz>[@<ms>],<hz>[@<ms>],..."
+ */
+static int parse_list(scanScheduler *scan, const char *plan)
+{
+    char *copy = strdup(plan);
+    char *save = NULL;
+    int rc = 0;
+    for (char *item = strtok_r(copy, ",", &save); item != NULL && rc == 0; item = strtok_r(NULL, ",", &save)) {
+        double hz, ms;
+        if (parse_item(item, &hz, &ms) != 0) {
+            fprintf(stderr, "Invalid scan step: %s\n", item);
+            rc = -1;
+        } else {
+            rc = add_step(scan, hz, ms);
+        }
+    }
+    free(copy);
+    return rc;
+}
+
+/**
+ * @brief Read one "<hz> [<ms>]" per line, # starts a comment
+ */
+static int parse_file(scanScheduler *scan, const char *path)
+{
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        perror("Failed to open the scan plan");
+        return -1;
+    }
+    char line[256];
+    unsigned int lineNo = 0;
+    int rc = 0;
+    while (rc == 0 && fgets(line, sizeof(line), file) != NULL) {
+        lineNo++;
+        line[strcspn(line, "#\r\n")] = '\0';
+        double hz, ms = SCAN_DEFAULT_DWELL_MS;
+        char extra;
+        int n = sscanf(line, "%lf %lf %c", &hz, &ms, &extra);
+        if (n == EOF) {
+            continue; // blank or comment
+        }
+        if (n < 1 || n > 2) {
+            fprintf(stderr, "Invalid scan plan line %u of %s\n", lineNo, path);
+            rc = -1;
+        } else {
+            rc = add_step(scan, hz, ms);
+        }
+    }
+    fclose(file);
+    return rc;
+}
+
+/**
+ * @brief Load a scan plan
+ *
+ * @param scan scheduler
+ * @param plan range, list or file name (see scanScheduler.h)
+ * @param settleSamples FIFO words to discard after a retune, on top of the stale ones
+ * @param packetTicks radio timer ticks one packet takes to capture, the retune granularity
+ * @return int 0 on success, -1 on failure
+ */
+int scanScheduler_init(scanScheduler *scan, const char *plan, unsigned int settleSamples, uint32_t packetTicks)
+{
+    *scan = (scanScheduler){0};
+    scan->steps = calloc(SCAN_MAX_STEPS, sizeof(scanStep));
+    if (scan->steps == NULL) {
+        perror("Failed to allocate the scan plan");
+        return -1;
+    }
+    scan->settleSamples = settleSamples;
+    scan->halfPacketTicks = packetTicks / 2;
+
+    int rc;
+    if (strchr(plan, ':') != NULL) {
+        rc = parse_range(scan, plan);
+    } else if (access(plan, R_OK) == 0) {
+        rc = parse_file(scan, plan);
+    } else {
+        rc = parse_list(scan, plan);
+    }
+    if (rc == 0 && scan->numSteps == 0) {
+        fprintf(stderr, "Empty scan plan: %s\n", plan);
+        rc = -1;
+    }
+    if (rc != 0) {
+        scanScheduler_close(scan);
+        return -1;
+    }
+
+    uint64_t sweepTicks = 0;
+    for (unsigned int k = 0; k < scan->numSteps; k++) {
+        sweepTicks += scan->steps[k].dwellTicks;
+    }
+    scan->sweepSeconds = (double)sweepTicks / RADIO_TIMER_HZ;
+    return 0;
+}
+
+/**
+ * @brief Retune if the next step is due, called at packet boundaries
+ * @details The first call tunes the first step and starts the schedule. A
+ *          step is taken at the boundary closest to its due time: now if the
+ *          next boundary would be further past it than this one is before it.
+ *          Steps whose whole dwell went by since the last poll are skipped, so
+ *          the scan stays on its schedule after a stall.
+ *
+ * @param scan scheduler
+ * @param radio radio tuner registers
+ * @return true the mixer was retuned: discard the FIFO backlog and the settle samples
+ */
+bool scanScheduler_poll(scanScheduler *scan, volatile unsigned int *radio)
+{
+    uint32_t timer = radioTuner_getTimer(radio);
+    if (!scan->started) {
+        scan->started = true;
+        scan->lastTimer = timer;
+        scan->nowTicks = timer;
+        scan->current = 0;
+        scan->dueTicks = scan->nowTicks + scan->steps[0].dwellTicks;
+        radioTuner_setTunerPinc(radio, scan->steps[0].pinc);
+        scan->retunes++;
+        return true;
+    }
+    scan->nowTicks += (uint32_t)(timer - scan->lastTimer); // modulo 2^32, fine across a wrap
+    scan->lastTimer = timer;
+    if (scan->nowTicks + scan->halfPacketTicks < scan->dueTicks) {
+        return false;
+    }
+
+    unsigned int previous = scan->current;
+    uint64_t stepStart = scan->dueTicks;
+    unsigned int next = previous;
+    while (true) {
+        next = (next + 1 == scan->numSteps) ? 0 : next + 1;
+        if (next == 0) {
+            scan->sweeps++;
+        }
+        if (stepStart + scan->steps[next].dwellTicks > scan->nowTicks) {
+            break;
+        }
+        stepStart += scan->steps[next].dwellTicks; // its whole dwell is over already
+        scan->skipped++;
+    }
+    scan->current = next;
+    scan->dueTicks = stepStart + scan->steps[next].dwellTicks; // from the schedule, not from now
+
+    int64_t errorTicks = (int64_t)(scan->nowTicks - stepStart);
+    uint64_t absError = errorTicks < 0 ? (uint64_t)-errorTicks : (uint64_t)errorTicks;
+    scan->timedSteps++;
+    scan->errorTicksTotal += errorTicks;
+    if (absError > scan->errorTicksMax) {
+        scan->errorTicksMax = absError;
+    }
+
+    if (scan->steps[next].pinc == scan->steps[previous].pinc) {
+        return false; // same frequency, nothing settles
+    }
+    radioTuner_setTunerPinc(radio, scan->steps[next].pinc);
+    scan->retunes++;
+    return true;
+}
+
+/**
+ * @brief Release the plan
+ */
+void scanScheduler_close(scanScheduler *scan)
+{
+    free(scan->steps);
+    scan->steps = NULL;
+    scan->numSteps = 0;
+}
+
+/**
+ * @brief Print the scan statistics
+ *
+ * @param scan scheduler
+ * @param samplesDrained FIFO words drained while scanning, for the discarded share
+ */
+void scanScheduler_printStats(const scanScheduler *scan, uint64_t samplesDrained)
+{
+    printf("Scan summary:\n");
+    printf("    Plan: %u steps, %.3f s per sweep\n", scan->numSteps, scan->sweepSeconds);
+    printf("    Retunes: %llu (%llu sweeps, %llu steps skipped)\n", (unsigned long long)scan->retunes,
+           (unsigned long long)scan->sweeps, (unsigned long long)scan->skipped);
+    printf("    Retune timing: mean %+.1f us, worst %.1f us from schedule\n",
+           scan->timedSteps ? scan->errorTicksTotal * 1e6 / RADIO_TIMER_HZ / scan->timedSteps : 0.0,
+           scan->errorTicksMax * 1e6 / RADIO_TIMER_HZ);
+    printf("    Discarded: %llu samples (%.2f%% of drained, %u settle per retune)\n",
+           (unsigned long long)scan->discarded,
+           samplesDrained ? 100.0 * scan->discarded / samplesDrained : 0.0, scan->settleSamples);
+}
@@ -0,0 +1,87 @@
+/**
+ * @file scanScheduler.h
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Timed frequency scan of the DDC mixer
+ * @details Steps the mixer through a list of frequencies, each held for its
+ *          own dwell time. The retune times are absolute: they are laid out on
+ *          the radio timer from the start of the scan (step k is due at the
+ *          sum of the dwells before it), so late retunes never push the
+ *          following steps back the way usleep() between writes does.
+ *
+ *          The streamer retunes between packets, so every packet is captured
+ *          at one frequency. A retune happens at the packet boundary closest
+ *          to its due time, so it is at most half a packet early or late. The
+ *          words still in the FIFO at the retune were captured at the old
+ *          frequency; they and the next settle samples (the DDC filter
+ *          transient) are discarded by the caller.
+ *
+ *          A plan is one of:
+ *
+ *              <start>:<stop>:<step>[@<ms>]    range, both ends included
+ *              <hz>[@<ms>],<hz>[@<ms>],...     list
+ *              <file>                          one "<hz> [<ms>]" per line
+ *
+ *          Steps without a dwell get SCAN_DEFAULT_DWELL_MS. The scan repeats
+ *          until the streamer stops.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef _SCAN_SCHEDULER_H_
+#define _SCAN_SCHEDULER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SCAN_MAX_STEPS          4096    // most frequencies in a plan
+#define SCAN_DEFAULT_DWELL_MS   100     // dwell of a step that does not give one
+#define SCAN_MIN_DWELL_MS       1       // shorter dwells are all settling
+#define SCAN_MAX_DWELL_MS       30000   // dwell ticks must fit 32 bits
+#define SCAN_DEFAULT_SETTLE     64      // samples discarded after a retune (DDC filter transient)
+
+/**
+ * @brief One frequency of the plan
+ */
+typedef struct scanStep
+{
+    double hz;                  // mixer frequency
+    uint32_t pinc;              // its phase increment
+    uint32_t dwellTicks;        // how long it is held, in radio timer ticks
+} scanStep;
+
+/**
+ * @brief Scan state, owned by the reader thread
+ */
+typedef struct scanScheduler
+{
+    scanStep *steps;            // the plan
+    unsigned int numSteps;      // steps in the plan
+    unsigned int settleSamples; // FIFO words to discard after a retune, on top of the stale ones
+    uint32_t halfPacketTicks;   // half of the time a packet takes to capture
+    unsigned int current;       // step the mixer is on
+    bool started;               // the first step has been tuned
+    uint32_t lastTimer;         // timer register at the last poll
+    uint64_t nowTicks;          // timer extended to 64 bits
+    uint64_t dueTicks;          // when the next step is due
+
+    // statistics
+    uint64_t retunes;           // mixer writes
+    uint64_t sweeps;            // passes through the whole plan
+    uint64_t skipped;           // steps whose whole dwell went by between two polls
+    uint64_t discarded;         // samples dropped across retunes
+    uint64_t timedSteps;        // steps taken on schedule (all but the first)
+    int64_t errorTicksTotal;    // sum of (retune time - due time)
+    uint64_t errorTicksMax;     // worst |retune time - due time|
+    double sweepSeconds;        // length of one pass through the plan
+} scanScheduler;
+
+/**  Function Prototype */
+int scanScheduler_init(scanScheduler *scan, const char *plan, unsigned int settleSamples, uint32_t packetTicks);
+bool scanScheduler_poll(scanScheduler *scan, volatile unsigned int *radio);
+void scanScheduler_close(scanScheduler *scan);
+void scanScheduler_printStats(const scanScheduler *scan, uint64_t samplesDrained);
+
+#endif /* _SCAN_SCHEDULER_H_ */
@@ -0,0 +1,72 @@
+/**
+ * @file sdrPacket.c
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Filling in the SDR packet header on the streamer side
+ * @details The reader fills in everything that describes the samples when a
+ *          packet is complete; the sender stamps the send time just before the
+ *          packet goes to the socket.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* Include */
+#include "sdrPacket.h"
+#include "radioTuner.h"
+
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief Fill in the header of a complete packet
+ *
+ * @param header header at the start of the packet buffer
+ * @param sequence packet sequence number
+ * @param sampleCount samples in the payload
+ * @param format payload sample format
+ * @param sampleRate samples per second of the payload (after decimation)
+ * @param radio radio tuner registers, NULL if not mapped (no tuning, no timestamps)
+ * @param captureTicks radio timer when the first sample was drained
+ */
+void sdrPacket_fillHeader(sdrPacketHeader *header, uint32_t sequence, unsigned int sampleCount,
+                          sdrSampleFormat format, uint32_t sampleRate, volatile unsigned int *radio, uint32_t captureTicks)
+{
+    memset(header, 0, sizeof(*header));
+    header->magic = SDR_PACKET_MAGIC;
+    header->version = SDR_PACKET_VERSION;
+    header->headerWords = sizeof(sdrPacketHeader) / sizeof(uint32_t);
+    header->sequence = sequence;
+    header->sampleCount = (uint16_t)sampleCount;
+    header->format = (uint16_t)format;
+    header->sampleRate = sampleRate;
+    if (radio != NULL) {
+        header->flags = SDR_FLAG_TIMESTAMPS;
+        header->adcPinc = radioTuner_getAdcPinc(radio);
+        header->tunerPinc = radioTuner_getTunerPinc(radio);
+        header->captureTicks = captureTicks;
+    }
+}
+
+/**
+ * @brief Stamp the send time into a batch of packets
+ * @details The timer and the clock are read once per batch: the packets of a
+ *          batch leave in the same syscall.
+ *
+ * @param packets packet buffers, each starting with an sdrPacketHeader
+ * @param count number of packets
+ * @param radio radio tuner registers, NULL if not mapped
+ */
+void sdrPacket_stampSend(void * const *packets, unsigned int count, volatile unsigned int *radio)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    uint64_t sendTimeNs = (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+    uint32_t sendTicks = (radio != NULL) ? radioTuner_getTimer(radio) : 0;
+    for (unsigned int i = 0; i < count; i++) {
+        sdrPacketHeader *header = (sdrPacketHeader *)packets[i];
+        header->sendTicks = sendTicks;
+        header->sendTimeNs = sendTimeNs;
+    }
+}
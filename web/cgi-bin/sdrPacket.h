@@ -0,0 +1,106 @@
+/**
+ * @file sdrPacket.h
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Wire format of the SDR sample packets
+ * @details Shared by the FIFO streamers and the receive tools. Every packet
+ *          starts with a self-describing header that tells the receiver what
+ *          the payload is (sample count, format, rate, tuning) and when it was
+ *          captured and sent, so latency can be traced per packet:
+ *
+ *              FIFO-to-wire  = (sendTicks - captureTicks) / SDR_TIMER_HZ
+ *              wire-to-host  = receive time - sendTimeNs   (clocks synced by NTP/PTP)
+ *
+ *          All fields are little endian. The legacy layout (a bare 32-bit
+ *          packet ID in front of the samples) is still available on the
+ *          streamers as a compatibility mode; it carries no magic, so a
+ *          receiver tells the two apart by the first word.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef _SDR_PACKET_H_
+#define _SDR_PACKET_H_
+
+#include <stdint.h>
+
+#define SDR_PACKET_MAGIC        0x53445250  // "PRDS" on the wire, first word of every packet
+#define SDR_PACKET_VERSION      1           // bumped when the header layout changes
+#define SDR_LEGACY_HEADER_SIZE  4           // legacy layout: uint32_t packetID only
+
+#define SDR_TIMER_HZ            125000000   // radio timer register clock (captureTicks/sendTicks)
+
+/**
+ * @brief Payload sample formats
+ */
+typedef enum sdrSampleFormat
+{
+    SDR_FORMAT_CS16_QI = 1,     // complex int16, Q then I (raw FIFO word, I in the high half)
+    SDR_FORMAT_CS16_IQ = 2,     // complex int16, I then Q
+    SDR_FORMAT_CS16_IQ_BE = 3,  // complex int16 big endian, I then Q
+    SDR_FORMAT_CS16_QI_BE = 4,  // complex int16 big endian, Q then I
+    SDR_FORMAT_CS8_IQ = 5,      // complex int8, I then Q (top 8 bits of each int16)
+    SDR_FORMAT_CF32_IQ = 6,     // complex float32, I then Q, scaled to [-1, 1)
+    SDR_FORMAT_PCM16 = 7        // real int16 audio (FM demodulated), not a complex format
+} sdrSampleFormat;
+
+/**
+ * @brief Bytes per sample of a payload format (0: unknown format)
+ */
+static inline unsigned int sdrPacket_sampleBytes(unsigned int format)
+{
+    switch (format) {
+        case SDR_FORMAT_CS16_QI:
+        case SDR_FORMAT_CS16_IQ:
+        case SDR_FORMAT_CS16_IQ_BE:
+        case SDR_FORMAT_CS16_QI_BE:
+            return 4;
+        case SDR_FORMAT_CS8_IQ:
+        case SDR_FORMAT_PCM16:
+            return 2;
+        case SDR_FORMAT_CF32_IQ:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Header flags
+ */
+#define SDR_FLAG_TIMESTAMPS     0x0001      // captureTicks/sendTicks come from the radio timer
+#define SDR_FLAG_COMPRESSED     0x0002      // payload is iqCodec-compressed, decodes to sampleCount cs16_qi samples
+#define SDR_FLAG_SCAN           0x0004      // captured during a frequency scan: tunerPinc is the step's, scanStep its index
+#define SDR_FLAG_DISCONTINUITY  0x0008      // samples are missing inside or right before this packet (FIFO overflow or read error)
+
+/**
+ * @brief Packet header (48 bytes, followed by sampleCount samples)
+ */
+typedef struct sdrPacketHeader
+{
+    uint32_t magic;             // SDR_PACKET_MAGIC
+    uint8_t  version;           // SDR_PACKET_VERSION
+    uint8_t  headerWords;       // header length in 32-bit words, the payload starts after it
+    uint16_t flags;             // SDR_FLAG_*
+    uint32_t sequence;          // packet sequence number, +1 per packet
+    uint16_t sampleCount;       // samples in the payload
+    uint16_t format;            // sdrSampleFormat
+    uint32_t sampleRate;        // samples per second
+    uint32_t adcPinc;           // fake ADC phase increment (freq * 2^27 / 125 MHz)
+    uint32_t tunerPinc;         // mixer phase increment (freq * 2^27 / 125 MHz)
+    uint32_t captureTicks;      // radio timer when the first sample was drained from the FIFO
+    uint32_t sendTicks;         // radio timer when the packet was handed to the socket
+    uint32_t scanStep;          // index of the scan step with SDR_FLAG_SCAN, else 0
+    uint64_t sendTimeNs;        // CLOCK_REALTIME when the packet was handed to the socket
+} sdrPacketHeader;
+
+_Static_assert(sizeof(sdrPacketHeader) == 48, "sdrPacketHeader must stay 48 bytes");
+
+/**  Function Prototype (streamer side, sdrPacket.c) */
+void sdrPacket_fillHeader(sdrPacketHeader *header, uint32_t sequence, unsigned int sampleCount,
+                          sdrSampleFormat format, uint32_t sampleRate, volatile unsigned int *radio, uint32_t captureTicks);
+void sdrPacket_stampSend(void * const *packets, unsigned int count, volatile unsigned int *radio);
+
+#endif /* _SDR_PACKET_H_ */
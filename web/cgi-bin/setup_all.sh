@@ -1,17 +1,62 @@
 #!/bin/bash
 
 # default values
-STREAMING_APPLICATION=udpFifoStreamer2
+STREAMING_APPLICATION=udpFifoStreamer
+STREAMER_CTL=./streamerCtl
+RADIO_DAEMON=radioDaemon
+RADIO_DAEMON_SOCKET=/var/run/radioDaemon.sock
+BITSTREAM=design_1_wrapper.bit.bin
+CODEC_SCRIPT=./configure_codec.sh
+# what was brought up since boot; /var/run is a tmpfs, so a reboot (unprogrammed PL) starts cold
+STATE_DIR=/var/run/sdr_init
+FPGA_STATE=/sys/class/fpga_manager/fpga0/state
 ip=192.168.1.3
 port=25344
+cold=0
 
 # Read POST data -- GPT suggested this
 read -n "$CONTENT_LENGTH" POST_DATA
 # Parse IP and PORT from POST
 ip=$(echo "$POST_DATA" | sed -n 's/.*ip=\([^&]*\).*/\1/p')
 port=$(echo "$POST_DATA" | sed -n 's/.*port=\([^&]*\).*/\1/p')
+# cold=1 reloads everything even if it looks done
+echo "$POST_DATA" | grep -q 'cold=1' && cold=1
 
-killall -9 "$STREAMING_APPLICATION"
+# milliseconds since boot, good to 10 ms
+now_ms() {
+    local up
+    read -r up _ < /proc/uptime
+    echo $(( 10#${up/./} * 10 ))
+}
+
+# sha256 of the bitstream, cached by size and modification time so a warm start never hashes 4 MB
+bitstream_hash() {
+    local stamp cached
+    stamp=$(stat -c '%s %Y' "$BITSTREAM")
+    cached=$(cat "$STATE_DIR/bitstream.stat" 2>/dev/null)
+    if [ "$cached" != "$stamp" ] || [ ! -f "$STATE_DIR/bitstream.file_sha256" ]; then
+        sha256sum "$BITSTREAM" | cut -d' ' -f1 > "$STATE_DIR/bitstream.file_sha256"
+        echo "$stamp" > "$STATE_DIR/bitstream.stat"
+    fi
+    cat "$STATE_DIR/bitstream.file_sha256"
+}
+
+# the codec register set is the list of i2cset writes in the codec script
+codec_hash() {
+    grep '^i2cset' "$CODEC_SCRIPT" | sha256sum | cut -d' ' -f1
+}
+
+# wait up to 5 s for a process to exit, so its mappings are gone
+wait_gone() {
+    for _ in $(seq 50); do
+        pidof "$1" > /dev/null || return 0
+        sleep 0.1
+    done
+    return 1
+}
+
+mkdir -p "$STATE_DIR"
+start_all=$(now_ms)
 
 # Echo HTTP headers
 echo "Content-type: text/html"
@@ -19,20 +64,135 @@ echo ""
 
 # Echo HTML body
 echo "<html><body><p><em>"
-echo "Loading PL...<br>"
-fpgautil -b design_1_wrapper.bit.bin
+
+# an older setup ran the single-thread streamer, it has no control socket to retarget
+killall -9 udpFifoStreamer2 2> /dev/null
+
+# load the PL unless this bitstream is loaded and the FPGA still runs it
+t0=$(now_ms)
+want_bit=$(bitstream_hash)
+have_bit=$(cat "$STATE_DIR/bitstream.sha256" 2>/dev/null)
+fpga_state=$(cat "$FPGA_STATE" 2>/dev/null || echo operating)
+if [ "$cold" = 1 ] || [ "$want_bit" != "$have_bit" ] || [ "$fpga_state" != "operating" ]; then
+    echo "Loading PL...<br>"
+    rm -f "$STATE_DIR/bitstream.sha256"
+    # the streamer and the daemon map the PL, their mappings do not survive a reload
+    killall -9 "$STREAMING_APPLICATION" 2> /dev/null
+    killall "$RADIO_DAEMON" 2> /dev/null
+    if ! wait_gone "$STREAMING_APPLICATION" || ! wait_gone "$RADIO_DAEMON"; then
+        echo "The streamer or $RADIO_DAEMON did not exit, not reloading the PL under them<br>"
+        pl_step="failed"
+    elif fpgautil -b "$BITSTREAM"; then
+        echo "$want_bit" > "$STATE_DIR/bitstream.sha256"
+        pl_step="loaded"
+    else
+        pl_step="failed"
+    fi
+else
+    echo "PL already runs $BITSTREAM (sha256 ${want_bit:0:12}), not reloaded<br>"
+    pl_step="skipped"
+fi
+pl_ms=$(( $(now_ms) - t0 ))
 echo "</p></em><p>"
+if [ "$pl_step" = "failed" ]; then
+    # nothing below can run on an unprogrammed PL, and a failed run is no cold start time
+    echo "<em>Loading $BITSTREAM failed</em>, the radio daemon and the streamer were not started.</p>"
+    echo "<table border=1>"
+    echo "<tr><th>Step</th><th>Action</th><th>ms</th></tr>"
+    echo "<tr><td>PL bitstream</td><td>failed</td><td>$pl_ms</td></tr>"
+    echo "</table>"
+    echo "</body></html>"
+    exit 0
+fi
 
-echo "Configuring Codec...<br>"
-./configure_codec.sh
+# configure the codec unless the same register set was applied since boot
+t0=$(now_ms)
+want_codec=$(codec_hash)
+have_codec=$(cat "$STATE_DIR/codec.sha256" 2>/dev/null)
+if [ "$cold" = 1 ] || [ "$want_codec" != "$have_codec" ]; then
+    echo "Configuring Codec...<br>"
+    rm -f "$STATE_DIR/codec.sha256"
+    if "$CODEC_SCRIPT"; then
+        echo "$want_codec" > "$STATE_DIR/codec.sha256"
+        codec_step="configured"
+    else
+        codec_step="failed"
+    fi
+else
+    echo "Codec already has this register set (sha256 ${want_codec:0:12}), not reconfigured<br>"
+    codec_step="skipped"
+fi
+codec_ms=$(( $(now_ms) - t0 ))
 echo "</p>"
 
+# the radio tuning and control CGIs talk to the daemon, it maps the registers once
+t0=$(now_ms)
+if pidof "$RADIO_DAEMON" > /dev/null; then
+    daemon_step="running"
+elif [ ! -x "./$RADIO_DAEMON" ]; then
+    echo "$RADIO_DAEMON is not built (see the README), the tuning buttons will not work<br>"
+    daemon_step="missing"
+else
+    echo "Starting the radio control daemon...<br>"
+    rm -f "$RADIO_DAEMON_SOCKET" # left behind by a daemon that was killed, it must not pass for the new one
+    ./"$RADIO_DAEMON" > /dev/null 2>&1 &
+    daemon_pid=$!
+    # up once it listens; give up after 1 s or as soon as it exits
+    daemon_step="failed"
+    for _ in $(seq 20); do
+        kill -0 "$daemon_pid" 2> /dev/null || break
+        if [ -S "$RADIO_DAEMON_SOCKET" ]; then
+            daemon_step="started"
+            break
+        fi
+        sleep 0.05
+    done
+    if [ "$daemon_step" = "failed" ]; then
+        echo "<em>$RADIO_DAEMON did not come up</em>, the tuning buttons will not work<br>"
+    fi
+fi
+daemon_ms=$(( $(now_ms) - t0 ))
+
 echo "Initializing the UDP FIFO streaming engine...<br>"
 echo "UDP Destination IP address: $ip<br>"
 echo "UDP Destination UDP port: $port<br>"
 
-# Run the streaming application with user-supplied IP and PORT
-./"$STREAMING_APPLICATION" -i "$ip" -p "$port" > /dev/null 2>&1 & 
+# a running streamer only gets the new destination on its control socket; otherwise start one
+t0=$(now_ms)
+if pidof "$STREAMING_APPLICATION" > /dev/null && "$STREAMER_CTL" DEST "$ip:$port" > /dev/null 2>&1; then
+    streamer_step="retargeted"
+else
+    killall -9 "$STREAMING_APPLICATION" 2> /dev/null
+    ./"$STREAMING_APPLICATION" -i "$ip" -p "$port" > /dev/null 2>&1 &
+    streamer_step="started"
+fi
+streamer_ms=$(( $(now_ms) - t0 ))
+
+total_ms=$(( $(now_ms) - start_all ))
+if [ "$codec_step" = "failed" ]; then
+    kind="Failed" # not a start time worth keeping
+elif [ "$pl_step" = "loaded" ] || [ "$codec_step" = "configured" ]; then
+    kind="Cold"
+    echo "$total_ms" > "$STATE_DIR/last_cold_ms"
+else
+    kind="Warm"
+    echo "$total_ms" > "$STATE_DIR/last_warm_ms"
+fi
+last_cold=$(cat "$STATE_DIR/last_cold_ms" 2>/dev/null || echo "-")
+last_warm=$(cat "$STATE_DIR/last_warm_ms" 2>/dev/null || echo "-")
 
-echo "<p><em>All Done!</em></p>"
-echo "</body></html>"
\ No newline at end of file
+if [ "$kind" = "Failed" ]; then
+    echo "<p><em>Done, but the codec was not configured</em> in $total_ms ms</p>"
+else
+    echo "<p><em>All Done!</em> $kind start in $total_ms ms</p>"
+fi
+echo "<table border=1>"
+echo "<tr><th>Step</th><th>Action</th><th>ms</th></tr>"
+echo "<tr><td>PL bitstream</td><td>$pl_step</td><td>$pl_ms</td></tr>"
+echo "<tr><td>Codec</td><td>$codec_step</td><td>$codec_ms</td></tr>"
+echo "<tr><td>Radio daemon</td><td>$daemon_step</td><td>$daemon_ms</td></tr>"
+echo "<tr><td>Streamer</td><td>$streamer_step</td><td>$streamer_ms</td></tr>"
+echo "<tr><td>Total</td><td>$kind</td><td>$total_ms</td></tr>"
+echo "</table>"
+echo "<p>Last cold start: $last_cold ms, last warm start: $last_warm ms</p>"
+echo "</body></html>"
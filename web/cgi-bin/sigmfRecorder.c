@@ -0,0 +1,325 @@
+/**
+ * @file sigmfRecorder.c
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Write-behind recorder of the drained FIFO stream to SigMF files
+ * @details See sigmfRecorder.h.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // O_DIRECT
+#endif
+
+/* Include */
+#include "sigmfRecorder.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * @brief Write the SigMF metadata file
+ * @details Written once when the recording starts, so the data file is usable
+ *          even if the streamer is killed, and again on close with the real
+ *          start time and the dropped-packet annotations.
+ */
+static void write_meta(const sigmfRecorder *rec)
+{
+    FILE *meta = fopen(rec->metaPath, "w");
+    if (meta == NULL) {
+        perror("Failed to write SigMF metadata");
+        return;
+    }
+
+    char datetime[32];
+    struct tm tm;
+    gmtime_r(&rec->startTime.tv_sec, &tm);
+    strftime(datetime, sizeof(datetime), "%Y-%m-%dT%H:%M:%S", &tm);
+
+    fprintf(meta, "{\n");
+    fprintf(meta, "    \"global\": {\n");
+    fprintf(meta, "        \"core:datatype\": \"ci16_le\",\n");
+    fprintf(meta, "        \"core:sample_rate\": %u,\n", rec->sampleRate);
+    fprintf(meta, "        \"core:version\": \"1.0.0\",\n");
+    fprintf(meta, "        \"core:hw\": \"Zybo radio tuner, fake ADC at %.0f Hz\",\n", rec->adcHz);
+    fprintf(meta, "        \"core:recorder\": \"udpFifoStreamer\",\n");
+    fprintf(meta, "        \"core:description\": \"ADC %.0f Hz, tuner %.0f Hz\"\n", rec->adcHz, rec->tuneHz);
+    fprintf(meta, "    },\n");
+    fprintf(meta, "    \"captures\": [\n");
+    fprintf(meta, "        {\n");
+    fprintf(meta, "            \"core:sample_start\": 0,\n");
+    fprintf(meta, "            \"core:frequency\": %.0f,\n", rec->tuneHz);
+    fprintf(meta, "            \"core:datetime\": \"%s.%09ldZ\"\n", datetime, rec->startTime.tv_nsec);
+    fprintf(meta, "        }\n");
+    fprintf(meta, "    ],\n");
+    fprintf(meta, "    \"annotations\": [");
+    for (unsigned int i = 0; i < rec->numGaps; i++) {
+        fprintf(meta, "%s\n        {\n", i ? "," : "");
+        fprintf(meta, "            \"core:sample_start\": %llu,\n", (unsigned long long)rec->gaps[i].sampleStart);
+        fprintf(meta, "            \"core:comment\": \"recorder overrun, %llu samples dropped before this sample\"\n",
+                (unsigned long long)rec->gaps[i].dropped);
+        fprintf(meta, "        }");
+    }
+    fprintf(meta, "%s]\n", rec->numGaps ? "\n    " : "");
+    fprintf(meta, "}\n");
+    fclose(meta);
+}
+
+/**
+ * @brief Write one span of the buffer to the data file
+ * @details The samples arrive as raw FIFO words (Q in the low half); SigMF
+ *          ci16_le wants I first, so the halves are swapped in place here, on
+ *          the writer thread, rather than while the reader copies them in.
+ *
+ * @param rec recorder
+ * @param pos byte position of the span in the stream
+ * @param len span length (does not wrap around the end of the buffer)
+ */
+static void write_span(sigmfRecorder *rec, uint64_t pos, size_t len)
+{
+    unsigned char *data = rec->buffer + pos % rec->size;
+    uint32_t *words = (uint32_t *)data;
+    for (size_t i = 0; i < len / 4; i++) {
+        words[i] = (words[i] << 16) | (words[i] >> 16);
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = write(rec->fd, data + done, len - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && errno == EINVAL && rec->direct) {
+            // the filesystem accepted O_DIRECT at open() but not for this write
+            fcntl(rec->fd, F_SETFL, fcntl(rec->fd, F_GETFL) & ~O_DIRECT);
+            rec->direct = false;
+            continue;
+        }
+        if (n <= 0) {
+            if (rec->stats.bytesFailed == 0) {
+                perror("Failed to write SigMF data");
+            }
+            rec->stats.bytesFailed += len - done; // keep draining, the reader must never wait for us
+            break;
+        }
+        done += (size_t)n;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+    rec->stats.writeSeconds += ms / 1e3;
+    if (ms > rec->stats.slowestWriteMs) {
+        rec->stats.slowestWriteMs = ms;
+    }
+    rec->stats.bytesWritten += done;
+    rec->stats.writes++;
+}
+
+/**
+ * @brief Writer thread: write whole chunks as they fill up, the rest on close
+ */
+static void *writer_task(void *arg)
+{
+    sigmfRecorder *rec = arg;
+    for (;;) {
+        int closed = atomic_load_explicit(&rec->closed, memory_order_acquire);
+        uint64_t head = atomic_load_explicit(&rec->head, memory_order_acquire);
+        uint64_t tail = atomic_load_explicit(&rec->tail, memory_order_relaxed);
+
+        if (head - tail >= SIGMF_CHUNK_SIZE) {
+            // chunks never straddle the end of the buffer, its size is a multiple of the chunk size
+            write_span(rec, tail, SIGMF_CHUNK_SIZE);
+            atomic_store_explicit(&rec->tail, tail + SIGMF_CHUNK_SIZE, memory_order_release);
+            continue;
+        }
+        if (closed) {
+            if (head > tail) {
+                // the last partial chunk is not a multiple of the O_DIRECT alignment
+                fcntl(rec->fd, F_SETFL, fcntl(rec->fd, F_GETFL) & ~O_DIRECT);
+                write_span(rec, tail, (size_t)(head - tail));
+                atomic_store_explicit(&rec->tail, head, memory_order_release);
+            }
+            break;
+        }
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += SIGMF_WRITER_WAIT_MS * 1000000L;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000;
+        deadline.tv_nsec %= 1000000000;
+        sem_timedwait(&rec->wakeSem, &deadline);
+    }
+    fsync(rec->fd);
+    return NULL;
+}
+
+/**
+ * @brief Create the SigMF files and start the writer thread
+ *
+ * @param rec recorder
+ * @param basePath path without the .sigmf-data/.sigmf-meta extension
+ * @param bufferBytes write-behind buffer size (rounded up to whole chunks)
+ * @param sampleRate samples per second
+ * @param adcHz fake ADC frequency for the metadata
+ * @param tuneHz mixer frequency for the metadata
+ * @return int 0 on success, -1 on failure
+ */
+int sigmfRecorder_open(sigmfRecorder *rec, const char *basePath, size_t bufferBytes,
+                       uint32_t sampleRate, double adcHz, double tuneHz)
+{
+    memset(rec, 0, sizeof(*rec));
+    rec->fd = -1;
+    if (snprintf(rec->dataPath, sizeof(rec->dataPath), "%s.sigmf-data", basePath) >= (int)sizeof(rec->dataPath)
+        || snprintf(rec->metaPath, sizeof(rec->metaPath), "%s.sigmf-meta", basePath) >= (int)sizeof(rec->metaPath)) {
+        fprintf(stderr, "Recording path too long: %s\n", basePath);
+        return -1;
+    }
+
+    // at least two chunks, so the reader can fill one while the other is written
+    rec->size = (bufferBytes + SIGMF_CHUNK_SIZE - 1) / SIGMF_CHUNK_SIZE * SIGMF_CHUNK_SIZE;
+    if (rec->size < 2 * SIGMF_CHUNK_SIZE) {
+        rec->size = 2 * SIGMF_CHUNK_SIZE;
+    }
+    void *mem = NULL;
+    if (posix_memalign(&mem, SIGMF_ALIGN, rec->size) != 0) {
+        fprintf(stderr, "Failed to allocate the %zu-byte recording buffer\n", rec->size);
+        return -1;
+    }
+    rec->buffer = mem;
+    memset(rec->buffer, 0, rec->size); // touch every page up front
+
+    // bypass the page cache where possible, tmpfs and some FUSE mounts refuse O_DIRECT
+    rec->fd = open(rec->dataPath, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+    rec->direct = (rec->fd >= 0);
+    if (rec->fd < 0 && errno == EINVAL) {
+        rec->fd = open(rec->dataPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+    if (rec->fd < 0) {
+        perror("Failed to create SigMF data file");
+        free(rec->buffer);
+        rec->buffer = NULL;
+        return -1;
+    }
+
+    rec->sampleRate = sampleRate;
+    rec->adcHz = adcHz;
+    rec->tuneHz = tuneHz;
+    clock_gettime(CLOCK_REALTIME, &rec->startTime); // replaced by the time of the first sample
+    atomic_init(&rec->head, 0);
+    atomic_init(&rec->tail, 0);
+    atomic_init(&rec->closed, 0);
+    sem_init(&rec->wakeSem, 0, 0);
+    write_meta(rec);
+
+    if (pthread_create(&rec->writer, NULL, writer_task, rec) != 0) {
+        perror("Failed to create SigMF writer thread");
+        sem_destroy(&rec->wakeSem);
+        close(rec->fd);
+        rec->fd = -1;
+        free(rec->buffer);
+        rec->buffer = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Hand a packet of samples to the writer (producer side, never blocks)
+ * @details A packet that does not fit in the free part of the buffer is dropped
+ *          as a whole and noted in the metadata.
+ *
+ * @param rec recorder
+ * @param samples raw FIFO words
+ * @param count number of samples
+ * @return int 0 if the samples were queued, -1 if they were dropped
+ */
+int sigmfRecorder_write(sigmfRecorder *rec, const uint32_t *samples, unsigned int count)
+{
+    size_t bytes = (size_t)count * sizeof(uint32_t);
+    uint64_t head = atomic_load_explicit(&rec->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&rec->tail, memory_order_acquire); // the writer is done with everything before tail
+
+    if (!rec->started) {
+        clock_gettime(CLOCK_REALTIME, &rec->startTime);
+        rec->started = true;
+    }
+
+    if (head - tail + bytes > rec->size) {
+        rec->stats.bytesDropped += bytes;
+        rec->stats.dropEvents++;
+        uint64_t sampleStart = head / sizeof(uint32_t);
+        if (rec->numGaps > 0 && rec->gaps[rec->numGaps - 1].sampleStart == sampleStart) {
+            rec->gaps[rec->numGaps - 1].dropped += count; // still the same overrun
+        } else if (rec->numGaps < SIGMF_MAX_GAPS) {
+            rec->gaps[rec->numGaps].sampleStart = sampleStart;
+            rec->gaps[rec->numGaps].dropped = count;
+            rec->numGaps++;
+        }
+        return -1;
+    }
+
+    size_t offset = head % rec->size;
+    size_t first = (bytes < rec->size - offset) ? bytes : rec->size - offset;
+    memcpy(rec->buffer + offset, samples, first);
+    memcpy(rec->buffer, (const unsigned char *)samples + first, bytes - first); // wrapped part, if any
+    atomic_store_explicit(&rec->head, head + bytes, memory_order_release);
+
+    size_t pending = (size_t)(head + bytes - tail);
+    if (pending > rec->stats.highWater) {
+        rec->stats.highWater = pending;
+    }
+    if ((head + bytes) / SIGMF_CHUNK_SIZE != head / SIGMF_CHUNK_SIZE) {
+        sem_post(&rec->wakeSem); // a chunk just filled up
+    }
+    return 0;
+}
+
+/**
+ * @brief Flush what is buffered, stop the writer and finish the metadata
+ */
+void sigmfRecorder_close(sigmfRecorder *rec)
+{
+    if (rec->fd < 0) {
+        return;
+    }
+    atomic_store_explicit(&rec->closed, 1, memory_order_release);
+    sem_post(&rec->wakeSem);
+    pthread_join(rec->writer, NULL);
+    sem_destroy(&rec->wakeSem);
+    close(rec->fd);
+    rec->fd = -1;
+    write_meta(rec);
+    free(rec->buffer);
+    rec->buffer = NULL;
+}
+
+/**
+ * @brief Print the recorder counters
+ *
+ * @param rec recorder
+ * @param seconds time the recorder was running
+ */
+void sigmfRecorder_printStats(const sigmfRecorder *rec, double seconds)
+{
+    printf("Recording summary (%s, %s):\n", rec->dataPath, rec->direct ? "O_DIRECT" : "buffered");
+    printf("    Written: %llu bytes (%llu samples), %.3f MB/s\n", (unsigned long long)rec->stats.bytesWritten,
+           (unsigned long long)(rec->stats.bytesWritten / sizeof(uint32_t)),
+           seconds > 0 ? rec->stats.bytesWritten / seconds / 1e6 : 0.0);
+    printf("    Writes: %llu, %.1f MB/s while writing, slowest %.2f ms\n", (unsigned long long)rec->stats.writes,
+           rec->stats.writeSeconds > 0 ? rec->stats.bytesWritten / rec->stats.writeSeconds / 1e6 : 0.0,
+           rec->stats.slowestWriteMs);
+    printf("    Buffer high-water mark: %zu of %zu bytes (%.1f%%)\n", rec->stats.highWater, rec->size,
+           100.0 * rec->stats.highWater / rec->size);
+    printf("    Dropped: %llu bytes in %llu packets, write errors discarded %llu bytes\n",
+           (unsigned long long)rec->stats.bytesDropped, (unsigned long long)rec->stats.dropEvents,
+           (unsigned long long)rec->stats.bytesFailed);
+}
@@ -0,0 +1,99 @@
+/**
+ * @file sigmfRecorder.h
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Write-behind recorder of the drained FIFO stream to SigMF files
+ * @details The reader thread copies every drained packet into a large
+ *          in-memory buffer and returns; a separate writer thread empties the
+ *          buffer to `<base>.sigmf-data` in large, page-aligned chunks
+ *          (O_DIRECT where the filesystem supports it). A latency spike of the
+ *          SD card only fills the buffer, it never stalls the FIFO drain. If
+ *          the buffer does fill up, whole packets are dropped, counted and
+ *          noted as annotations in `<base>.sigmf-meta`.
+ *
+ *          The producer and the writer share the buffer through two
+ *          monotonically increasing byte counters, the same single-producer /
+ *          single-consumer hand-off as packetRing.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef _SIGMF_RECORDER_H_
+#define _SIGMF_RECORDER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <semaphore.h>
+#include <pthread.h>
+#include <time.h>
+#include <limits.h>
+
+#define SIGMF_CACHE_LINE        64                  // keep producer and writer counters apart
+#define SIGMF_ALIGN             4096                // O_DIRECT buffer/offset/length alignment
+#define SIGMF_CHUNK_SIZE        (256 * 1024)        // bytes per write() call
+#define SIGMF_DEFAULT_BUFFER_MB 16                  // default write-behind buffer (~87 s at 48 ksps)
+#define SIGMF_MAX_GAPS          256                 // dropped-packet annotations kept for the metadata
+#define SIGMF_WRITER_WAIT_MS    100                 // longest writer sleep without a wake-up
+
+/**
+ * @brief Samples dropped because the buffer was full
+ */
+typedef struct sigmfGap
+{
+    uint64_t sampleStart;       // index (in the data file) of the first sample after the gap
+    uint64_t dropped;           // samples that never made it into the file
+} sigmfGap;
+
+/**
+ * @brief Recorder counters
+ */
+typedef struct sigmfRecorderStats
+{
+    uint64_t bytesWritten;      // bytes written to the data file (writer)
+    uint64_t writes;            // write() calls (writer)
+    double writeSeconds;        // time spent in write() (writer)
+    double slowestWriteMs;      // longest single write() (writer)
+    uint64_t bytesFailed;       // bytes discarded after a write error (writer)
+    uint64_t bytesDropped;      // bytes dropped because the buffer was full (producer)
+    uint64_t dropEvents;        // packets dropped (producer)
+    size_t highWater;           // most bytes waiting in the buffer (producer)
+} sigmfRecorderStats;
+
+/**
+ * @brief Recorder
+ */
+typedef struct sigmfRecorder
+{
+    _Alignas(SIGMF_CACHE_LINE) atomic_ullong head; // bytes handed over by the producer
+    _Alignas(SIGMF_CACHE_LINE) atomic_ullong tail; // bytes written to the file
+    _Alignas(SIGMF_CACHE_LINE) unsigned char *buffer; // write-behind buffer (SIGMF_ALIGN aligned)
+    size_t size;                    // buffer size, a multiple of SIGMF_CHUNK_SIZE
+    int fd;                         // data file
+    bool direct;                    // data file is open with O_DIRECT
+    atomic_int closed;              // producer is done, flush and exit
+    sem_t wakeSem;                  // wakes the writer when a chunk is ready
+    pthread_t writer;               // writer thread
+    char dataPath[PATH_MAX];        // <base>.sigmf-data
+    char metaPath[PATH_MAX];        // <base>.sigmf-meta
+    uint32_t sampleRate;            // samples per second
+    double adcHz;                   // fake ADC frequency
+    double tuneHz;                  // mixer frequency
+    struct timespec startTime;      // CLOCK_REALTIME of the first sample
+    bool started;                   // startTime is valid
+    sigmfGap gaps[SIGMF_MAX_GAPS];  // dropped packets (producer)
+    unsigned int numGaps;           // entries in gaps
+    sigmfRecorderStats stats;       // counters
+} sigmfRecorder;
+
+/**  Function Prototype */
+int sigmfRecorder_open(sigmfRecorder *rec, const char *basePath, size_t bufferBytes,
+                       uint32_t sampleRate, double adcHz, double tuneHz);
+int sigmfRecorder_write(sigmfRecorder *rec, const uint32_t *samples, unsigned int count);
+void sigmfRecorder_close(sigmfRecorder *rec);
+void sigmfRecorder_printStats(const sigmfRecorder *rec, double seconds);
+
+#endif /* _SIGMF_RECORDER_H_ */
@@ -0,0 +1,330 @@
+/**
+ * @file spectrum.c
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Averaged FFT power spectrum of the drained FIFO samples
+ * @details See spectrum.h.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* Include */
+#include "spectrum.h"
+#include "sdrPacket.h"
+#include "radioTuner.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SPECTRUM_NEON 1
+#endif
+
+/**
+ * @brief Set up the FFT tables and buffers
+ *
+ * @param spec spectrum
+ * @param fftSize points per FFT, a power of two from SPECTRUM_MIN_FFT to SPECTRUM_MAX_FFT
+ * @param averages FFTs averaged per frame (1 to SPECTRUM_MAX_AVERAGES)
+ * @param sampleRate samples per second of the input
+ * @return int 0 on success, -1 on failure
+ */
+int spectrum_init(spectrum *spec, unsigned int fftSize, unsigned int averages, unsigned int sampleRate)
+{
+    memset(spec, 0, sizeof(*spec));
+    spec->sock = -1;
+    if (fftSize < SPECTRUM_MIN_FFT || fftSize > SPECTRUM_MAX_FFT || (fftSize & (fftSize - 1)) != 0) {
+        fprintf(stderr, "Invalid FFT size: %u (power of two, %d to %d)\n", fftSize, SPECTRUM_MIN_FFT, SPECTRUM_MAX_FFT);
+        return -1;
+    }
+    if (averages == 0 || averages > SPECTRUM_MAX_AVERAGES) {
+        fprintf(stderr, "Invalid number of averages: %u (1 to %d)\n", averages, SPECTRUM_MAX_AVERAGES);
+        return -1;
+    }
+    spec->fftSize = fftSize;
+    spec->averages = averages;
+    spec->sampleRate = sampleRate;
+
+    spec->window = malloc(fftSize * sizeof(float));
+    spec->bitReverse = malloc(fftSize * sizeof(uint32_t));
+    spec->twiddleRe = malloc(fftSize * sizeof(float));
+    spec->twiddleIm = malloc(fftSize * sizeof(float));
+    spec->re = malloc(fftSize * sizeof(float));
+    spec->im = malloc(fftSize * sizeof(float));
+    spec->power = calloc(fftSize, sizeof(float));
+    spec->datagram = malloc(sizeof(spectrumHeader) + SPECTRUM_BINS_PER_DATAGRAM);
+    if (spec->window == NULL || spec->bitReverse == NULL || spec->twiddleRe == NULL || spec->twiddleIm == NULL
+        || spec->re == NULL || spec->im == NULL || spec->power == NULL || spec->datagram == NULL) {
+        fprintf(stderr, "Failed to allocate the spectrum buffers\n");
+        spectrum_close(spec);
+        return -1;
+    }
+
+    unsigned int bits = 0;
+    while ((1u << bits) < fftSize) {
+        bits++;
+    }
+    double windowSum = 0;
+    for (unsigned int n = 0; n < fftSize; n++) {
+        spec->window[n] = (float)(0.5 - 0.5 * cos(2 * M_PI * n / fftSize));
+        windowSum += spec->window[n];
+        uint32_t reversed = 0;
+        for (unsigned int b = 0; b < bits; b++) {
+            reversed |= ((n >> b) & 1u) << (bits - 1 - b);
+        }
+        spec->bitReverse[n] = reversed;
+    }
+    // stage with butterflies h apart needs exp(-i pi k / h) for k < h
+    for (unsigned int h = 1; h < fftSize; h <<= 1) {
+        for (unsigned int k = 0; k < h; k++) {
+            spec->twiddleRe[h - 1 + k] = (float)cos(M_PI * k / h);
+            spec->twiddleIm[h - 1 + k] = (float)-sin(M_PI * k / h);
+        }
+    }
+    // a full-scale tone peaks at 32768 * sum(window) in its bin
+    double fullScale = 32768.0 * windowSum;
+    spec->scale = (float)(1.0 / (fullScale * fullScale * averages));
+    return 0;
+}
+
+/**
+ * @brief Open the UDP socket the frames go out on
+ *
+ * @return int 0 on success, -1 on failure
+ */
+int spectrum_open(spectrum *spec, const char *ip, int port)
+{
+    memset(&spec->dest, 0, sizeof(spec->dest));
+    spec->dest.sin_family = AF_INET;
+    spec->dest.sin_port = htons(port);
+    if (inet_pton(AF_INET, ip, &spec->dest.sin_addr) <= 0) {
+        fprintf(stderr, "Invalid spectrum destination: %s\n", ip);
+        return -1;
+    }
+    spec->sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (spec->sock < 0) {
+        perror("Failed to create the spectrum socket");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Radix-2 decimation-in-time FFT of the (bit-reversed) buffer, in place
+ */
+static void transform(spectrum *spec)
+{
+    unsigned int fftSize = spec->fftSize;
+    float *re = spec->re;
+    float *im = spec->im;
+    for (unsigned int h = 1; h < fftSize; h <<= 1) {
+        const float *wr = spec->twiddleRe + h - 1;
+        const float *wi = spec->twiddleIm + h - 1;
+        for (unsigned int start = 0; start < fftSize; start += 2 * h) {
+            float *ar = re + start;
+            float *ai = im + start;
+            float *br = ar + h;
+            float *bi = ai + h;
+            unsigned int k = 0;
+#ifdef SPECTRUM_NEON
+            // 4 butterflies at a time once the halves are 4 apart or more
+            for (; k + 4 <= h; k += 4) {
+                float32x4_t xr = vld1q_f32(br + k);
+                float32x4_t xi = vld1q_f32(bi + k);
+                float32x4_t cr = vld1q_f32(wr + k);
+                float32x4_t ci = vld1q_f32(wi + k);
+                float32x4_t tr = vmlsq_f32(vmulq_f32(xr, cr), xi, ci);
+                float32x4_t ti = vmlaq_f32(vmulq_f32(xr, ci), xi, cr);
+                float32x4_t yr = vld1q_f32(ar + k);
+                float32x4_t yi = vld1q_f32(ai + k);
+                vst1q_f32(br + k, vsubq_f32(yr, tr));
+                vst1q_f32(bi + k, vsubq_f32(yi, ti));
+                vst1q_f32(ar + k, vaddq_f32(yr, tr));
+                vst1q_f32(ai + k, vaddq_f32(yi, ti));
+            }
+#endif
+            for (; k < h; k++) {
+                float tr = br[k] * wr[k] - bi[k] * wi[k];
+                float ti = br[k] * wi[k] + bi[k] * wr[k];
+                br[k] = ar[k] - tr;
+                bi[k] = ai[k] - ti;
+                ar[k] += tr;
+                ai[k] += ti;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Add the power of the transformed buffer to the frame sum
+ */
+static void accumulate_power(spectrum *spec)
+{
+    unsigned int k = 0;
+#ifdef SPECTRUM_NEON
+    for (; k + 4 <= spec->fftSize; k += 4) {
+        float32x4_t r = vld1q_f32(spec->re + k);
+        float32x4_t i = vld1q_f32(spec->im + k);
+        float32x4_t p = vmlaq_f32(vld1q_f32(spec->power + k), r, r);
+        vst1q_f32(spec->power + k, vmlaq_f32(p, i, i));
+    }
+#endif
+    for (; k < spec->fftSize; k++) {
+        spec->power[k] += spec->re[k] * spec->re[k] + spec->im[k] * spec->im[k];
+    }
+}
+
+/**
+ * @brief Quantize the averaged power to dB bytes and send the frame
+ */
+static void send_frame(spectrum *spec, volatile unsigned int *radio)
+{
+    unsigned int fftSize = spec->fftSize;
+    spectrumHeader *header = (spectrumHeader *)spec->datagram;
+    memset(header, 0, sizeof(*header));
+    header->magic = SPECTRUM_MAGIC;
+    header->version = SPECTRUM_VERSION;
+    header->headerWords = sizeof(spectrumHeader) / sizeof(uint32_t);
+    header->sequence = spec->sequence++;
+    header->fftSize = (uint16_t)fftSize;
+    header->averages = (uint16_t)spec->averages;
+    header->sampleRate = spec->sampleRate;
+    header->floorDb = SPECTRUM_FLOOR_DB;
+    header->stepCentiDb = SPECTRUM_STEP_CENTI_DB;
+    if (radio != NULL) {
+        header->flags = SDR_FLAG_TIMESTAMPS;
+        header->tunerPinc = radioTuner_getTunerPinc(radio);
+        header->captureTicks = radioTuner_getTimer(radio);
+    }
+
+    uint8_t *bins = spec->datagram + sizeof(spectrumHeader);
+    for (unsigned int first = 0; first < fftSize; first += SPECTRUM_BINS_PER_DATAGRAM) {
+        unsigned int count = fftSize - first;
+        count = (count < SPECTRUM_BINS_PER_DATAGRAM) ? count : SPECTRUM_BINS_PER_DATAGRAM;
+        for (unsigned int b = 0; b < count; b++) {
+            unsigned int k = (first + b + fftSize / 2) & (fftSize - 1); // negative frequencies first
+            float db = 10.0f * log10f(spec->power[k] * spec->scale + 1e-30f);
+            float step = (db - SPECTRUM_FLOOR_DB) * (100.0f / SPECTRUM_STEP_CENTI_DB);
+            bins[b] = (step <= 0) ? 0 : (step >= 255 ? 255 : (uint8_t)(step + 0.5f));
+        }
+        header->firstBin = (uint16_t)first;
+        header->binCount = (uint16_t)count;
+        if (spec->sock >= 0 && sendto(spec->sock, spec->datagram, sizeof(spectrumHeader) + count, MSG_DONTWAIT,
+                                      (struct sockaddr *)&spec->dest, sizeof(spec->dest)) < 0) {
+            spec->stats.sendErrors++;
+        }
+    }
+    spec->stats.frames++;
+}
+
+/**
+ * @brief Feed drained raw FIFO words, send a frame every `averages` FFTs
+ *
+ * @param spec spectrum
+ * @param in raw FIFO words (I high, Q low)
+ * @param count number of words
+ * @param radio radio tuner registers for the frame header, NULL if not mapped
+ * @return unsigned int frames sent
+ */
+unsigned int spectrum_process(spectrum *spec, const uint32_t *in, unsigned int count, volatile unsigned int *radio)
+{
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    unsigned int frames = 0;
+    for (unsigned int n = 0; n < count; n++) {
+        // window into bit-reversed order, the FFT then runs in natural order
+        uint32_t slot = spec->bitReverse[spec->fill];
+        float w = spec->window[spec->fill];
+        spec->re[slot] = (int16_t)(in[n] >> 16) * w;
+        spec->im[slot] = (int16_t)in[n] * w;
+        if (++spec->fill < spec->fftSize) {
+            continue;
+        }
+        struct timespec fftStart, fftEnd;
+        clock_gettime(CLOCK_MONOTONIC, &fftStart);
+        transform(spec);
+        accumulate_power(spec);
+        clock_gettime(CLOCK_MONOTONIC, &fftEnd);
+        spec->stats.fftNanoseconds += (uint64_t)((fftEnd.tv_sec - fftStart.tv_sec) * 1000000000LL
+                                                 + (fftEnd.tv_nsec - fftStart.tv_nsec));
+        spec->stats.ffts++;
+        spec->fill = 0;
+        if (++spec->summed == spec->averages) {
+            send_frame(spec, radio);
+            memset(spec->power, 0, spec->fftSize * sizeof(float));
+            spec->summed = 0;
+            frames++;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    spec->stats.nanoseconds += (uint64_t)((end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec));
+    return frames;
+}
+
+/**
+ * @brief Which butterflies the FFT runs ("NEON" or "scalar")
+ */
+const char *spectrum_backend(void)
+{
+#ifdef SPECTRUM_NEON
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
+
+/**
+ * @brief Close the socket and free the buffers
+ */
+void spectrum_close(spectrum *spec)
+{
+    if (spec->sock >= 0) {
+        close(spec->sock);
+    }
+    spec->sock = -1;
+    free(spec->window);
+    free(spec->bitReverse);
+    free(spec->twiddleRe);
+    free(spec->twiddleIm);
+    free(spec->re);
+    free(spec->im);
+    free(spec->power);
+    free(spec->datagram);
+    spec->window = NULL;
+    spec->bitReverse = NULL;
+    spec->twiddleRe = NULL;
+    spec->twiddleIm = NULL;
+    spec->re = NULL;
+    spec->im = NULL;
+    spec->power = NULL;
+    spec->datagram = NULL;
+}
+
+/**
+ * @brief Print the FFT rate, the frames sent and what an FFT costs on the reader's core
+ */
+void spectrum_printStats(const spectrum *spec, double seconds)
+{
+    printf("Spectrum summary (%u-point FFT, %u averages, %s butterflies):\n", spec->fftSize, spec->averages,
+           spectrum_backend());
+    printf("    FFTs: %llu (%.1f FFTs/s)\n", (unsigned long long)spec->stats.ffts,
+           seconds > 0 ? spec->stats.ffts / seconds : 0.0);
+    printf("    Frames sent: %llu, %llu datagrams refused\n", (unsigned long long)spec->stats.frames,
+           (unsigned long long)spec->stats.sendErrors);
+    if (spec->stats.ffts > 0) {
+        double usPerFft = spec->stats.fftNanoseconds / 1e3 / spec->stats.ffts;
+        printf("    Cost: %.1f us per FFT (up to %.0f FFTs/s per core), %.1f%% of the reader's time\n", usPerFft,
+               1e6 / usPerFft, seconds > 0 ? spec->stats.nanoseconds / 1e7 / seconds : 0.0);
+    }
+}
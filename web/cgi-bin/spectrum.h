@@ -0,0 +1,111 @@
+/**
+ * @file spectrum.h
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Averaged FFT power spectrum of the drained FIFO samples
+ * @details Collects the raw FIFO words the streamer drains into Hann-windowed
+ *          frames of fftSize samples, transforms them with a radix-2 FFT on
+ *          split real/imaginary arrays (4 butterflies per NEON step from the
+ *          third stage on), and averages the power of `averages` frames. The
+ *          averaged spectrum goes out as a compact frame of one byte per bin
+ *          on its own UDP port, so a spectrum view of a board costs a small
+ *          fraction of its IQ stream.
+ *
+ *          Frame wire format (little endian): a spectrumHeader, then binCount
+ *          bytes, bin b meaning floorDb + b * stepCentiDb / 100 dB relative to
+ *          a full-scale tone. Bins run from -sampleRate/2 to +sampleRate/2 (DC
+ *          in the middle). A spectrum wider than one datagram is split into
+ *          several, told apart by firstBin.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef _SPECTRUM_H_
+#define _SPECTRUM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <netinet/in.h>
+
+#define SPECTRUM_MAGIC              0x43455053  // "SPEC" on the wire
+#define SPECTRUM_VERSION            1
+#define SPECTRUM_MIN_FFT            64
+#define SPECTRUM_MAX_FFT            8192
+#define SPECTRUM_DEFAULT_FFT        1024
+#define SPECTRUM_DEFAULT_AVERAGES   16          // FFTs averaged per frame
+#define SPECTRUM_MAX_AVERAGES       4096
+#define SPECTRUM_BINS_PER_DATAGRAM  1024        // most bins per UDP datagram
+#define SPECTRUM_FLOOR_DB           -160        // dB of bin value 0
+#define SPECTRUM_STEP_CENTI_DB      63          // dB/100 per bin value step (255 steps: -160 to about 0 dBFS)
+
+/**
+ * @brief Spectrum frame header (36 bytes, followed by binCount bytes)
+ */
+typedef struct spectrumHeader
+{
+    uint32_t magic;             // SPECTRUM_MAGIC
+    uint8_t  version;           // SPECTRUM_VERSION
+    uint8_t  headerWords;       // header length in 32-bit words, the bins start after it
+    uint16_t flags;             // SDR_FLAG_TIMESTAMPS when captureTicks is valid
+    uint32_t sequence;          // spectrum number, the same in every datagram of a frame
+    uint16_t fftSize;           // bins in the whole spectrum
+    uint16_t averages;          // FFTs averaged
+    uint16_t firstBin;          // first bin of this datagram
+    uint16_t binCount;          // bins in this datagram
+    uint32_t sampleRate;        // samples per second of the transformed samples
+    uint32_t tunerPinc;         // mixer phase increment (freq * 2^27 / 125 MHz), the center frequency
+    uint32_t captureTicks;      // radio timer when the last sample of the frame was drained
+    int16_t  floorDb;           // dB of bin value 0
+    uint16_t stepCentiDb;       // dB/100 per bin value step
+} spectrumHeader;
+
+_Static_assert(sizeof(spectrumHeader) == 36, "spectrumHeader must stay 36 bytes");
+
+/**
+ * @brief Spectrum counters
+ */
+typedef struct spectrumStats
+{
+    uint64_t ffts;              // FFTs computed
+    uint64_t frames;            // averaged spectra sent
+    uint64_t sendErrors;        // datagrams the socket refused
+    uint64_t nanoseconds;       // time spent in spectrum_process()
+    uint64_t fftNanoseconds;    // time spent windowing and transforming
+} spectrumStats;
+
+/**
+ * @brief Averaged FFT power spectrum
+ */
+typedef struct spectrum
+{
+    unsigned int fftSize;       // points per FFT (power of two)
+    unsigned int averages;      // FFTs per spectrum frame
+    unsigned int sampleRate;    // samples per second in
+    float *window;              // Hann window
+    uint32_t *bitReverse;       // where sample n goes in the FFT input
+    float *twiddleRe;           // twiddles of every stage, stage of half size h at [h - 1]
+    float *twiddleIm;
+    float *re;                  // FFT buffer, real parts
+    float *im;                  // FFT buffer, imaginary parts
+    float *power;               // power summed over the FFTs of the frame
+    float scale;                // power sum to a fraction of a full-scale tone
+    unsigned int fill;          // samples in the FFT buffer
+    unsigned int summed;        // FFTs in the power sum
+    uint8_t *datagram;          // header + bins of one datagram
+    int sock;                   // UDP socket of the frames (-1: not open)
+    struct sockaddr_in dest;    // where they go
+    uint32_t sequence;          // next spectrum number
+    spectrumStats stats;        // counters
+} spectrum;
+
+/**  Function Prototype */
+int spectrum_init(spectrum *spec, unsigned int fftSize, unsigned int averages, unsigned int sampleRate);
+int spectrum_open(spectrum *spec, const char *ip, int port);
+unsigned int spectrum_process(spectrum *spec, const uint32_t *in, unsigned int count, volatile unsigned int *radio);
+const char *spectrum_backend(void);
+void spectrum_close(spectrum *spec);
+void spectrum_printStats(const spectrum *spec, double seconds);
+
+#endif /* _SPECTRUM_H_ */
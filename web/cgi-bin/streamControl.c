@@ -0,0 +1,329 @@
+/**
+ * @file streamControl.c
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Run-time reconfiguration of the FIFO streamer
+ * @details See streamControl.h. The control thread parses a command, posts it
+ *          to the mailbox and waits for the reader to apply it. If the reader
+ *          does not reach a packet boundary within STREAM_CONTROL_TIMEOUT_MS
+ *          (the stream is stalled), the command is taken back and refused.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* Include */
+#include "streamControl.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define STREAM_CONTROL_POLL_MS 200 // how often the control thread checks for stop
+
+static const char *command_names[STREAM_CMD_COUNT] = { "DEST", "TUNE", "PAUSE", "RESUME", "SIZE", "STATUS" };
+
+static uint64_t ns_between(const struct timespec *start, const struct timespec *end)
+{
+    return (uint64_t)((end->tv_sec - start->tv_sec) * 1000000000LL + (end->tv_nsec - start->tv_nsec));
+}
+
+/**
+ * @brief Parse one command line into the mailbox entry
+ * @return int 0 on success, -1 on a malformed command
+ */
+static int parse_command(char *line, streamCommand *cmd)
+{
+    char *save = NULL;
+    char *verb = strtok_r(line, " \t\r\n", &save);
+    char *arg = strtok_r(NULL, " \t\r\n", &save);
+    char *extra = strtok_r(NULL, " \t\r\n", &save);
+    if (verb == NULL || extra != NULL) {
+        return -1;
+    }
+    int type = 0;
+    while (type < STREAM_CMD_COUNT && strcmp(verb, command_names[type]) != 0) {
+        type++;
+    }
+    if (type == STREAM_CMD_COUNT) {
+        return -1;
+    }
+    cmd->type = (streamCommandType)type;
+    bool needsArg = (type == STREAM_CMD_DEST || type == STREAM_CMD_TUNE || type == STREAM_CMD_SIZE);
+    if (needsArg != (arg != NULL)) {
+        return -1;
+    }
+
+    char *end = NULL;
+    switch (cmd->type) {
+        case STREAM_CMD_DEST: {
+            char ip[INET_ADDRSTRLEN];
+            int port = 0;
+            char tail;
+            memset(&cmd->dest, 0, sizeof(cmd->dest));
+            cmd->dest.sin_family = AF_INET;
+            if (sscanf(arg, "%15[0-9.]:%d%c", ip, &port, &tail) != 2 || port <= 0 || port > 65535
+                || inet_pton(AF_INET, ip, &cmd->dest.sin_addr) <= 0) {
+                return -1;
+            }
+            cmd->dest.sin_port = htons((uint16_t)port);
+            return 0;
+        }
+        case STREAM_CMD_TUNE:
+            cmd->hz = strtod(arg, &end);
+            return (end == arg || *end != '\0') ? -1 : 0;
+        case STREAM_CMD_SIZE: {
+            unsigned long samples = strtoul(arg, &end, 10);
+            cmd->samples = (unsigned int)samples;
+            return (end == arg || *end != '\0' || samples > 65535) ? -1 : 0;
+        }
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Hand a command to the reader and wait until it is applied
+ * @return int 0 if the reader applied or refused it, -1 if it never got to it
+ */
+static int post_command(streamControl *ctl)
+{
+    atomic_store_explicit(&ctl->mailbox, STREAM_MAILBOX_POSTED, memory_order_release);
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += STREAM_CONTROL_TIMEOUT_MS * 1000000L;
+    deadline.tv_sec += deadline.tv_nsec / 1000000000;
+    deadline.tv_nsec %= 1000000000;
+    while (sem_timedwait(&ctl->done, &deadline) != 0) {
+        if (errno == EINTR) {
+            continue;
+        }
+        int expected = STREAM_MAILBOX_POSTED;
+        if (atomic_compare_exchange_strong(&ctl->mailbox, &expected, STREAM_MAILBOX_EMPTY)) {
+            return -1; // taken back before the reader saw it
+        }
+        sem_wait(&ctl->done); // the reader is applying it right now
+        break;
+    }
+    return 0;
+}
+
+/**
+ * @brief Answer one message of a client
+ * @return int 0 to keep the connection, -1 to close it
+ */
+static int handle_request(streamControl *ctl, int fd)
+{
+    char msg[STREAM_CONTROL_MSG_MAX + 1];
+    char reply[STREAM_CONTROL_MSG_MAX];
+    ssize_t len = recv(fd, msg, STREAM_CONTROL_MSG_MAX, MSG_TRUNC);
+    if (len <= 0) {
+        return -1; // closed by the client
+    }
+    streamCommand *cmd = &ctl->command;
+    memset(cmd, 0, sizeof(*cmd));
+    clock_gettime(CLOCK_MONOTONIC, &cmd->arrival);
+    ctl->requests++;
+
+    if (len > STREAM_CONTROL_MSG_MAX) {
+        snprintf(reply, sizeof(reply), "ERR command longer than %d bytes\n", STREAM_CONTROL_MSG_MAX);
+    } else {
+        msg[len] = '\0';
+        if (parse_command(msg, cmd) != 0) {
+            snprintf(reply, sizeof(reply), "ERR usage: DEST <ip>:<port> | TUNE <hz> | PAUSE | RESUME | SIZE <samples> | STATUS\n");
+        } else if (post_command(ctl) != 0) {
+            ctl->stats[cmd->type].errors++;
+            snprintf(reply, sizeof(reply), "ERR no packet boundary within %d ms\n", STREAM_CONTROL_TIMEOUT_MS);
+        } else if (cmd->result != 0) {
+            ctl->stats[cmd->type].errors++;
+            snprintf(reply, sizeof(reply), "ERR %s\n", cmd->fields);
+        } else {
+            uint64_t ns = ns_between(&cmd->arrival, &cmd->applied);
+            uint64_t applyNs = ns_between(&cmd->taken, &cmd->applied);
+            streamCommandStats *s = &ctl->stats[cmd->type];
+            s->count++;
+            s->totalNs += ns;
+            s->maxNs = ns > s->maxNs ? ns : s->maxNs;
+            s->applyNsTotal += applyNs;
+            s->applyNsMax = applyNs > s->applyNsMax ? applyNs : s->applyNsMax;
+            snprintf(reply, sizeof(reply), "OK %.1f apply=%.1f%s\n", ns / 1e3, applyNs / 1e3, cmd->fields);
+        }
+    }
+    return send(fd, reply, strlen(reply), MSG_NOSIGNAL) < 0 ? -1 : 0;
+}
+
+/**
+ * @brief Control thread: serve the clients until stopped
+ */
+static void *control_task(void *arg)
+{
+    streamControl *ctl = arg;
+    struct pollfd fds[1 + STREAM_CONTROL_MAX_CLIENTS];
+    unsigned int numClients = 0;
+    fds[0].fd = ctl->listenFd;
+    fds[0].events = POLLIN;
+    while (!atomic_load(&ctl->stop)) {
+        if (poll(fds, 1 + numClients, STREAM_CONTROL_POLL_MS) <= 0) {
+            continue;
+        }
+        for (unsigned int i = 1; i <= numClients; i++) {
+            if (fds[i].revents == 0) {
+                continue;
+            }
+            if ((fds[i].revents & POLLIN) == 0 || handle_request(ctl, fds[i].fd) != 0) {
+                close(fds[i].fd);
+                fds[i--] = fds[numClients--]; // look at the one moved here next
+            }
+        }
+        if (fds[0].revents & POLLIN) {
+            int fd = accept(ctl->listenFd, NULL, NULL);
+            if (fd >= 0 && numClients == STREAM_CONTROL_MAX_CLIENTS) {
+                close(fd); // the client sees the connection drop and retries later
+            } else if (fd >= 0) {
+                numClients++;
+                fds[numClients].fd = fd;
+                fds[numClients].events = POLLIN;
+                fds[numClients].revents = 0;
+            }
+        }
+    }
+    for (unsigned int i = 1; i <= numClients; i++) {
+        close(fds[i].fd);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Open the control socket and start the control thread
+ *
+ * @param ctl stream control
+ * @param path socket path, replaced if a streamer that was killed left it behind
+ * @return int 0 on success, -1 on failure (another streamer serves the path)
+ */
+int streamControl_start(streamControl *ctl, const char *path)
+{
+    memset(ctl, 0, sizeof(*ctl));
+    ctl->path = path;
+    ctl->listenFd = -1;
+    atomic_init(&ctl->stop, 0);
+    atomic_init(&ctl->mailbox, STREAM_MAILBOX_EMPTY);
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Control socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (fd < 0) {
+        perror("Failed to create the control socket");
+        return -1;
+    }
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+        fprintf(stderr, "Another streamer is serving %s\n", path);
+        close(fd);
+        return -1;
+    }
+    close(fd);
+
+    unlink(path);
+    fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, STREAM_CONTROL_MAX_CLIENTS) != 0) {
+        perror("Failed to listen on the control socket");
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    sem_init(&ctl->done, 0, 0);
+    ctl->listenFd = fd;
+    if (pthread_create(&ctl->thread, NULL, control_task, ctl) != 0) {
+        perror("Failed to create the control thread");
+        close(fd);
+        unlink(path);
+        sem_destroy(&ctl->done);
+        ctl->listenFd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Stop the control thread and remove the socket
+ * @details Call while the reader is still running or after it has exited: a
+ *          command posted after the reader stopped times out on its own.
+ */
+void streamControl_stop(streamControl *ctl)
+{
+    if (ctl->listenFd < 0) {
+        return;
+    }
+    atomic_store(&ctl->stop, 1);
+    pthread_join(ctl->thread, NULL); // wakes up within STREAM_CONTROL_POLL_MS
+    close(ctl->listenFd);
+    unlink(ctl->path);
+    sem_destroy(&ctl->done);
+    ctl->listenFd = -1;
+}
+
+/**
+ * @brief Take the posted command, called by the reader at a packet boundary
+ *
+ * @param ctl stream control
+ * @return streamCommand* the command to apply, NULL if there is none (or it was taken back)
+ */
+streamCommand *streamControl_take(streamControl *ctl)
+{
+    int expected = STREAM_MAILBOX_POSTED;
+    if (!atomic_compare_exchange_strong(&ctl->mailbox, &expected, STREAM_MAILBOX_TAKEN)) {
+        return NULL;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &ctl->command.taken);
+    return &ctl->command;
+}
+
+/**
+ * @brief Hand the applied command back, its result and fields filled in
+ */
+void streamControl_finish(streamControl *ctl)
+{
+    clock_gettime(CLOCK_MONOTONIC, &ctl->command.applied);
+    atomic_store_explicit(&ctl->mailbox, STREAM_MAILBOX_EMPTY, memory_order_release);
+    sem_post(&ctl->done);
+}
+
+/**
+ * @brief Name of a command
+ */
+const char *streamControl_name(streamCommandType type)
+{
+    return (type < STREAM_CMD_COUNT) ? command_names[type] : "?";
+}
+
+/**
+ * @brief Print the latency of every command
+ */
+void streamControl_printStats(const streamControl *ctl)
+{
+    printf("Stream control summary:\n");
+    printf("    Requests: %llu on %s\n", (unsigned long long)ctl->requests, ctl->path);
+    for (int c = 0; c < STREAM_CMD_COUNT; c++) {
+        const streamCommandStats *s = &ctl->stats[c];
+        if (s->count > 0 || s->errors > 0) {
+            printf("    %-6s: %llu applied, %llu refused, mean %.1f us (apply %.1f us), max %.1f us (apply %.1f us)\n",
+                   command_names[c], (unsigned long long)s->count, (unsigned long long)s->errors,
+                   s->count ? s->totalNs / 1e3 / s->count : 0.0, s->count ? s->applyNsTotal / 1e3 / s->count : 0.0,
+                   s->maxNs / 1e3, s->applyNsMax / 1e3);
+        }
+    }
+}
@@ -0,0 +1,132 @@
+/**
+ * @file streamControl.h
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Run-time reconfiguration of the FIFO streamer
+ * @details udpFifoStreamer listens on a local SOCK_SEQPACKET socket for one
+ *          command per message:
+ *
+ *              DEST <ip>:<port>    replace the static destination (-i/-p)
+ *              TUNE <hz>           mixer frequency, then drop the settling samples
+ *              PAUSE               keep draining the FIFO, send nothing
+ *              RESUME              send again, from the next full packet
+ *              SIZE <samples>      samples per packet, up to what the MTU allows
+ *              STATUS              current settings and counters
+ *
+ *          The control thread only parses a command. It is handed to the
+ *          reader thread through a one-entry mailbox and applied between two
+ *          packets, so the FIFO is never reset and no queued packet is lost.
+ *          The reader looks at the mailbox with one atomic load per drain.
+ *
+ *          The reply is `OK <us> apply=<us> [fields]` or `ERR <reason>`: the
+ *          time from the arrival of the command until it was applied, and the
+ *          part of it the reader spent applying it. radioClient_request()
+ *          works as the client (see streamerCtl.c).
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef _STREAM_CONTROL_H_
+#define _STREAM_CONTROL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+#include <netinet/in.h>
+
+#define STREAM_CONTROL_SOCKET       "/var/run/udpFifoStreamer.sock" // default socket path
+#define STREAM_CONTROL_MSG_MAX      256     // longest command or reply
+#define STREAM_CONTROL_MAX_CLIENTS  4       // connections served at once
+#define STREAM_CONTROL_TIMEOUT_MS   500     // longest wait for a packet boundary (clients wait 1 s)
+
+/**
+ * @brief Commands of the protocol
+ */
+typedef enum streamCommandType
+{
+    STREAM_CMD_DEST = 0,
+    STREAM_CMD_TUNE,
+    STREAM_CMD_PAUSE,
+    STREAM_CMD_RESUME,
+    STREAM_CMD_SIZE,
+    STREAM_CMD_STATUS,
+    STREAM_CMD_COUNT
+} streamCommandType;
+
+/**
+ * @brief Mailbox states
+ */
+typedef enum streamMailbox
+{
+    STREAM_MAILBOX_EMPTY = 0,   // nothing to apply
+    STREAM_MAILBOX_POSTED,      // a command waits for the reader
+    STREAM_MAILBOX_TAKEN        // the reader is applying it
+} streamMailbox;
+
+/**
+ * @brief One command on its way to the reader
+ */
+typedef struct streamCommand
+{
+    streamCommandType type;             // what to do
+    struct sockaddr_in dest;            // DEST address
+    double hz;                          // TUNE frequency
+    unsigned int samples;               // SIZE samples per packet
+    struct timespec arrival;            // CLOCK_MONOTONIC arrival of the command
+    struct timespec taken;              // when the reader picked it up
+    struct timespec applied;            // when the reader was done with it
+    int result;                         // 0 applied, -1 refused (set by the reader)
+    char fields[STREAM_CONTROL_MSG_MAX / 2]; // reply fields or the reason of a refusal (set by the reader)
+} streamCommand;
+
+/**
+ * @brief Latency counters of one command
+ */
+typedef struct streamCommandStats
+{
+    uint64_t count;             // commands applied
+    uint64_t errors;            // commands refused or timed out
+    uint64_t totalNs;           // sum of their latencies (arrival to applied)
+    uint64_t maxNs;             // worst latency
+    uint64_t applyNsTotal;      // sum of the time the reader spent applying them
+    uint64_t applyNsMax;        // worst of the above
+} streamCommandStats;
+
+/**
+ * @brief Control socket and the mailbox to the reader
+ */
+typedef struct streamControl
+{
+    const char *path;                   // socket path
+    int listenFd;                       // listening socket (-1: not started)
+    pthread_t thread;                   // control thread
+    atomic_int stop;                    // ask the control thread to exit
+    atomic_int mailbox;                 // streamMailbox
+    streamCommand command;              // the posted command, the reader's while taken
+    sem_t done;                         // posted by the reader once the command is applied
+    streamCommandStats stats[STREAM_CMD_COUNT]; // per command (control thread)
+    uint64_t requests;                  // messages received
+} streamControl;
+
+/**  Function Prototype */
+int streamControl_start(streamControl *ctl, const char *path);
+void streamControl_stop(streamControl *ctl);
+streamCommand *streamControl_take(streamControl *ctl);
+void streamControl_finish(streamControl *ctl);
+const char *streamControl_name(streamCommandType type);
+void streamControl_printStats(const streamControl *ctl);
+
+/**
+ * @brief Is a command waiting for the reader (one relaxed load, for the hot path)
+ */
+static inline bool streamControl_posted(streamControl *ctl)
+{
+    return atomic_load_explicit(&ctl->mailbox, memory_order_relaxed) == STREAM_MAILBOX_POSTED;
+}
+
+#endif /* _STREAM_CONTROL_H_ */
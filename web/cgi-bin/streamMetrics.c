@@ -0,0 +1,188 @@
+/**
+ * @file streamMetrics.c
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Streamer counters and histograms in a shared-memory segment
+ * @details See streamMetrics.h. The streamer creates the segment and removes
+ *          it on exit; streamerStats attaches to it read-only. When the
+ *          segment cannot be created the counters go to private memory, so
+ *          the hot path never has to check.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* Include */
+#include "streamMetrics.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static uint64_t now_ns(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * @brief Fill in the header and publish the segment
+ */
+static void init_header(streamMetrics *metrics, const char *name, const char *program, unsigned int fifoDepth)
+{
+    metrics->version = STREAM_METRICS_VERSION;
+    metrics->size = sizeof(streamMetrics);
+    metrics->pid = (int32_t)getpid();
+    snprintf(metrics->program, sizeof(metrics->program), "%s", program);
+    snprintf(metrics->segment, sizeof(metrics->segment), "%s", name != NULL ? name : "");
+    metrics->fifoDepth = fifoDepth;
+    metrics->startUnixNs = now_ns(CLOCK_REALTIME);
+    atomic_store_explicit(&metrics->magic, STREAM_METRICS_MAGIC, memory_order_release);
+}
+
+/**
+ * @brief Create the metrics segment
+ *
+ * @param name shared-memory name, e.g. STREAM_METRICS_NAME (NULL: keep the counters private)
+ * @param program streamer name, shown by the exporter
+ * @param fifoDepth FIFO depth in words
+ * @return streamMetrics* the counters, shared if possible, NULL if not even private memory was available
+ */
+streamMetrics *streamMetrics_open(const char *name, const char *program, unsigned int fifoDepth)
+{
+    const char *base = strrchr(program, '/');
+    program = (base != NULL) ? base + 1 : program;
+    if (name != NULL) {
+        int fd = shm_open(name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0 && ftruncate(fd, sizeof(streamMetrics)) == 0) {
+            void *map = mmap(NULL, sizeof(streamMetrics), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            close(fd);
+            if (map != MAP_FAILED) {
+                init_header(map, name, program, fifoDepth); // truncated to zero, every counter starts at 0
+                return map;
+            }
+        } else if (fd >= 0) {
+            close(fd);
+        }
+        perror("Failed to create the metrics segment");
+        shm_unlink(name);
+        fprintf(stderr, "Continuing without shared metrics\n");
+    }
+    streamMetrics *metrics = aligned_alloc(STREAM_METRICS_CACHE_LINE, sizeof(streamMetrics));
+    if (metrics == NULL) {
+        perror("Failed to allocate the metrics");
+        return NULL;
+    }
+    memset(metrics, 0, sizeof(streamMetrics));
+    init_header(metrics, NULL, program, fifoDepth);
+    return metrics;
+}
+
+/**
+ * @brief Remove the metrics segment, the exporter reports the streamer as down
+ */
+void streamMetrics_close(streamMetrics *metrics)
+{
+    if (metrics == NULL) {
+        return;
+    }
+    if (metrics->segment[0] != '\0') {
+        shm_unlink(metrics->segment);
+        munmap(metrics, sizeof(streamMetrics));
+    } else {
+        free(metrics);
+    }
+}
+
+/**
+ * @brief Record one poll of the FIFO (reader thread)
+ * @details Takes the occupancy and drain time axiFifo_drain() measured
+ *          anyway, so the poll costs no extra register read or clock call.
+ */
+void streamMetrics_polled(streamMetrics *metrics, const axiFifo *fifo, const fifoLoss *loss)
+{
+    streamReaderMetrics *reader = &metrics->reader;
+    streamMetrics_add(&reader->polls, 1);
+    streamMetrics_set(&reader->wordsDrained, fifo->wordsDrained);
+    streamMetrics_observe(&reader->occupancy, fifo->lastOccupancy);
+    if (fifo->lastDrainNs > 0) {
+        streamMetrics_observe(&reader->drainNs, fifo->lastDrainNs);
+    }
+    streamMetrics_set(&reader->overflows, loss->overflows);
+    streamMetrics_set(&reader->lostSamples, loss->lostSamples);
+    streamMetrics_set(&reader->readErrors, loss->readErrors);
+    streamMetrics_set(&reader->discontinuities, loss->flaggedPackets);
+    streamMetrics_set(&reader->lossEventsLastMinute, loss->lastMinuteEvents);
+}
+
+/**
+ * @brief Record one send (sender thread)
+ *
+ * @param metrics counters
+ * @param tx transmitter, its totals are copied over
+ * @param queueDepth packets that were queued when the send started, its batch included
+ */
+void streamMetrics_sent(streamMetrics *metrics, const udpTx *tx, unsigned int queueDepth)
+{
+    streamSenderMetrics *sender = &metrics->sender;
+    uint64_t now = now_ns(CLOCK_MONOTONIC);
+    uint64_t last = atomic_load_explicit(&sender->lastSendNs, memory_order_relaxed);
+    if (last != 0) {
+        streamMetrics_observe(&sender->gapNs, now - last);
+    }
+    streamMetrics_set(&sender->lastSendNs, now);
+    streamMetrics_add(&sender->batches, 1);
+    streamMetrics_set(&sender->queueDepth, queueDepth);
+    streamMetrics_observe(&sender->queue, queueDepth);
+    streamMetrics_set(&sender->packets, tx->packets);
+    streamMetrics_set(&sender->bytes, tx->bytes);
+    streamMetrics_set(&sender->syscalls, tx->syscalls);
+    streamMetrics_set(&sender->errors, tx->errors);
+    streamMetrics_set(&sender->errorsAgain, tx->errorsAgain);
+    streamMetrics_set(&sender->errorsNoBufs, tx->errorsNoBufs);
+}
+
+/**
+ * @brief Map a streamer's segment read-only (exporter)
+ * @return const streamMetrics* the segment, NULL if there is none or its layout is different
+ */
+const streamMetrics *streamMetrics_attach(const char *name)
+{
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(streamMetrics)) {
+        close(fd);
+        return NULL;
+    }
+    const streamMetrics *metrics = mmap(NULL, sizeof(streamMetrics), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (metrics == MAP_FAILED) {
+        return NULL;
+    }
+    if (atomic_load_explicit(&metrics->magic, memory_order_acquire) != STREAM_METRICS_MAGIC
+        || metrics->version != STREAM_METRICS_VERSION || metrics->size != sizeof(streamMetrics)) {
+        munmap((void *)metrics, sizeof(streamMetrics));
+        return NULL;
+    }
+    return metrics;
+}
+
+/**
+ * @brief Unmap a segment mapped by streamMetrics_attach()
+ */
+void streamMetrics_detach(const streamMetrics *metrics)
+{
+    if (metrics != NULL) {
+        munmap((void *)metrics, sizeof(streamMetrics));
+    }
+}
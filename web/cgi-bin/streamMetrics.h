@@ -0,0 +1,147 @@
+/**
+ * @file streamMetrics.h
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Streamer counters and histograms in a shared-memory segment
+ * @details The streamers keep their counters in a POSIX shared-memory segment
+ *          (/dev/shm/udpFifoStreamer.metrics by default) that streamerStats
+ *          maps read-only and prints in the Prometheus text format.
+ *
+ *          Every counter has exactly one writer: the reader block is written
+ *          by the thread that drains the FIFO, the sender block by the thread
+ *          that sends, and the two blocks sit on separate cache lines. A
+ *          writer updates a counter with a relaxed load and store, no locked
+ *          read-modify-write, and never looks at the readers of the segment.
+ *          A scrape costs the streamer nothing but the cache lines it pulls.
+ *          A scrape may see a histogram one observation ahead of its sum.
+ *
+ *          Histograms have power-of-two buckets: bucket k counts the values
+ *          up to 2^k, the last one everything larger.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef _STREAM_METRICS_H_
+#define _STREAM_METRICS_H_
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "axiFifo.h"
+#include "udpTx.h"
+#include "fifoLoss.h"
+
+#define STREAM_METRICS_NAME         "/udpFifoStreamer.metrics" // default segment, under /dev/shm
+#define STREAM_METRICS_MAGIC        0x4d524453  // "SDRM", set once the segment is filled in
+#define STREAM_METRICS_VERSION      2           // bumped whenever the layout changes
+#define STREAM_METRICS_BUCKETS      28          // up to 2^26 (67 ms in ns), then +Inf
+#define STREAM_METRICS_CACHE_LINE   64          // keeps the reader and sender blocks apart
+#define STREAM_METRICS_NAME_MAX     64          // longest segment or program name
+
+/**
+ * @brief Histogram with power-of-two buckets
+ */
+typedef struct streamHistogram
+{
+    atomic_ullong buckets[STREAM_METRICS_BUCKETS]; // bucket k: values <= 2^k (last: the rest)
+    atomic_ullong sum;                  // sum of the observed values
+} streamHistogram;
+
+/**
+ * @brief Counters of the FIFO reader (written by the reader thread only)
+ */
+typedef struct streamReaderMetrics
+{
+    atomic_ullong polls;                // FIFO occupancy polls
+    atomic_ullong wordsDrained;         // words read from the FIFO
+    atomic_ullong packetsBuilt;         // packets handed to the sender
+    atomic_ullong packetsDropped;       // packets dropped because the ring was full
+    atomic_ullong overflows;            // polls that found the FIFO full and samples lost
+    atomic_ullong lostSamples;          // samples the radio produced that never reached the FIFO
+    atomic_ullong readErrors;           // drains that found an ISR read error bit
+    atomic_ullong discontinuities;      // packets flagged SDR_FLAG_DISCONTINUITY
+    atomic_ullong lossEventsLastMinute; // overflows and read errors in the last full minute
+    streamHistogram occupancy;          // words in the FIFO at each poll
+    streamHistogram drainNs;            // time each poll spent copying words out of the FIFO
+} streamReaderMetrics;
+
+/**
+ * @brief Counters of the UDP sender (written by the sender thread only)
+ */
+typedef struct streamSenderMetrics
+{
+    atomic_ullong batches;              // sends (one batch each)
+    atomic_ullong packets;              // datagrams sent, every destination counts
+    atomic_ullong bytes;                // payload bytes sent
+    atomic_ullong syscalls;             // send syscalls made
+    atomic_ullong errors;               // failed send syscalls
+    atomic_ullong errorsAgain;          // of those, EAGAIN
+    atomic_ullong errorsNoBufs;         // of those, ENOBUFS
+    atomic_ullong queueDepth;           // packets queued when the last send started, its batch included
+    atomic_ullong lastSendNs;           // CLOCK_MONOTONIC of the last send
+    streamHistogram queue;              // queueDepth at every send
+    streamHistogram gapNs;              // time between two sends (a batch leaves back to back)
+} streamSenderMetrics;
+
+/**
+ * @brief The shared-memory segment
+ */
+typedef struct streamMetrics
+{
+    atomic_uint magic;                  // STREAM_METRICS_MAGIC once the fields below are valid
+    uint32_t version;                   // STREAM_METRICS_VERSION
+    uint32_t size;                      // sizeof(streamMetrics)
+    int32_t pid;                        // process that writes the segment
+    char program[STREAM_METRICS_NAME_MAX]; // which streamer it is
+    char segment[STREAM_METRICS_NAME_MAX]; // shared-memory name ("": private, nobody can read it)
+    uint32_t fifoDepth;                 // FIFO depth in words
+    uint64_t startUnixNs;               // CLOCK_REALTIME at startup
+    _Alignas(STREAM_METRICS_CACHE_LINE) streamReaderMetrics reader;
+    _Alignas(STREAM_METRICS_CACHE_LINE) streamSenderMetrics sender;
+} streamMetrics;
+
+/**  Function Prototype */
+streamMetrics *streamMetrics_open(const char *name, const char *program, unsigned int fifoDepth);
+void streamMetrics_close(streamMetrics *metrics);
+void streamMetrics_polled(streamMetrics *metrics, const axiFifo *fifo, const fifoLoss *loss);
+void streamMetrics_sent(streamMetrics *metrics, const udpTx *tx, unsigned int queueDepth);
+const streamMetrics *streamMetrics_attach(const char *name);
+void streamMetrics_detach(const streamMetrics *metrics);
+
+/**
+ * @brief Add to a counter that only the calling thread writes
+ */
+static inline void streamMetrics_add(atomic_ullong *counter, uint64_t value)
+{
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+/**
+ * @brief Set a counter or gauge that only the calling thread writes
+ */
+static inline void streamMetrics_set(atomic_ullong *counter, uint64_t value)
+{
+    atomic_store_explicit(counter, value, memory_order_relaxed);
+}
+
+/**
+ * @brief Bucket of a value: the smallest k with value <= 2^k
+ */
+static inline unsigned int streamMetrics_bucket(uint64_t value)
+{
+    unsigned int k = (value <= 1) ? 0 : 64 - __builtin_clzll(value - 1);
+    return k < STREAM_METRICS_BUCKETS ? k : STREAM_METRICS_BUCKETS - 1;
+}
+
+/**
+ * @brief Add one value to a histogram that only the calling thread writes
+ */
+static inline void streamMetrics_observe(streamHistogram *histogram, uint64_t value)
+{
+    streamMetrics_add(&histogram->buckets[streamMetrics_bucket(value)], 1);
+    streamMetrics_add(&histogram->sum, value);
+}
+
+#endif /* _STREAM_METRICS_H_ */
@@ -0,0 +1,72 @@
+/**
+ * @file streamerCtl.c
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Send one command to a running udpFifoStreamer
+ * @details The words on the command line are joined into one command (see
+ *          streamControl.h), e.g. `streamerCtl DEST 192.168.1.5:25344`. The
+ *          reply is printed with the round trip; the exit status is 0 for OK.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* Include */
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "radioClient.h"
+#include "streamControl.h"
+
+void usage(const char *executableName);
+
+int main(int argc, char const *argv[])
+{
+    int opt = 0;
+    const char *socket_path = STREAM_CONTROL_SOCKET;
+    while ((opt = getopt(argc, (char * const *)argv, "s:h")) != -1) {
+        switch (opt) {
+            case 's':
+                socket_path = optarg; break;
+            case 'h':
+                usage(argv[0]); return 0;
+            default:
+                usage(argv[0]); return -1;
+        }
+    }
+    if (optind >= argc) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    char command[STREAM_CONTROL_MSG_MAX];
+    size_t used = 0;
+    for (int i = optind; i < argc; i++) {
+        int n = snprintf(command + used, sizeof(command) - used, "%s%s", i > optind ? " " : "", argv[i]);
+        if (n < 0 || (size_t)n >= sizeof(command) - used) {
+            fprintf(stderr, "Command longer than %d bytes\n", STREAM_CONTROL_MSG_MAX);
+            return -1;
+        }
+        used += (size_t)n;
+    }
+
+    char reply[STREAM_CONTROL_MSG_MAX];
+    double roundTripUs = 0;
+    if (radioClient_request(socket_path, command, reply, sizeof(reply), &roundTripUs) != 0) {
+        fprintf(stderr, "No reply from the streamer at %s\n", socket_path);
+        return -1;
+    }
+    printf("%s", reply);
+    printf("round trip %.1f us\n", roundTripUs);
+    return strncmp(reply, "OK", 2) == 0 ? 0 : 1;
+}
+
+void usage(const char *executableName)
+{
+    fprintf(stderr, "Usage: %s [-s <socket>] <command> [<argument>]\n\n", executableName);
+    fprintf(stderr, "  -s <socket>          : Control socket of the streamer (default: %s)\n\n", STREAM_CONTROL_SOCKET);
+    fprintf(stderr, "  commands             : DEST <ip>:<port> | TUNE <hz> | PAUSE | RESUME | SIZE <samples> | STATUS\n\n");
+    fprintf(stderr, "  -h                   : Show this help message\n\n");
+}
@@ -0,0 +1,167 @@
+/**
+ * @file streamerStats.c
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Print the metrics of a running FIFO streamer in the Prometheus text format
+ * @details Maps the streamer's metrics segment (see streamMetrics.h)
+ *          read-only and prints it once. Run from the web server as
+ *          streamerStats.cgi it answers a Prometheus scrape of
+ *          /cgi-bin/streamerStats.cgi. Without a streamer it prints
+ *          sdr_streamer_up 0.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* Include */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "streamMetrics.h"
+
+void usage(const char *executableName);
+
+static uint64_t load(const atomic_ullong *counter)
+{
+    return atomic_load_explicit((atomic_ullong *)counter, memory_order_relaxed);
+}
+
+static void print_head(const char *name, const char *type, const char *help)
+{
+    printf("# HELP %s %s\n", name, help);
+    printf("# TYPE %s %s\n", name, type);
+}
+
+static void print_value(const char *name, const char *type, const char *help, double value)
+{
+    print_head(name, type, help);
+    printf("%s %.15g\n", name, value);
+}
+
+/**
+ * @brief Print a histogram with cumulative buckets
+ * @param scale multiplies the bucket bounds and the sum (1e-9: ns to seconds)
+ */
+static void print_histogram(const char *name, const char *help, const streamHistogram *histogram, double scale)
+{
+    print_head(name, "histogram", help);
+    uint64_t count = 0;
+    for (unsigned int k = 0; k < STREAM_METRICS_BUCKETS; k++) {
+        count += load(&histogram->buckets[k]);
+        if (k + 1 < STREAM_METRICS_BUCKETS) {
+            printf("%s_bucket{le=\"%.9g\"} %llu\n", name, (double)(1ull << k) * scale, (unsigned long long)count);
+        } else {
+            printf("%s_bucket{le=\"+Inf\"} %llu\n", name, (unsigned long long)count);
+        }
+    }
+    printf("%s_sum %.15g\n", name, load(&histogram->sum) * scale);
+    printf("%s_count %llu\n", name, (unsigned long long)count);
+}
+
+static void print_metrics(const streamMetrics *metrics)
+{
+    const streamReaderMetrics *reader = &metrics->reader;
+    const streamSenderMetrics *sender = &metrics->sender;
+
+    print_head("sdr_streamer_info", "gauge", "Streamer that writes the metrics");
+    printf("sdr_streamer_info{program=\"%s\",pid=\"%d\"} 1\n", metrics->program, (int)metrics->pid);
+    print_value("sdr_streamer_start_time_seconds", "gauge", "Start of the streamer since the Unix epoch",
+                metrics->startUnixNs / 1e9);
+    print_value("sdr_streamer_fifo_depth_words", "gauge", "Receive FIFO depth", metrics->fifoDepth);
+
+    print_value("sdr_streamer_fifo_polls_total", "counter", "FIFO occupancy polls", load(&reader->polls));
+    print_value("sdr_streamer_fifo_words_drained_total", "counter", "Words read from the FIFO",
+                load(&reader->wordsDrained));
+    print_histogram("sdr_streamer_fifo_occupancy_words", "Words in the FIFO at each poll", &reader->occupancy, 1);
+    print_histogram("sdr_streamer_fifo_drain_duration_seconds", "Time each poll spent copying words out of the FIFO",
+                    &reader->drainNs, 1e-9);
+    print_value("sdr_streamer_packets_built_total", "counter", "Packets handed to the sender",
+                load(&reader->packetsBuilt));
+    print_value("sdr_streamer_packets_dropped_total", "counter", "Packets dropped because the ring was full",
+                load(&reader->packetsDropped));
+    print_value("sdr_streamer_fifo_overflows_total", "counter", "Polls that found the FIFO full and samples lost",
+                load(&reader->overflows));
+    print_value("sdr_streamer_fifo_lost_samples_total", "counter", "Samples that never reached the FIFO",
+                load(&reader->lostSamples));
+    print_value("sdr_streamer_fifo_read_errors_total", "counter", "Drains that found a receive error bit in the ISR",
+                load(&reader->readErrors));
+    print_value("sdr_streamer_discontinuities_total", "counter", "Packets flagged as a discontinuity",
+                load(&reader->discontinuities));
+    print_value("sdr_streamer_fifo_loss_events_last_minute", "gauge", "Overflows and read errors in the last full minute",
+                load(&reader->lossEventsLastMinute));
+
+    print_value("sdr_streamer_send_batches_total", "counter", "Sends, one batch each", load(&sender->batches));
+    print_value("sdr_streamer_packets_sent_total", "counter", "Datagrams sent, every destination counts",
+                load(&sender->packets));
+    print_value("sdr_streamer_bytes_sent_total", "counter", "Payload bytes sent", load(&sender->bytes));
+    print_value("sdr_streamer_send_syscalls_total", "counter", "Send syscalls made", load(&sender->syscalls));
+    uint64_t errors = load(&sender->errors);
+    uint64_t again = load(&sender->errorsAgain);
+    uint64_t noBufs = load(&sender->errorsNoBufs);
+    print_head("sdr_streamer_send_errors_total", "counter", "Failed send syscalls by errno");
+    printf("sdr_streamer_send_errors_total{errno=\"EAGAIN\"} %llu\n", (unsigned long long)again);
+    printf("sdr_streamer_send_errors_total{errno=\"ENOBUFS\"} %llu\n", (unsigned long long)noBufs);
+    // read one by one, the total may already count an error the split does not
+    printf("sdr_streamer_send_errors_total{errno=\"other\"} %llu\n",
+           (unsigned long long)(errors > again + noBufs ? errors - again - noBufs : 0));
+    print_value("sdr_streamer_queue_depth_packets", "gauge", "Packets queued when the last send started, its batch included",
+                load(&sender->queueDepth));
+    print_histogram("sdr_streamer_send_queue_packets", "Packets queued at each send, its batch included",
+                    &sender->queue, 1);
+    print_histogram("sdr_streamer_send_gap_seconds", "Time between two sends, a batch leaves back to back",
+                    &sender->gapNs, 1e-9);
+    uint64_t lastSend = load(&sender->lastSendNs);
+    if (lastSend != 0) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        uint64_t nowNs = (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+        print_value("sdr_streamer_last_send_age_seconds", "gauge", "Time since the last send",
+                    nowNs > lastSend ? (nowNs - lastSend) / 1e9 : 0.0);
+    }
+}
+
+int main(int argc, char const *argv[])
+{
+    int opt = 0;
+    const char *name = STREAM_METRICS_NAME;
+    while ((opt = getopt(argc, (char * const *)argv, "n:h")) != -1) {
+        switch (opt) {
+            case 'n':
+                name = optarg; break;
+            case 'h':
+                usage(argv[0]); return 0;
+            default:
+                usage(argv[0]); return -1;
+        }
+    }
+
+    // under the web server, answer the scrape
+    bool cgi = getenv("GATEWAY_INTERFACE") != NULL;
+    if (cgi) {
+        printf("Content-Type: text/plain; version=0.0.4\n\n");
+    }
+
+    const streamMetrics *metrics = streamMetrics_attach(name);
+    // a streamer that was killed leaves its segment behind
+    bool up = metrics != NULL && (kill(metrics->pid, 0) == 0 || errno == EPERM);
+    print_value("sdr_streamer_up", "gauge", "Whether a running streamer writes the metrics", up ? 1 : 0);
+    if (up) {
+        print_metrics(metrics);
+    }
+    streamMetrics_detach(metrics);
+    return (up || cgi) ? 0 : 1;
+}
+
+void usage(const char *executableName)
+{
+    fprintf(stderr, "Usage: %s [-n <name>]\n\n", executableName);
+    fprintf(stderr, "  -n <name>            : Metrics segment of the streamer, its -P (default: %s)\n\n", STREAM_METRICS_NAME);
+    fprintf(stderr, "  -h                   : Show this help message\n\n");
+}
@@ -0,0 +1,470 @@
+/**
+ * @file subscriberTable.c
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Receivers of the FIFO streamer, registered at run time
+ * @details See subscriberTable.h.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* Include */
+#include "subscriberTable.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+/**
+ * @brief Format an address as ip:port
+ */
+static const char *addr_str(const struct sockaddr_in *addr, char *buf, size_t len)
+{
+    char ip[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &addr->sin_addr, ip, sizeof(ip));
+    snprintf(buf, len, "%s:%u", ip, ntohs(addr->sin_port));
+    return buf;
+}
+
+#define ROTL(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+#define SIPROUND                                                        \
+    do {                                                                \
+        v0 += v1; v1 = ROTL(v1, 13); v1 ^= v0; v0 = ROTL(v0, 32);       \
+        v2 += v3; v3 = ROTL(v3, 16); v3 ^= v2;                          \
+        v0 += v3; v3 = ROTL(v3, 21); v3 ^= v0;                          \
+        v2 += v1; v1 = ROTL(v1, 17); v1 ^= v2; v2 = ROTL(v2, 32);       \
+    } while (0)
+
+/**
+ * @brief SipHash-2-4 of one 64-bit word
+ */
+static uint64_t siphash_word(const uint64_t key[2], uint64_t m)
+{
+    uint64_t v0 = key[0] ^ 0x736f6d6570736575ull;
+    uint64_t v1 = key[1] ^ 0x646f72616e646f6dull;
+    uint64_t v2 = key[0] ^ 0x6c7967656e657261ull;
+    uint64_t v3 = key[1] ^ 0x7465646279746573ull;
+    uint64_t b = 8ull << 56; // message length in the last block
+    v3 ^= m;
+    SIPROUND;
+    SIPROUND;
+    v0 ^= m;
+    v3 ^= b;
+    SIPROUND;
+    SIPROUND;
+    v0 ^= b;
+    v2 ^= 0xff;
+    SIPROUND;
+    SIPROUND;
+    SIPROUND;
+    SIPROUND;
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+/**
+ * @brief Cookie of a requester and the destination it asks for
+ */
+static uint64_t make_cookie(const subscriberTable *table, const struct sockaddr_in *from, const struct sockaddr_in *addr)
+{
+    uint64_t ips = ((uint64_t)from->sin_addr.s_addr << 32) | addr->sin_addr.s_addr;
+    return siphash_word(table->cookieKey, ips ^ ((uint64_t)ntohs(addr->sin_port) << 16));
+}
+
+/**
+ * @brief Parse [ip:]port, the ip defaults to that of `from`
+ * @details An explicit unicast ip must be that of `from`: the stream only goes
+ *          to the host that asked for it, or to a multicast group.
+ * @return int 0 on success, -1 if malformed, -2 for another host's address
+ */
+static int parse_addr(const char *text, const struct sockaddr_in *from, struct sockaddr_in *addr)
+{
+    char ip[INET_ADDRSTRLEN];
+    const char *colon = strrchr(text, ':');
+    const char *portText = text;
+
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    if (colon != NULL) {
+        size_t ipLen = (size_t)(colon - text);
+        if (ipLen == 0 || ipLen >= sizeof(ip)) {
+            return -1;
+        }
+        memcpy(ip, text, ipLen);
+        ip[ipLen] = '\0';
+        if (inet_pton(AF_INET, ip, &addr->sin_addr) <= 0) {
+            return -1;
+        }
+        if (!IN_MULTICAST(ntohl(addr->sin_addr.s_addr)) && addr->sin_addr.s_addr != from->sin_addr.s_addr) {
+            return -2;
+        }
+        portText = colon + 1;
+    } else {
+        addr->sin_addr = from->sin_addr;
+    }
+
+    char *end = NULL;
+    long port = strtol(portText, &end, 10);
+    if (end == portText || *end != '\0' || port <= 0 || port > 65535) {
+        return -1;
+    }
+    addr->sin_port = htons((uint16_t)port);
+    return 0;
+}
+
+/**
+ * @brief Find the entry of an address (caller holds the lock)
+ */
+static subscriber *find_entry(subscriberTable *table, const struct sockaddr_in *addr)
+{
+    for (unsigned int i = 0; i < SUBSCRIBER_MAX; i++) {
+        subscriber *entry = &table->entries[i];
+        if (entry->active && entry->addr.sin_addr.s_addr == addr->sin_addr.s_addr
+            && entry->addr.sin_port == addr->sin_port) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Add an address to the table or renew its lease (caller holds the lock)
+ * @return subscriber* its entry, NULL if the table is full
+ */
+static subscriber *add_entry(subscriberTable *table, const struct sockaddr_in *addr, bool permanent)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    subscriber *entry = find_entry(table, addr);
+    if (entry != NULL) {
+        entry->renewals++;
+    } else {
+        for (unsigned int i = 0; i < SUBSCRIBER_MAX && entry == NULL; i++) {
+            if (!table->entries[i].active) {
+                entry = &table->entries[i];
+            }
+        }
+        if (entry == NULL) {
+            return NULL;
+        }
+        entry->addr = *addr;
+        entry->multicast = IN_MULTICAST(ntohl(addr->sin_addr.s_addr));
+        entry->renewals = 0;
+        atomic_store(&entry->counters.packets, 0);
+        atomic_store(&entry->counters.bytes, 0);
+        atomic_store(&entry->counters.errors, 0);
+        atomic_store(&entry->counters.lastErrno, 0);
+        entry->active = true;
+        atomic_fetch_add(&table->version, 1); // the sender picks up the new destination
+    }
+    entry->permanent = entry->permanent || permanent;
+    entry->expires = now;
+    entry->expires.tv_sec += table->leaseSeconds;
+    return entry;
+}
+
+/**
+ * @brief Print what a receiver got and take it out of the table (caller holds the lock)
+ */
+static void remove_entry(subscriberTable *table, subscriber *entry, const char *why)
+{
+    char name[32];
+    printf("[Subscribers]: %s %s after %llu packets, %llu send errors\n", addr_str(&entry->addr, name, sizeof(name)),
+           why, (unsigned long long)atomic_load(&entry->counters.packets),
+           (unsigned long long)atomic_load(&entry->counters.errors));
+    entry->active = false;
+    atomic_fetch_add(&table->version, 1);
+}
+
+/**
+ * @brief Answer one control datagram
+ */
+static void handle_request(subscriberTable *table, char *msg, const struct sockaddr_in *from)
+{
+    char reply[64];
+    char name[32];
+    struct sockaddr_in addr;
+
+    table->requests++;
+    msg[strcspn(msg, "\r\n")] = '\0';
+    char verb[8], target[48], cookie[SUBSCRIBER_COOKIE_CHARS + 2];
+    int fields = sscanf(msg, "%7s %47s %17s", verb, target, cookie);
+    bool sub = fields >= 2 && strcmp(verb, "SUB") == 0;
+    bool unsub = fields >= 2 && strcmp(verb, "UNSUB") == 0;
+    int parsed = (sub || unsub) ? parse_addr(target, from, &addr) : -1;
+
+    if (parsed == -2) {
+        snprintf(reply, sizeof(reply), "ERR unicast only to the requesting host\n");
+        table->rejected++;
+    } else if (parsed != 0) {
+        snprintf(reply, sizeof(reply), "ERR usage: SUB|UNSUB [group:]port [cookie]\n");
+        table->rejected++;
+    } else if (fields < 3 || strtoull(cookie, NULL, 16) != make_cookie(table, from, &addr)) {
+        // proves the requester receives at its address before anything is sent there
+        snprintf(reply, sizeof(reply), "COOKIE %0*llx\n", SUBSCRIBER_COOKIE_CHARS,
+                 (unsigned long long)make_cookie(table, from, &addr));
+        table->challenged++;
+    } else if (sub) {
+        pthread_mutex_lock(&table->lock);
+        bool isNew = (find_entry(table, &addr) == NULL);
+        subscriber *entry = add_entry(table, &addr, false);
+        pthread_mutex_unlock(&table->lock);
+        if (entry == NULL) {
+            snprintf(reply, sizeof(reply), "ERR table full (%d subscribers)\n", SUBSCRIBER_MAX);
+            table->rejected++;
+        } else {
+            if (isNew) {
+                printf("[Subscribers]: %s subscribed%s\n", addr_str(&addr, name, sizeof(name)),
+                       entry->multicast ? " (multicast)" : "");
+            }
+            snprintf(reply, sizeof(reply), "OK %u\n", table->leaseSeconds);
+        }
+    } else {
+        pthread_mutex_lock(&table->lock);
+        subscriber *entry = find_entry(table, &addr);
+        if (entry == NULL) {
+            snprintf(reply, sizeof(reply), "ERR not subscribed\n");
+        } else if (entry->permanent) {
+            snprintf(reply, sizeof(reply), "ERR permanent destination\n");
+        } else {
+            remove_entry(table, entry, "unsubscribed");
+            snprintf(reply, sizeof(reply), "OK 0\n");
+        }
+        pthread_mutex_unlock(&table->lock);
+    }
+    sendto(table->controlFd, reply, strlen(reply), 0, (const struct sockaddr *)from, sizeof(*from));
+}
+
+/**
+ * @brief Drop the receivers whose lease ran out
+ */
+static void expire_leases(subscriberTable *table)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    pthread_mutex_lock(&table->lock);
+    for (unsigned int i = 0; i < SUBSCRIBER_MAX; i++) {
+        subscriber *entry = &table->entries[i];
+        if (entry->active && !entry->permanent
+            && (now.tv_sec > entry->expires.tv_sec
+                || (now.tv_sec == entry->expires.tv_sec && now.tv_nsec >= entry->expires.tv_nsec))) {
+            remove_entry(table, entry, "expired");
+            table->expired++;
+        }
+    }
+    pthread_mutex_unlock(&table->lock);
+}
+
+/**
+ * @brief Control thread: answer SUB/UNSUB and expire leases until stopped
+ */
+static void *control_task(void *arg)
+{
+    subscriberTable *table = arg;
+    char msg[SUBSCRIBER_MSG_MAX + 1];
+    struct pollfd pfd = { .fd = table->controlFd, .events = POLLIN };
+
+    while (!atomic_load(&table->stop)) {
+        if (poll(&pfd, 1, SUBSCRIBER_POLL_MS) > 0) {
+            struct sockaddr_in from;
+            socklen_t fromLen = sizeof(from);
+            ssize_t n = recvfrom(table->controlFd, msg, SUBSCRIBER_MSG_MAX, MSG_DONTWAIT,
+                                 (struct sockaddr *)&from, &fromLen);
+            if (n > 0 && fromLen == sizeof(from)) {
+                msg[n] = '\0';
+                handle_request(table, msg, &from);
+            }
+        }
+        expire_leases(table);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Start with an empty table
+ *
+ * @param table subscriber table
+ * @param leaseSeconds lease granted per SUB request
+ */
+void subscriberTable_init(subscriberTable *table, unsigned int leaseSeconds)
+{
+    memset(table, 0, sizeof(*table));
+    pthread_mutex_init(&table->lock, NULL);
+    atomic_init(&table->version, 0);
+    atomic_init(&table->stop, 0);
+    table->leaseSeconds = leaseSeconds;
+    table->controlFd = -1;
+    int fd = open("/dev/urandom", O_RDONLY);
+    if (fd < 0 || read(fd, table->cookieKey, sizeof(table->cookieKey)) != sizeof(table->cookieKey)) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        table->cookieKey[0] = ((uint64_t)now.tv_sec << 32) ^ (uint64_t)now.tv_nsec ^ (uint64_t)getpid();
+        table->cookieKey[1] = ~table->cookieKey[0] * 0x9e3779b97f4a7c15ull;
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+/**
+ * @brief Add a destination that never expires (command line, multicast group)
+ *
+ * @param table subscriber table
+ * @param ip destination or multicast group address
+ * @param port destination UDP port
+ * @return int 0 on success, -1 on an invalid address or a full table
+ */
+int subscriberTable_addPermanent(subscriberTable *table, const char *ip, int port)
+{
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    if (port <= 0 || port > 65535 || inet_pton(AF_INET, ip, &addr.sin_addr) <= 0) {
+        fprintf(stderr, "Invalid destination: %s:%d\n", ip, port);
+        return -1;
+    }
+    pthread_mutex_lock(&table->lock);
+    subscriber *entry = add_entry(table, &addr, true);
+    pthread_mutex_unlock(&table->lock);
+    if (entry == NULL) {
+        fprintf(stderr, "Too many destinations (at most %d)\n", SUBSCRIBER_MAX);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Move the static destination to a new address in one step
+ * @details Both changes happen under the lock, so the sender's next snapshot
+ *          has either the old or the new destination, never both or neither.
+ *
+ * @param table subscriber table
+ * @param from current static destination, NULL if there is none
+ * @param to new static destination
+ * @return int 0 on success, -1 if the table is full
+ */
+int subscriberTable_replacePermanent(subscriberTable *table, const struct sockaddr_in *from, const struct sockaddr_in *to)
+{
+    pthread_mutex_lock(&table->lock);
+    subscriber *entry = (from != NULL) ? find_entry(table, from) : NULL;
+    if (entry != NULL && entry->permanent) {
+        remove_entry(table, entry, "replaced");
+    }
+    subscriber *added = add_entry(table, to, true);
+    pthread_mutex_unlock(&table->lock);
+    return added != NULL ? 0 : -1;
+}
+
+/**
+ * @brief Open the control port and start the control thread
+ *
+ * @param table subscriber table
+ * @param controlPort UDP port the SUB/UNSUB requests arrive on
+ * @return int 0 on success, -1 on failure
+ */
+int subscriberTable_start(subscriberTable *table, int controlPort)
+{
+    table->controlFd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (table->controlFd < 0) {
+        perror("Failed to create the subscriber control socket");
+        return -1;
+    }
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((uint16_t)controlPort);
+    if (bind(table->controlFd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        perror("Failed to bind the subscriber control port");
+        close(table->controlFd);
+        table->controlFd = -1;
+        return -1;
+    }
+    if (pthread_create(&table->thread, NULL, control_task, table) != 0) {
+        perror("Failed to create the subscriber control thread");
+        close(table->controlFd);
+        table->controlFd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Stop the control thread and close the control port
+ */
+void subscriberTable_stop(subscriberTable *table)
+{
+    if (table->controlFd < 0) {
+        return;
+    }
+    atomic_store(&table->stop, 1);
+    pthread_join(table->thread, NULL); // wakes up within SUBSCRIBER_POLL_MS
+    close(table->controlFd);
+    table->controlFd = -1;
+}
+
+/**
+ * @brief Copy the current destinations for the sender
+ * @details The counters point into the table; an entry that is reused before
+ *          the sender takes the next snapshot may get a few packets counted
+ *          for its previous receiver.
+ *
+ * @param table subscriber table
+ * @param dests receives up to SUBSCRIBER_MAX addresses
+ * @param counters receives the matching counters
+ * @param version receives the version the snapshot belongs to
+ * @return unsigned int number of destinations
+ */
+unsigned int subscriberTable_snapshot(subscriberTable *table, struct sockaddr_in *dests,
+                                      udpTxCounters **counters, unsigned int *version)
+{
+    unsigned int count = 0;
+    pthread_mutex_lock(&table->lock);
+    *version = atomic_load(&table->version);
+    for (unsigned int i = 0; i < SUBSCRIBER_MAX; i++) {
+        if (table->entries[i].active) {
+            dests[count] = table->entries[i].addr;
+            counters[count] = &table->entries[i].counters;
+            count++;
+        }
+    }
+    pthread_mutex_unlock(&table->lock);
+    return count;
+}
+
+/**
+ * @brief Print the receivers still in the table and the control counters
+ */
+void subscriberTable_printStats(subscriberTable *table)
+{
+    char name[32];
+    printf("Subscriber summary:\n");
+    printf("    Control requests: %llu (%llu rejected, %llu answered with a cookie), expired leases: %llu\n",
+           (unsigned long long)table->requests, (unsigned long long)table->rejected,
+           (unsigned long long)table->challenged, (unsigned long long)table->expired);
+    pthread_mutex_lock(&table->lock);
+    for (unsigned int i = 0; i < SUBSCRIBER_MAX; i++) {
+        subscriber *entry = &table->entries[i];
+        if (!entry->active) {
+            continue;
+        }
+        int lastErrno = atomic_load(&entry->counters.lastErrno);
+        printf("    %-21s %-9s packets %llu, bytes %llu, errors %llu%s%s\n", addr_str(&entry->addr, name, sizeof(name)),
+               entry->permanent ? (entry->multicast ? "multicast" : "static") : "leased",
+               (unsigned long long)atomic_load(&entry->counters.packets),
+               (unsigned long long)atomic_load(&entry->counters.bytes),
+               (unsigned long long)atomic_load(&entry->counters.errors),
+               lastErrno ? ", last: " : "", lastErrno ? strerror(lastErrno) : "");
+    }
+    pthread_mutex_unlock(&table->lock);
+}
@@ -0,0 +1,97 @@
+/**
+ * @file subscriberTable.h
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief Receivers of the FIFO streamer, registered at run time
+ * @details A client subscribes by sending a small text datagram to the control
+ *          port of the streamer and keeps its lease by sending it again before
+ *          the lease runs out:
+ *
+ *              SUB [<group>:]<port> <cookie>     receive the stream at port of the sender of the datagram, or at a multicast group
+ *              UNSUB [<group>:]<port> <cookie>   stop receiving it
+ *
+ *          A request without a valid cookie is answered `COOKIE <hex>`, sent to
+ *          the address the request came from; the client repeats the request
+ *          with it. Only a host that receives at its own address learns its
+ *          cookie, so a request with a spoofed source subscribes nobody and
+ *          the control port cannot point the stream at a third party. The
+ *          cookie is a keyed hash of the requester's address and the
+ *          destination, it stays valid until the streamer restarts.
+ *
+ *          The streamer answers `OK <lease seconds>` or `ERR <reason>`. An
+ *          explicit ip must be a multicast group (or the requester's own).
+ *          Destinations given on the command line are permanent and never
+ *          expire.
+ *
+ *          The control thread owns the table; the sender only takes a snapshot
+ *          when the version counter changed, so a send never waits for the lock.
+ *          Every entry keeps its own send counters (see udpTxCounters).
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef _SUBSCRIBER_TABLE_H_
+#define _SUBSCRIBER_TABLE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <netinet/in.h>
+
+#include "udpTx.h"
+
+#define SUBSCRIBER_MAX              UDP_TX_MAX_DESTS    // entries in the table
+#define SUBSCRIBER_DEFAULT_LEASE_S  10                  // lease of a subscription without renewal
+#define SUBSCRIBER_CONTROL_PORT     25345               // default control port (stream port + 1)
+#define SUBSCRIBER_POLL_MS          200                 // how often expired leases are checked
+#define SUBSCRIBER_MSG_MAX          128                 // longest control datagram
+#define SUBSCRIBER_COOKIE_CHARS     16                  // hex digits of a cookie
+
+/**
+ * @brief One receiver of the stream
+ */
+typedef struct subscriber
+{
+    struct sockaddr_in addr;    // where the packets go
+    bool active;                // entry is in use
+    bool permanent;             // from the command line, never expires
+    bool multicast;             // addr is a multicast group
+    struct timespec expires;    // CLOCK_MONOTONIC end of the lease
+    uint64_t renewals;          // SUB datagrams after the first one
+    udpTxCounters counters;     // sends to this receiver (updated by the sender)
+} subscriber;
+
+/**
+ * @brief Subscriber table and its control socket
+ */
+typedef struct subscriberTable
+{
+    pthread_mutex_t lock;               // protects entries
+    subscriber entries[SUBSCRIBER_MAX]; // receivers
+    atomic_uint version;                // bumped on every change of the destinations
+    unsigned int leaseSeconds;          // lease granted per SUB
+    int controlFd;                      // control socket (-1: no control port)
+    pthread_t thread;                   // control thread
+    atomic_int stop;                    // ask the control thread to exit
+    uint64_t cookieKey[2];              // secret key of the cookies, random per run
+    uint64_t requests;                  // control datagrams received
+    uint64_t rejected;                  // malformed requests or table full
+    uint64_t challenged;                // requests answered with a cookie
+    uint64_t expired;                   // leases that ran out
+} subscriberTable;
+
+/**  Function Prototype */
+void subscriberTable_init(subscriberTable *table, unsigned int leaseSeconds);
+int subscriberTable_addPermanent(subscriberTable *table, const char *ip, int port);
+int subscriberTable_replacePermanent(subscriberTable *table, const struct sockaddr_in *from, const struct sockaddr_in *to);
+int subscriberTable_start(subscriberTable *table, int controlPort);
+void subscriberTable_stop(subscriberTable *table);
+unsigned int subscriberTable_snapshot(subscriberTable *table, struct sockaddr_in *dests,
+                                      udpTxCounters **counters, unsigned int *version);
+void subscriberTable_printStats(subscriberTable *table);
+
+#endif /* _SUBSCRIBER_TABLE_H_ */
@@ -12,27 +12,110 @@
 
 /* Include */
 #include "udpFifoStreamer.h"
+#include "packetRing.h"
+#include "fifoPacer.h"
+#include "fifoLoss.h"
+#include "udpTx.h"
+#include "sigmfRecorder.h"
+#include "subscriberTable.h"
+#include "firDecimator.h"
+#include "fmDemod.h"
+#include "spectrum.h"
+#include "iqCodec.h"
+#include "scanScheduler.h"
+#include "streamControl.h"
+#include "streamMetrics.h"
 
 /** Global Variables */
-volatile unsigned int *axi_fifo_base = NULL;    // Pointer to the AXI FIFO base address
-char *dest_ip = DEFAULT_DEST_IP;                // Destination IP address
+axiFifo fifo;                                   // AXI4-Stream FIFO receive path
+fifoDrainMode drain_mode = FIFO_DRAIN_BURST;    // How the FIFO is drained
+unsigned int axi4_data_addr = 0;                // AXI4 data interface address (0: AXI-Lite only)
+fifoPacer pacer;                                // Occupancy-driven poll pacing
+fifoLoss loss;                                  // Overflow and read-error detection
+unsigned int fifo_depth = FIFO_DEFAULT_DEPTH;   // Receive FIFO depth in words
+unsigned int fill_target = 0;                   // Fill level the reader wakes up at (0: one packet)
+bool fill_target_auto = false;                  // fill_target follows the packet size
+const char *uio_device = NULL;                  // UIO device bound to the FIFO (NULL: poll /dev/mem)
+double stream_seconds = 0;                      // Time the reader spent streaming
+double reader_cpu_seconds = 0;                  // CPU time used by the reader thread
+unsigned int num_samples = DEFAULT_NUM_SAMPLES; // Samples per packet (changed by SIZE, reader thread)
+unsigned int max_samples = 0;                   // Most samples per packet the MTU allows
+packetHeaderMode header_mode = PACKET_HEADER_SDR; // Packet header layout
+size_t header_size = sizeof(sdrPacketHeader);   // Bytes in front of the samples
+size_t packet_size = 0;                         // Bytes per packet at startup (the sdr header gives the current size)
+sdrSampleFormat sample_format = DEFAULT_SAMPLE_FORMAT; // Sample format on the wire
+bool sample_format_given = false;               // -F was on the command line
+size_t raw_offset = 0;                          // Where the raw FIFO words go, relative to the payload
+unsigned int decimation = 1;                    // Keep 1 of every N samples (1: no filtering)
+const char *taps_path = NULL;                   // FIR taps file (NULL: designed for the decimation)
+firDecimator decimator;                         // Decimating FIR filter (owned by the reader thread)
+bool use_decimator = false;                     // Filter the drained samples before packetizing
+unsigned int sample_rate = RADIO_SAMPLE_RATE;   // Sample rate of the packets and the recording
+bool fm_mode = false;                           // Demodulate FM and stream PCM audio instead of IQ
+unsigned int audio_rate = FM_DEFAULT_AUDIO_RATE; // Audio samples per second in FM mode
+unsigned int deemphasis_us = FM_DEFAULT_DEEMPHASIS_US; // FM de-emphasis time constant (0: off)
+fmDemod demod;                                  // FM demodulator (owned by the reader thread)
+int spectrum_port = 0;                          // UDP port of the spectrum frames (0: off)
+unsigned int fft_size = SPECTRUM_DEFAULT_FFT;   // Points per FFT of the spectrum
+unsigned int fft_averages = SPECTRUM_DEFAULT_AVERAGES; // FFTs averaged per spectrum frame
+spectrum spec;                                  // Spectrum engine (owned by the reader thread)
+bool iq_compress = false;                       // Compress every packet losslessly (-C)
+uint64_t codec_raw_bytes = 0;                   // Sample bytes before compression (reader thread)
+uint64_t codec_bytes = 0;                       // Sample bytes after compression (reader thread)
+const char *scan_plan = NULL;                   // Frequency scan plan (NULL: no scan)
+unsigned int scan_settle = SCAN_DEFAULT_SETTLE; // Samples discarded after every retune
+scanScheduler scan;                             // Frequency scan (owned by the reader thread)
+unsigned int settle_samples = 0;                // FIFO words dropped after a retune, on top of the backlog
+volatile unsigned int *radio = NULL;            // Radio tuner registers (tuning and timer for the header)
+char *dest_ip = DEFAULT_DEST_IP;                // Destination IP address ("none": subscribers only)
 int dest_port = DEFAULT_UDP_DEST_PORT;          // Destination UDP port
+bool static_dest = false;                       // There is a static destination (-i, or DEST)
+struct sockaddr_in static_addr;                 // Its address, replaced by DEST
+subscriberTable subscribers;                    // Receivers of the stream (static, multicast and leased)
+int control_port = SUBSCRIBER_CONTROL_PORT;     // Port the SUB/UNSUB requests arrive on (0: off)
+unsigned int lease_seconds = SUBSCRIBER_DEFAULT_LEASE_S; // Lease of a subscription
+char multicast_group[INET_ADDRSTRLEN] = "";     // Last multicast group given with -m
+int multicast_ttl = UDP_TX_MULTICAST_TTL;       // TTL of multicast packets
 int timeout = 0;                                // Timeout in seconds (default: infinite)
-dataPacket packet;                              // Data packet structure
-uint32_t packetID = 0;                          // Packet ID
-sem_t data_ready;                               // Semaphore for data ready signal
-pthread_mutex_t mutex;                          // Mutex for thread synchronization
+unsigned int ring_slots = RING_DEFAULT_SLOTS;   // Number of preallocated packets in the ring
+ringOverrunPolicy ring_policy = RING_DROP_OLDEST; // What the reader does when the ring is full
+packetRing ring;                                // Packet ring between the reader and the sender
+uint32_t packetID = 0;                          // Packet ID (owned by the reader thread)
+uint32_t packetsSent = 0;                       // Packets sent (owned by the sender thread)
+udpTx tx;                                       // UDP transmitter (owned by the sender thread)
+unsigned int batch_size = UDP_TX_DEFAULT_BATCH; // Most packets per sendmmsg() call
+unsigned int flush_us = UDP_TX_DEFAULT_FLUSH_US; // Longest wait for a batch to fill up
+bool use_gso = false;                           // Send batches as UDP GSO super-packets
+bool use_zerocopy = false;                      // Send straight from the ring buffers (MSG_ZEROCOPY)
+double sender_seconds = 0;                      // Time the sender was running
+double sender_cpu_seconds = 0;                  // CPU time used by the sender thread
+const char *control_path = STREAM_CONTROL_SOCKET; // Control socket (NULL: off)
+streamControl control;                          // Run-time commands, applied by the reader between packets
+bool control_started = false;                   // The control socket is open
+bool stream_paused = false;                     // PAUSE: drain and drop (reader thread)
+uint64_t paused_samples = 0;                    // Samples dropped while paused (reader thread)
+uint64_t tune_discarded = 0;                    // Samples dropped after a TUNE (reader thread)
+const char *metrics_name = STREAM_METRICS_NAME; // Shared-memory metrics segment (NULL: private)
+streamMetrics *metrics = NULL;                  // Counters streamerStats reads while streaming
+const char *record_path = NULL;                 // SigMF recording base path (NULL: no recording)
+unsigned int record_buffer_mb = SIGMF_DEFAULT_BUFFER_MB; // Write-behind buffer of the recorder
+bool stream_udp = true;                         // Send the packets over UDP (false: record only)
+sigmfRecorder recorder;                         // SigMF recorder (fed by the reader thread)
 volatile sig_atomic_t terminate = 0;            // Termination flag
 
 /** Thread Tasks */
 void *fifoReaderTask(void *arg);
 void *udpSenderTask(void *arg);
+void signalHandler(int sig);
+void releasePacket(void *buffer, void *arg);
+unsigned int applyControl(streamCommand *cmd);
 
 int main(int argc, char const *argv[])
 {
     int opt = 0;
+    subscriberTable_init(&subscribers, lease_seconds);
     // Check command line arguments
-    while ((opt = getopt(argc, (char * const *)argv, "i:p:t:h")) != -1) {
+    while ((opt = getopt(argc, (char * const *)argv, "i:p:t:s:H:F:N:T:M:S:CQ:q:K:P:n:o:D:A:d:L:u:b:f:GZr:w:Uc:l:m:h")) != -1) {
         switch (opt) {
             case 'i':
                 dest_ip = optarg; break;
@@ -40,6 +123,114 @@ int main(int argc, char const *argv[])
                 dest_port = atoi(optarg); break;
             case 't':
                 timeout = atoi(optarg); break;
+            case 's':
+                num_samples = (unsigned int)atoi(optarg); break;
+            case 'H':
+                if (strcmp(optarg, "sdr") == 0) {
+                    header_mode = PACKET_HEADER_SDR;
+                } else if (strcmp(optarg, "legacy") == 0) {
+                    header_mode = PACKET_HEADER_LEGACY;
+                } else {
+                    fprintf(stderr, "Invalid packet header: %s\n", optarg);
+                    return -1;
+                }
+                break;
+            case 'F':
+                if (sampleFormat_parse(optarg, &sample_format) != 0) {
+                    fprintf(stderr, "Invalid sample format: %s\n", optarg);
+                    return -1;
+                }
+                sample_format_given = true;
+                break;
+            case 'N':
+                decimation = (unsigned int)atoi(optarg); break;
+            case 'T':
+                taps_path = optarg; break;
+            case 'M':
+                // iq, or fm[:audio rate[:de-emphasis us]]
+                if (strcmp(optarg, "iq") == 0) {
+                    fm_mode = false;
+                } else if (strncmp(optarg, "fm", 2) == 0
+                           && (optarg[2] == '\0' || sscanf(optarg + 2, ":%u:%u", &audio_rate, &deemphasis_us) >= 1)) {
+                    fm_mode = true;
+                } else {
+                    fprintf(stderr, "Invalid mode: %s\n", optarg);
+                    return -1;
+                }
+                break;
+            case 'S':
+                // port[:fft size[:averages]]
+                if (sscanf(optarg, "%d:%u:%u", &spectrum_port, &fft_size, &fft_averages) < 1
+                    || spectrum_port <= 0 || spectrum_port > 65535) {
+                    fprintf(stderr, "Invalid spectrum port: %s\n", optarg);
+                    return -1;
+                }
+                break;
+            case 'C':
+                iq_compress = true; break;
+            case 'Q':
+                scan_plan = optarg; break;
+            case 'q':
+                scan_settle = (unsigned int)atoi(optarg); break;
+            case 'K':
+                control_path = (strcmp(optarg, "none") == 0) ? NULL : optarg; break;
+            case 'P':
+                metrics_name = (strcmp(optarg, "none") == 0) ? NULL : optarg; break;
+            case 'n':
+                ring_slots = (unsigned int)atoi(optarg); break;
+            case 'o':
+                if (packetRing_parsePolicy(optarg, &ring_policy) != 0) {
+                    fprintf(stderr, "Invalid overrun policy: %s\n", optarg);
+                    return -1;
+                }
+                break;
+            case 'D':
+                if (axiFifo_parseDrainMode(optarg, &drain_mode) != 0) {
+                    fprintf(stderr, "Invalid drain mode: %s\n", optarg);
+                    return -1;
+                }
+                break;
+            case 'A':
+                axi4_data_addr = (unsigned int)strtoul(optarg, NULL, 0); break;
+            case 'd':
+                fifo_depth = (unsigned int)atoi(optarg); break;
+            case 'L':
+                fill_target = (unsigned int)atoi(optarg); break;
+            case 'u':
+                uio_device = optarg; break;
+            case 'b':
+                batch_size = (unsigned int)atoi(optarg); break;
+            case 'f':
+                flush_us = (unsigned int)atoi(optarg); break;
+            case 'G':
+                use_gso = true; break;
+            case 'Z':
+                use_zerocopy = true; break;
+            case 'r':
+                record_path = optarg; break;
+            case 'w':
+                record_buffer_mb = (unsigned int)atoi(optarg); break;
+            case 'U':
+                stream_udp = false; break;
+            case 'c':
+                control_port = atoi(optarg); break;
+            case 'l':
+                lease_seconds = (unsigned int)atoi(optarg); break;
+            case 'm': {
+                // group:port[:ttl], may be given several times
+                int groupPort = 0;
+                struct in_addr group;
+                if (sscanf(optarg, "%15[0-9.]:%d:%d", multicast_group, &groupPort, &multicast_ttl) < 2
+                    || inet_pton(AF_INET, multicast_group, &group) <= 0 || !IN_MULTICAST(ntohl(group.s_addr))
+                    || multicast_ttl < 0 || multicast_ttl > 255) {
+                    fprintf(stderr, "Invalid multicast group: %s\n", optarg);
+                    return -1;
+                }
+                if (subscriberTable_addPermanent(&subscribers, multicast_group, groupPort) != 0) {
+                    return -1;
+                }
+                break;
+            }
             case 'h':
                 usage(argv[0]); return 0;
             default:
@@ -52,37 +243,258 @@ int main(int argc, char const *argv[])
         fprintf(stderr, "Invalid timeout value: %d\n", timeout);
         return -1;
     }
+    if(batch_size == 0 || batch_size > UDP_TX_MAX_BATCH) {
+        fprintf(stderr, "Invalid batch size: %u (1 to %d)\n", batch_size, UDP_TX_MAX_BATCH);
+        return -1;
+    }
+    if(ring_slots < batch_size + RING_MIN_SLOTS - 1) {
+        fprintf(stderr, "The ring needs at least %u slots for a batch of %u\n", batch_size + RING_MIN_SLOTS - 1, batch_size);
+        return -1;
+    }
+    if(fifo_depth < 16) {
+        fprintf(stderr, "Invalid FIFO depth: %u\n", fifo_depth);
+        return -1;
+    }
+    if(fill_target >= FIFO_PACER_HIGH_WATER(fifo_depth)) {
+        fprintf(stderr, "Invalid fill target: %u (must be below %u for a %u-word FIFO)\n", fill_target,
+                FIFO_PACER_HIGH_WATER(fifo_depth), fifo_depth);
+        return -1;
+    }
+    if(fill_target == 0) {
+        fill_target = num_samples; // wake up once a packet's worth of samples is waiting
+        fill_target_auto = true;
+        if(fill_target >= FIFO_PACER_HIGH_WATER(fifo_depth)) {
+            fill_target = FIFO_PACER_HIGH_WATER(fifo_depth) / 2; // what fifoPacer_init() would make of it
+        }
+    }
+    if(decimation == 0 || decimation > FIR_MAX_DECIMATION) {
+        fprintf(stderr, "Invalid decimation: %u (1 to %d)\n", decimation, FIR_MAX_DECIMATION);
+        return -1;
+    }
+    if(fm_mode && record_path != NULL) {
+        fprintf(stderr, "The recording holds IQ samples, -r does not work with -M fm\n");
+        return -1;
+    }
+    if(fm_mode) {
+        sample_format = SDR_FORMAT_PCM16; // mono audio, 2 bytes per sample
+    }
+    if(header_mode == PACKET_HEADER_LEGACY && sdrPacket_sampleBytes(sample_format) != 4) {
+        fprintf(stderr, "-H legacy has no format field, its receivers expect 4-byte IQ samples (not -F cs8/cf32 or -M fm)\n");
+        return -1;
+    }
+    if(iq_compress && (fm_mode || header_mode != PACKET_HEADER_SDR)) {
+        fprintf(stderr, "-C compresses IQ packets with the sdr header, not with -M fm or -H legacy\n");
+        return -1;
+    }
+    if(iq_compress && sample_format_given && sample_format != SDR_FORMAT_CS16_QI) {
+        fprintf(stderr, "-C sends cs16_qi samples, it does not work with -F %s\n", sampleFormat_name(sample_format));
+        return -1;
+    }
+    if(iq_compress) {
+        sample_format = SDR_FORMAT_CS16_QI; // the codec works on the raw FIFO words and gives them back
+    }
+    if(scan_plan != NULL && (header_mode != PACKET_HEADER_SDR || record_path != NULL)) {
+        fprintf(stderr, "-Q tags the packets in the sdr header, not with -H legacy; -r records one frequency\n");
+        return -1;
+    }
+    if(!stream_udp && record_path == NULL && spectrum_port == 0) {
+        fprintf(stderr, "Nothing to do: -U without -r or -S\n");
+        return -1;
+    }
+    if(record_path != NULL && record_buffer_mb == 0) {
+        fprintf(stderr, "Invalid recording buffer size: %u MB\n", record_buffer_mb);
+        return -1;
+    }
     if(dest_port < 0 || dest_port > 65535) {
         fprintf(stderr, "Invalid port value: %d\n", dest_port);
         return -1;
     }
-    struct sockaddr_in sa;
+    if(control_port < 0 || control_port > 65535 || lease_seconds == 0) {
+        fprintf(stderr, "Invalid control port/lease: %d/%u\n", control_port, lease_seconds);
+        return -1;
+    }
+    subscribers.leaseSeconds = lease_seconds;
+    static_dest = (strcmp(dest_ip, "none") != 0);
+    memset(&static_addr, 0, sizeof(static_addr));
+    static_addr.sin_family = AF_INET;
+    static_addr.sin_port = htons((uint16_t)dest_port);
     // check if the IP address is valid
-    if(inet_pton(AF_INET, dest_ip, &sa) <= 0) {
+    if(static_dest && inet_pton(AF_INET, dest_ip, &static_addr.sin_addr) <= 0) {
         fprintf(stderr, "Invalid IP address: %s\n", dest_ip);
         return -1;
     }
+    if(static_dest && subscriberTable_addPermanent(&subscribers, dest_ip, dest_port) != 0) {
+        return -1;
+    }
+    if(stream_udp && !static_dest && multicast_group[0] == '\0' && control_port == 0) {
+        fprintf(stderr, "Nowhere to send: -i none without -m or a control port\n");
+        return -1;
+    }
+    // a packet must fit in one datagram on the route to the destination (jumbo frames allowed)
+    // subscribers that come later are assumed to sit behind the same MTU
+    const char *mtu_ip = static_dest ? dest_ip : (multicast_group[0] != '\0' ? multicast_group : NULL);
+    int mtu = (mtu_ip != NULL) ? udpTx_pathMtu(mtu_ip, dest_port) : 0;
+    int usableMtu = (mtu <= 0) ? DEFAULT_MTU : (mtu > JUMBO_MTU ? JUMBO_MTU : mtu);
+    header_size = PACKET_HEADER_SIZE(header_mode);
+    unsigned int sampleBytes = sdrPacket_sampleBytes(sample_format);
+    // a compressed packet may come out IQ_CODEC_HEADER_BYTES longer than a raw one
+    size_t codecOverhead = iq_compress ? IQ_CODEC_HEADER_BYTES : 0;
+    max_samples = MAX_SAMPLES_FOR_MTU(usableMtu, header_size + codecOverhead, sampleBytes);
+    if(num_samples < MIN_NUM_SAMPLES || num_samples > max_samples) {
+        fprintf(stderr, "Invalid number of samples per packet: %u (%d to %u for a %d-byte MTU)\n",
+                num_samples, MIN_NUM_SAMPLES, max_samples, usableMtu);
+        return -1;
+    }
+    packet_size = PACKET_SIZE(header_size, num_samples, sampleBytes) + codecOverhead; // the largest packet
+    raw_offset = sampleFormat_rawOffset(sample_format, num_samples);
+    // a taps file filters even without decimation
+    use_decimator = (decimation > 1 || taps_path != NULL);
+    if (use_decimator && firDecimator_init(&decimator, decimation, taps_path) != 0) {
+        return -1;
+    }
+    sample_rate = RADIO_SAMPLE_RATE / decimation;
+    if (fm_mode) {
+        if (fmDemod_init(&demod, sample_rate, audio_rate, deemphasis_us) != 0) {
+            return -1;
+        }
+        sample_rate = audio_rate;
+    }
+    // the filter history holds old samples too, flush it with the settle samples of a retune
+    settle_samples = scan_settle + (use_decimator ? decimator.numTaps : 0);
+    if (scan_plan != NULL) {
+        // a retune waits for the packet boundary, one packet period at the output rate
+        uint32_t packetTicks = (uint32_t)((double)num_samples * RADIO_TIMER_HZ / sample_rate);
+        if (scanScheduler_init(&scan, scan_plan, settle_samples, packetTicks) != 0) {
+            return -1;
+        }
+    }
+    // the spectrum shows the whole band as drained, it goes where the samples go
+    const char *spectrum_ip = static_dest ? dest_ip : (multicast_group[0] != '\0' ? multicast_group : NULL);
+    if (spectrum_port > 0) {
+        if (spectrum_ip == NULL) {
+            fprintf(stderr, "Nowhere to send the spectrum: -i none without -m\n");
+            return -1;
+        }
+        if (spectrum_init(&spec, fft_size, fft_averages, RADIO_SAMPLE_RATE) != 0
+            || spectrum_open(&spec, spectrum_ip, spectrum_port) != 0) {
+            return -1;
+        }
+    }
 
     // summarize the arguments
     printf("Summary:\n");
     printf("    Destination IP: %s\n", dest_ip);
     printf("    Destination Port: %d\n", dest_port);
+    if (multicast_group[0] != '\0') {
+        printf("    Multicast TTL: %d\n", multicast_ttl);
+    }
+    if (control_port > 0) {
+        printf("    Subscriber control port: %d, lease %u seconds\n", control_port, lease_seconds);
+    }
     if(timeout > 0) {
         printf("    Timeout: %d seconds\n", timeout);
     } else {
         printf("    Timeout: infinite\n");
     }
-    printf("    Packet size: %d bytes\n", PACKET_SIZE);
-    printf("    Number of samples per packet: %d\n", NUM_SAMPLES);
+    printf("    Packet size: %zu bytes (MTU %d)\n", packet_size, mtu);
+    printf("    Number of samples per packet: %u\n", num_samples);
+    if (fm_mode) {
+        printf("    Sample format: pcm16 (FM audio at %u samples/s, %u us de-emphasis, %s discriminator)\n",
+               audio_rate, deemphasis_us, fmDemod_backend());
+    } else {
+        printf("    Sample format: %s (%s conversion)\n", sampleFormat_name(sample_format), sampleFormat_backend());
+    }
+    if (iq_compress) {
+        printf("    Compression: lossless, %s residuals (packets vary in size, no GSO)\n", iqCodec_backend());
+    }
+    if (use_decimator) {
+        printf("    Decimation: by %u to %u samples/s, %u-tap FIR (%s)\n", decimation, RADIO_SAMPLE_RATE / decimation,
+               decimator.numTaps, taps_path != NULL ? taps_path : "designed");
+    }
+    if (scan_plan != NULL) {
+        printf("    Scan: %u steps, %.3f s per sweep, %u samples settle after a retune\n", scan.numSteps,
+               scan.sweepSeconds, scan.settleSamples);
+    }
+    if (spectrum_port > 0) {
+        printf("    Spectrum: %u-point FFT, %u averages, to %s:%d (%s butterflies)\n", fft_size, fft_averages,
+               spectrum_ip, spectrum_port, spectrum_backend());
+    }
+    printf("    Packet header: %s (%zu bytes)\n", header_mode == PACKET_HEADER_SDR ? "sdr" : "legacy", header_size);
+    printf("    Packet ring: %u slots, %s\n", ring_slots, packetRing_policyName(ring_policy));
+    if (control_path != NULL) {
+        printf("    Control socket: %s (DEST, TUNE, PAUSE, RESUME, SIZE, STATUS)\n", control_path);
+    }
+    if (metrics_name != NULL) {
+        printf("    Metrics: /dev/shm%s (streamerStats)\n", metrics_name);
+    }
+    printf("    FIFO drain: %s", axiFifo_drainModeName(drain_mode));
+    if (axi4_data_addr != 0) {
+        printf(" through the AXI4 data interface at 0x%08x", axi4_data_addr);
+    }
+    printf("\n");
+    printf("    FIFO pacing: wake at %u of %u words\n", fill_target, fifo_depth);
+    printf("    FIFO backend: %s\n", uio_device != NULL ? uio_device : "/dev/mem polling");
+    if (stream_udp) {
+        printf("    Send batch: up to %u packets, flush after %u us%s%s\n", batch_size, flush_us,
+               use_gso ? ", GSO" : "", use_zerocopy ? ", zero-copy" : "");
+    } else {
+        printf("    UDP streaming: off (no IQ packets)\n");
+    }
+    if (record_path != NULL) {
+        printf("    Recording: %s.sigmf-data, %u MB write-behind buffer\n", record_path, record_buffer_mb);
+    }
+
+    // the radio registers describe and time-stamp the samples in the packet header and the recording
+    if (header_mode == PACKET_HEADER_SDR || record_path != NULL || spectrum_port > 0) {
+        radio = radioTuner_open(); // without it the header carries no tuning and no timestamps
+    }
+    if (scan_plan != NULL && radio == NULL) {
+        return -1; // nothing to scan with
+    }
+    if (record_path != NULL) {
+        double adcHz = radio != NULL ? radioTuner_pincToHz(radioTuner_getAdcPinc(radio)) : 0;
+        double tuneHz = radio != NULL ? radioTuner_pincToHz(radioTuner_getTunerPinc(radio)) : 0;
+        if (sigmfRecorder_open(&recorder, record_path, (size_t)record_buffer_mb * 1024 * 1024,
+                               sample_rate, adcHz, tuneHz) != 0) {
+            return -1;
+        }
+    }
+
+    // preallocate the packet ring shared by the reader and the sender
+    // every slot also holds the raw FIFO words until they are converted in place
+    // with the sdr header SIZE may grow the packets up to the MTU, so the slots are sized for that
+    unsigned int slotSamples = (header_mode == PACKET_HEADER_SDR && control_path != NULL) ? max_samples : num_samples;
+    if(packetRing_init(&ring, ring_slots, header_size + sampleFormat_bufferBytes(sample_format, slotSamples) + codecOverhead, ring_policy) != 0) {
+        fprintf(stderr, "Failed to initialize packet ring\n");
+        return -1;
+    }
+    if (use_zerocopy) {
+        packetRing_lock(&ring); // not fatal, the kernel pins the pages of each send anyway
+    }
 
-    // initialize the semaphore and mutex
-    if(sem_init(&data_ready, 0, 0) != 0) {
-        perror("Failed to initialize semaphore");
+    // stop cleanly on Ctrl-C / kill so the summary gets printed
+    struct sigaction sigact;
+    memset(&sigact, 0, sizeof(sigact));
+    sigact.sa_handler = signalHandler;
+    sigaction(SIGINT, &sigact, NULL);
+    sigaction(SIGTERM, &sigact, NULL);
+
+    // let receivers come and go while streaming
+    if (stream_udp && control_port > 0 && subscriberTable_start(&subscribers, control_port) != 0) {
         return -1;
     }
-    if(pthread_mutex_init(&mutex, NULL) != 0) {
-        perror("Failed to initialize mutex");
-        sem_destroy(&data_ready);
+
+    // reconfigure while streaming, a busy socket only costs the commands
+    if (control_path != NULL) {
+        control_started = (streamControl_start(&control, control_path) == 0);
+        if (!control_started) {
+            fprintf(stderr, "Continuing without the control socket\n");
+        }
+    }
+
+    // counters for streamerStats, private memory if the segment cannot be created
+    metrics = streamMetrics_open(metrics_name, argv[0], fifo_depth);
+    if (metrics == NULL) {
         return -1;
     }
 
@@ -94,77 +506,209 @@ int main(int argc, char const *argv[])
         return -1;
     }
     // create the UDP sender thread
-    if(pthread_create(&udpSenderThread, NULL, udpSenderTask, NULL) != 0) {
+    if(stream_udp && pthread_create(&udpSenderThread, NULL, udpSenderTask, NULL) != 0) {
         perror("Failed to create UDP sender thread");
         pthread_cancel(fifoReaderThread); // cancel the FIFO reader thread
         return -1;
     }
+    if (!stream_udp) {
+        // no sender to watch the timeout, stop here once no samples came in for timeout seconds
+        // (words drained moves with -r and -S alike, the recorder head only with -r)
+        unsigned long long lastDrained = 0;
+        int idleTicks = 0;
+        while (!terminate) {
+            usleep(100000);
+            unsigned long long drained = atomic_load_explicit(&metrics->reader.wordsDrained, memory_order_relaxed);
+            idleTicks = (drained == lastDrained) ? idleTicks + 1 : 0;
+            lastDrained = drained;
+            if (timeout > 0 && idleTicks >= timeout * 10) {
+                printf("[Main]: Timeout occurred, no samples for %d seconds\n", timeout);
+                terminate = 1;
+            }
+        }
+    }
 
     // wait for the threads to finish
     pthread_join(fifoReaderThread, NULL);
-    pthread_join(udpSenderThread, NULL);
+    if (stream_udp) {
+        pthread_join(udpSenderThread, NULL);
+    }
+    subscriberTable_stop(&subscribers);
+    if (control_started) {
+        streamControl_stop(&control);
+    }
+    streamMetrics_close(metrics); // the exporter reports the streamer as down from now on
+    if (record_path != NULL) {
+        sigmfRecorder_close(&recorder); // flush what is still buffered
+    }
 
-    sem_destroy(&data_ready); // destroy the semaphore
-    pthread_mutex_destroy(&mutex); // destroy the mutex
+    // report what happened inside the ring
+    printf("Packet ring summary:\n");
+    printf("    Published: %llu\n", (unsigned long long)packetRing_count(&ring.stats.producer.published));
+    printf("    Consumed: %llu\n", (unsigned long long)packetRing_count(&ring.stats.consumer.consumed));
+    printf("    Dropped oldest: %llu\n", (unsigned long long)packetRing_count(&ring.stats.producer.droppedOldest));
+    printf("    Dropped newest: %llu\n", (unsigned long long)packetRing_count(&ring.stats.producer.droppedNewest));
+    printf("    Reader blocked: %llu\n", (unsigned long long)packetRing_count(&ring.stats.producer.blocked));
 
-    // unmap the AXI FIFO base address
-    if(axi_fifo_base != NULL) {
-        munmap((void *)axi_fifo_base, 4096); // unmap the AXI FIFO base address
+    axiFifo_printStats(&fifo, stream_seconds);
+    fifoPacer_printStats(&pacer);
+    fifoLoss_printStats(&loss, stream_seconds);
+    printf("    Reader CPU: %.3f s (%.1f%% of one core)\n", reader_cpu_seconds,
+           stream_seconds > 0 ? 100.0 * reader_cpu_seconds / stream_seconds : 0.0);
+    if (stream_udp) {
+        udpTx_printStats(&tx, sender_seconds);
+        printf("    Sender CPU: %.3f s (%.1f%% of one core)\n", sender_cpu_seconds,
+               sender_seconds > 0 ? 100.0 * sender_cpu_seconds / sender_seconds : 0.0);
+        subscriberTable_printStats(&subscribers);
     }
+    if (record_path != NULL) {
+        sigmfRecorder_printStats(&recorder, stream_seconds);
+    }
+    if (use_decimator) {
+        firDecimator_printStats(&decimator);
+        firDecimator_close(&decimator);
+    }
+    if (fm_mode) {
+        fmDemod_printStats(&demod);
+    }
+    if (spectrum_port > 0) {
+        spectrum_printStats(&spec, stream_seconds);
+        spectrum_close(&spec);
+    }
+    if (control_started) {
+        streamControl_printStats(&control);
+        printf("    Dropped: %llu samples while paused, %llu settling after TUNE\n",
+               (unsigned long long)paused_samples, (unsigned long long)tune_discarded);
+    }
+    if (scan_plan != NULL) {
+        scanScheduler_printStats(&scan, fifo.wordsDrained);
+        scanScheduler_close(&scan);
+    }
+    if (iq_compress) {
+        printf("Compression summary:\n");
+        printf("    Samples: %llu bytes raw, %llu bytes sent (ratio %.2f)\n", (unsigned long long)codec_raw_bytes,
+               (unsigned long long)codec_bytes, codec_bytes > 0 ? (double)codec_raw_bytes / codec_bytes : 0.0);
+    }
+
+    packetRing_destroy(&ring); // release the packet buffers
+
+    // unmap the AXI FIFO
+    axiFifo_close(&fifo);
+    radioTuner_close(radio);
 
     return 0;
 }
 
 void* fifoReaderTask(void *arg)
 {
-    // get a pointer to the AXI FIFO base address
-    axi_fifo_base = get_pointer_to_axi_fifo();
-    if (axi_fifo_base == NULL) 
+    // map the AXI FIFO (and its AXI4 data window when the bitstream has one)
+    if (axiFifo_open(&fifo, drain_mode, axi4_data_addr, uio_device) != 0) 
     {
         fprintf(stderr, "Failed to get AXI FIFO base address\n");
+        terminate = 1; // nothing to stream, stop the sender as well
+        packetRing_close(&ring);
         pthread_exit(NULL);
     }
     // reset the FIFO
-    fifo_reset(axi_fifo_base); // reset the FIFO
+    fifo_reset(fifo.regs); // reset the FIFO
+    fifoPacer_init(&pacer, fifo_depth, fill_target);
+    fifoLoss_init(&loss, fifo_depth, RADIO_SAMPLE_RATE); // the FIFO fills at the radio rate, before any decimation
     printf("[Reader]: FIFO Reader Thread started\n");
     unsigned int numSamplesRead = 0; // number of samples read for current packet
-    unsigned int targetSamples = NUM_SAMPLES; // target number of samples to read for each packet
+    unsigned int targetSamples = num_samples; // target number of samples to read for each packet
+    uint8_t *packet = packetRing_acquire(&ring); // packet currently being filled, owned by this thread
+    uint32_t *payload = (uint32_t *)(packet + header_size + raw_offset); // its raw FIFO words
+    uint32_t captureTicks = 0; // radio timer when the first sample of the packet was drained
+    unsigned int retuneDiscard = 0; // FIFO words still to drop after a retune
+    static uint32_t dspInput[FIR_BLOCK]; // drained samples on their way through the decimator/demodulator
+    static uint32_t dspDecimated[FIR_BLOCK]; // decimator output on its way to the demodulator
+    static uint8_t codecOut[IQ_CODEC_MAX_BYTES(IQ_CODEC_MAX_SAMPLES)]; // compressed packet on its way to the ring slot
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
 
     while (!terminate) {
 
+        // retune between packets, so every packet is captured at one frequency
+        if (scan_plan != NULL && numSamplesRead == 0 && scanScheduler_poll(&scan, radio)) {
+            // what the FIFO holds was captured at the old frequency, then the mixer settles
+            retuneDiscard = fifo_get_current_occupancy(fifo.regs) + settle_samples;
+        }
+
         // process reading data from the FIFO to fill the packet
         while(numSamplesRead < targetSamples) {
-            // get the current occupancy of the FIFO
-            unsigned int occupancy = fifo_get_current_occupancy(axi_fifo_base);
-            if (occupancy > 0) {
-                // lock the mutex before accessing shared data
-                pthread_mutex_lock(&mutex);
-                // read data from the FIFO
-                for (unsigned int i = 0; i < occupancy; i++) {
-                    packet.sdrData[numSamplesRead] = fifo_get_data(axi_fifo_base); // read data from the FIFO
-
-                    // // swap bytes inside each int16
-                    // uint32_t dataTmp = fifo_get_data(axi_fifo_base);
-                    // int16_t hi = (dataTmp >> 16) & 0xFFFF;     // high int16
-                    // int16_t lo = dataTmp & 0xFFFF;             // low int16
-                    // // Swap bytes inside each int16
-                    // hi = ((hi & 0x00FF) << 8) | ((hi & 0xFF00) >> 8);
-                    // lo = ((lo & 0x00FF) << 8) | ((lo & 0xFF00) >> 8);
-                
-                    // // Repack them together
-                    // packet.sdrData[numSamplesRead] = (hi << 16) | lo;
-
-                    ++numSamplesRead; // increment the number of samples read
-                    if (numSamplesRead >= targetSamples) {
-                        break; // exit the loop if we have read enough samples
-                    }
+            unsigned int numRead = 0;
+            if (numSamplesRead == 0 && streamControl_posted(&control)) {
+                // reconfigure between two packets, the FIFO keeps its contents
+                streamCommand *cmd = streamControl_take(&control);
+                if (cmd != NULL) {
+                    retuneDiscard += applyControl(cmd);
+                    streamControl_finish(&control);
+                    targetSamples = num_samples;
+                    payload = (uint32_t *)(packet + header_size + raw_offset);
                 }
-
-                pthread_mutex_unlock(&mutex); // unlock the mutex after reading data
-                
-                
             }
-            usleep(1000); // sleep for 2ms to avoid busy waiting
+            if (retuneDiscard > 0 || stream_paused) {
+                // drop the samples across a retune, and everything while paused; the FIFO drains either way
+                numRead = axiFifo_drain(&fifo, dspInput, (retuneDiscard > 0 && retuneDiscard < FIR_BLOCK) ? retuneDiscard : FIR_BLOCK);
+                unsigned int settled = numRead < retuneDiscard ? numRead : retuneDiscard;
+                retuneDiscard -= settled;
+                if (scan_plan != NULL) {
+                    scan.discarded += settled;
+                } else {
+                    tune_discarded += settled;
+                }
+                paused_samples += numRead - settled;
+            } else if (use_decimator || fm_mode) {
+                // drain no more than the rest of the packet needs, filter/demodulate into the ring slot
+                unsigned int wanted = targetSamples - numSamplesRead;
+                if (fm_mode) {
+                    wanted = fmDemod_inputsFor(&demod, wanted);
+                }
+                if (use_decimator) {
+                    wanted = firDecimator_inputsFor(&decimator, wanted);
+                }
+                numRead = axiFifo_drain(&fifo, dspInput, wanted < FIR_BLOCK ? wanted : FIR_BLOCK);
+                if (numSamplesRead == 0 && numRead > 0 && radio != NULL) {
+                    captureTicks = radioTuner_getTimer(radio); // latch the capture time of the packet
+                }
+                if (spectrum_port > 0) {
+                    spectrum_process(&spec, dspInput, numRead, radio);
+                }
+                uint32_t *iq = dspInput;
+                unsigned int numIq = numRead;
+                if (use_decimator) {
+                    iq = fm_mode ? dspDecimated : &payload[numSamplesRead];
+                    numIq = firDecimator_process(&decimator, dspInput, numRead, iq);
+                }
+                if (fm_mode) {
+                    numIq = fmDemod_process(&demod, iq, numIq, (int16_t *)(packet + header_size) + numSamplesRead);
+                }
+                numSamplesRead += numIq;
+            } else {
+                // read whatever the FIFO holds straight into the ring slot, no lock needed
+                numRead = axiFifo_drain(&fifo, &payload[numSamplesRead], targetSamples - numSamplesRead);
+                if (numSamplesRead == 0 && numRead > 0 && radio != NULL) {
+                    captureTicks = radioTuner_getTimer(radio); // latch the capture time of the packet
+                }
+                if (spectrum_port > 0) {
+                    spectrum_process(&spec, &payload[numSamplesRead], numRead, radio);
+                }
+                numSamplesRead += numRead;
+            }
+            fifoPacer_update(&pacer, fifo.lastOccupancy, numRead);
+            fifoLoss_update(&loss, &fifo, numRead, &pacer.lastPoll);
+            streamMetrics_polled(metrics, &fifo, &loss);
+            if (numSamplesRead >= targetSamples) {
+                break; // packet is full, send it right away
+            }
+            if (fifo.uioFd >= 0) {
+                // sleep on the FIFO interrupt instead of polling, at most until fill_target words are due
+                if (axiFifo_waitForData(&fifo, fill_target, RADIO_SAMPLE_RATE, AXI_FIFO_IRQ_TIMEOUT_MS) < 0) {
+                    terminate = 1;
+                }
+            } else {
+                fifoPacer_wait(&pacer); // sleep until the FIFO should hold fill_target words
+            }
             
             // check if termination signal is received
             if (terminate) {
@@ -174,158 +718,377 @@ void* fifoReaderTask(void *arg)
 
         // check if we have read enough samples for the current packet
         if (numSamplesRead >= targetSamples) {
-            // signal that data is ready to be sent
-            packet.packetID = packetID++;
-            sem_post(&data_ready); // signal that data is ready
+            bool discontinuity = fifoLoss_packetDone(&loss, fifo.wordsDrained); // taken even if nobody sends
+            if (record_path != NULL) {
+                sigmfRecorder_write(&recorder, payload, targetSamples); // copied out, never blocks
+            }
+            if (!stream_udp) {
+                numSamplesRead = 0; // nobody sends, refill the same slot
+                continue;
+            }
+            // convert the whole packet in one go, then hand it to the sender and move on to the next free slot
+            if (iq_compress) {
+                // the raw words are cs16_qi already, replace them with their compressed form
+                size_t codedBytes = iqCodec_encode(payload, targetSamples, codecOut);
+                memcpy(packet + header_size, codecOut, codedBytes);
+                codec_raw_bytes += (uint64_t)targetSamples * sizeof(uint32_t);
+                codec_bytes += codedBytes;
+            } else if (!fm_mode) {
+                sampleFormat_convert(sample_format, packet + header_size, payload, targetSamples);
+            }
+            if (header_mode == PACKET_HEADER_SDR) {
+                sdrPacket_fillHeader((sdrPacketHeader *)packet, packetID++, targetSamples, sample_format, sample_rate, radio, captureTicks);
+                if (iq_compress) {
+                    ((sdrPacketHeader *)packet)->flags |= SDR_FLAG_COMPRESSED;
+                }
+                if (discontinuity) {
+                    ((sdrPacketHeader *)packet)->flags |= SDR_FLAG_DISCONTINUITY;
+                }
+                if (scan_plan != NULL) {
+                    // the step the samples were captured at, not whatever the register says by now
+                    ((sdrPacketHeader *)packet)->flags |= SDR_FLAG_SCAN;
+                    ((sdrPacketHeader *)packet)->tunerPinc = scan.steps[scan.current].pinc;
+                    ((sdrPacketHeader *)packet)->scanStep = scan.current;
+                }
+            } else {
+                ((dataPacket *)packet)->packetID = packetID++;
+            }
+            if (packetRing_publish(&ring) != 0) {
+                break; // ring closed while waiting for a free slot
+            }
+            streamMetrics_set(&metrics->reader.packetsBuilt, packetRing_count(&ring.stats.producer.published));
+            streamMetrics_set(&metrics->reader.packetsDropped, packetRing_count(&ring.stats.producer.droppedOldest)
+                                                               + packetRing_count(&ring.stats.producer.droppedNewest));
+            packet = packetRing_acquire(&ring);
+            payload = (uint32_t *)(packet + header_size + raw_offset);
             numSamplesRead = 0; // reset the number of samples read for the next packet
         }
 
     }
 
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    stream_seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    struct rusage usage;
+    if (getrusage(RUSAGE_THREAD, &usage) == 0) {
+        reader_cpu_seconds = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6
+                           + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+    }
+
+    packetRing_close(&ring); // let the sender drain what is left and exit
     printf("[Reader]: FIFO Reader Thread terminated\n");
+    return NULL;
 }
 
 void* udpSenderTask(void* arg)
 {
-    // create a UDP socket
-    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
-    if (sockfd < 0) {
-        perror("Error creating socket");
+    // create the UDP socket and the sendmmsg() batch, the destinations come from the subscriber table
+    if (udpTx_open(&tx, NULL, 0, batch_size) != 0) {
+        terminate = 1; // nowhere to send, stop the reader as well
+        packetRing_close(&ring);
         pthread_exit(NULL);
     }
-
-    // create a sockaddr_in structure to hold the server address
-    struct sockaddr_in server_addr;
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(dest_port);
-    if (inet_pton(AF_INET, dest_ip, &server_addr.sin_addr) <= 0) {
-        perror("Invalid IP address or IP Address not supported");
-        close(sockfd);
-        pthread_exit(NULL);
+    udpTx_setMulticastTtl(&tx, multicast_ttl);
+    if (use_gso) {
+        udpTx_enableGso(&tx, packet_size); // falls back to sendmmsg() if the kernel cannot do it
+    }
+    if (use_zerocopy) {
+        // keep enough buffers out of flight for the reader and the batch being collected
+        udpTx_enableZerocopy(&tx, ring_slots - batch_size - 2, releasePacket, &ring);
     }
 
     struct timespec ts;
+    struct timespec start, end;
+    dataPacket *batch[UDP_TX_MAX_BATCH]; // packets of the current batch, owned until released
+    size_t sizes[UDP_TX_MAX_BATCH]; // their lengths (compressed, or after a SIZE)
+    unsigned int sampleBytes = sdrPacket_sampleBytes(sample_format);
+    struct sockaddr_in dests[SUBSCRIBER_MAX]; // destinations of the batch
+    udpTxCounters *destCounters[SUBSCRIBER_MAX]; // their counters in the subscriber table
+    unsigned int destVersion = 0; // subscriber table version the destinations belong to
+    unsigned int numDests = subscriberTable_snapshot(&subscribers, dests, destCounters, &destVersion);
+    udpTx_setDestinations(&tx, dests, destCounters, numDests);
 
     printf("[Sender]: UDP Sender Thread started\n");
+    clock_gettime(CLOCK_MONOTONIC, &start);
 
     // send packets to the server
-    while (!terminate) {
+    while (true) {
         
+        unsigned int numPackets = 0;
+        dataPacket *packet = NULL;
         // check if the timeout has occurred
         if(timeout > 0)
         {
             clock_gettime(CLOCK_REALTIME, &ts); // get the current time
             ts.tv_sec += timeout; // set the timeout
-            if(sem_timedwait(&data_ready, &ts) == -1)
-            {
-                if(errno == ETIMEDOUT) {
-                    printf("[Sender]: Timeout occurred, terminating thread\n");
-                    terminate = 1; // set the termination flag
-                    break; // exit the loop
-                } else {
-                    perror("Error waiting for semaphore");
-                    terminate = 1; // set the termination flag
-                    break; // exit the loop
+        }
+        while (true) {
+            struct timespec *deadline = (timeout > 0) ? &ts : NULL;
+            struct timespec reapTs;
+            if (tx.inFlightCount > 0) {
+                // zero-copy buffers are still in flight, wake up now and then to hand them back
+                clock_gettime(CLOCK_REALTIME, &reapTs);
+                reapTs.tv_nsec += UDP_TX_ZC_WAIT_MS * 1000000L;
+                reapTs.tv_sec += reapTs.tv_nsec / 1000000000;
+                reapTs.tv_nsec %= 1000000000;
+                if (deadline == NULL || reapTs.tv_sec < ts.tv_sec || (reapTs.tv_sec == ts.tv_sec && reapTs.tv_nsec < ts.tv_nsec)) {
+                    deadline = &reapTs;
                 }
             }
+            packet = packetRing_wait(&ring, deadline); // wait for data to be ready
+            if (packet == NULL && errno == ETIMEDOUT && deadline == &reapTs) {
+                udpTx_reap(&tx, 0);
+                continue;
+            }
+            break;
         }
-        else
-        {
-            sem_wait(&data_ready); // wait for data to be ready
+
+        if (packet == NULL) {
+            if (errno == ETIMEDOUT) {
+                printf("[Sender]: Timeout occurred, terminating thread\n");
+            } else if (errno != ECANCELED) {
+                perror("Error waiting for packet");
+            }
+            terminate = 1; // set the termination flag
+            break; // exit the loop
         }
+        batch[numPackets++] = packet;
 
-        // lock the mutex before accessing shared data
-        pthread_mutex_lock(&mutex);
+        // add whatever else is ready, waiting at most flush_us for the batch to fill up
+        if (numPackets < batch_size) {
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_nsec += (long)flush_us * 1000;
+            ts.tv_sec += ts.tv_nsec / 1000000000;
+            ts.tv_nsec %= 1000000000;
+            while (numPackets < batch_size) {
+                packet = packetRing_pop(&ring);
+                if (packet == NULL && flush_us > 0) {
+                    packet = packetRing_wait(&ring, &ts);
+                }
+                if (packet == NULL) {
+                    break; // deadline reached, send what we have
+                }
+                batch[numPackets++] = packet;
+            }
+        }
 
-        ssize_t bytes_sent = sendto(sockfd, &packet, PACKET_SIZE, 0, (struct sockaddr *)&server_addr, sizeof(server_addr));
-        if (bytes_sent < 0) {
+        if (header_mode == PACKET_HEADER_SDR) {
+            sdrPacket_stampSend((void * const *)batch, numPackets, radio);
+        }
+        if (atomic_load_explicit(&subscribers.version, memory_order_relaxed) != destVersion) {
+            // somebody subscribed, unsubscribed or expired, send to the new set from this batch on
+            numDests = subscriberTable_snapshot(&subscribers, dests, destCounters, &destVersion);
+            udpTx_setDestinations(&tx, dests, destCounters, numDests);
+        }
+        bool zerocopy = tx.zerocopy; // zero-copy sends hand the buffers back through releasePacket()
+        unsigned int queued = numPackets + packetRing_depth(&ring); // this batch and what waits behind it
+        int rc;
+        if (iq_compress) {
+            // every compressed packet has its own length, written in front of its payload
+            for (unsigned int i = 0; i < numPackets; i++) {
+                sizes[i] = header_size + iqCodec_encodedBytes((uint8_t *)batch[i] + header_size);
+            }
+            rc = udpTx_sendSizes(&tx, (void * const *)batch, sizes, numPackets);
+        } else if (header_mode == PACKET_HEADER_SDR) {
+            // SIZE may change the packets at run time, each one says how many samples it holds
+            bool sameSize = true;
+            for (unsigned int i = 0; i < numPackets; i++) {
+                sizes[i] = PACKET_SIZE(header_size, ((sdrPacketHeader *)batch[i])->sampleCount, sampleBytes);
+                sameSize = sameSize && sizes[i] == sizes[0];
+            }
+            // equal sizes go out with GSO at the new size, mixed ones with sendmmsg()
+            rc = sameSize ? udpTx_send(&tx, (void * const *)batch, numPackets, sizes[0])
+                          : udpTx_sendSizes(&tx, (void * const *)batch, sizes, numPackets);
+        } else {
+            rc = udpTx_send(&tx, (void * const *)batch, numPackets, packet_size);
+        }
+        for (unsigned int i = 0; !zerocopy && i < numPackets; i++) {
+            packetRing_release(&ring, batch[i]); // the slots can be refilled now
+        }
+        streamMetrics_sent(metrics, &tx, queued);
+        if (rc < 0 && control_port == 0) {
+            // with a control port a receiver that went away only costs its own error counter
             perror("Error sending packet");
-            pthread_mutex_unlock(&mutex); // unlock the mutex before exiting
-            close(sockfd);
-            pthread_exit(NULL);
+            terminate = 1; // stop the reader as well
+            packetRing_close(&ring);
+            break;
         }
 
-        if(packetID % 1000 == 0 && packetID != 0) {
-            printf("Sent %d packets to %s : %d\n", packetID, dest_ip, dest_port);
-
-            // int16_t data_I = (packet.sdrData[0] >> 16) & (0xFFFF);  // get the first sample
-            // int16_t data_Q = packet.sdrData[0] & (0xFFFF);          // get the second sample
-            // printf("First sample: %d %d\n", data_I, data_Q);        // print the first sample for debugging
-
+        if ((packetsSent + numPackets) / 1000 != packetsSent / 1000) {
+            printf("Sent %u packets to %u destinations\n", packetsSent + numPackets, numDests);
         }
-        pthread_mutex_unlock(&mutex); // unlock the mutex after sending the packet
+        packetsSent += numPackets;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    sender_seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    struct rusage usage;
+    if (getrusage(RUSAGE_THREAD, &usage) == 0) {
+        sender_cpu_seconds = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6
+                           + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
     }
 
     // report the number of packets sent
-    printf("Total:sent %d packets to %s : %d\n", packetID, dest_ip, dest_port);
+    printf("Total:sent %u packets to %u destinations\n", packetsSent, numDests);
 
-    close(sockfd); // close the socket
+    udpTx_close(&tx); // close the socket
     pthread_exit(NULL);
 }
 
-
-// the below code uses a device called /dev/mem to get a pointer to a physical
-// address.  We will use this pointer to read/write the custom peripheral
-volatile unsigned int * get_a_pointer(unsigned int phys_addr)
-{
-
-	int mem_fd = open("/dev/mem", O_RDWR | O_SYNC); 
-    if (mem_fd < 0) {
-        perror("Failed to open /dev/mem");
-        return NULL;
-    }
-	void *map_base = mmap(0, 4096, PROT_READ | PROT_WRITE, MAP_SHARED, mem_fd, phys_addr); 
-    if (map_base == MAP_FAILED) {
-        perror("mmap failed");
-        close(mem_fd);
-        return NULL;
-    }
-	volatile unsigned int *peripheral_base = (volatile unsigned int *)map_base; 
-    close(mem_fd); // close the file descriptor after mapping
-	return (peripheral_base);
-}
-
 /**
- * @brief Get a pointer to the AXI FIFO base address in user space
+ * @brief Ask both threads to stop
  * 
- * @return volatile unsigned int* Pointer to the AXI FIFO base address
+ * @param sig signal number
  */
-volatile unsigned int * get_pointer_to_axi_fifo()
+void signalHandler(int sig)
 {
-    volatile unsigned int *axi_fifo_base = get_a_pointer(AXI4_STREAM_FIFO_BASE_ADDR);
-    if (axi_fifo_base == NULL) {
-        fprintf(stderr, "Failed to map AXI FIFO base address\n");
-        return NULL;
-    }
-    return axi_fifo_base;
+    (void)sig;
+    terminate = 1;
 }
 
-void fifo_reset(volatile unsigned int *axi_fifo_base)
+
+/**
+ * @brief Refuse a control command with a reason
+ */
+static unsigned int refuseControl(streamCommand *cmd, const char *reason)
 {
-    // reset the FIFO by writing the reset key to the reset register
-    axi_fifo_base[AXI4_STREAM_FIFO_RDFR_OFFSET/4] = AXI4_STREAM_FIFO_RDFR_RESET_KEY;
+    cmd->result = -1;
+    snprintf(cmd->fields, sizeof(cmd->fields), "%s", reason);
+    return 0;
 }
 
-unsigned int fifo_get_current_occupancy(volatile unsigned int *axi_fifo_base)
+/**
+ * @brief Apply a control command between two packets (reader thread)
+ * @details Called with no packet half filled, so a new size or destination
+ *          starts with a whole packet. The FIFO is not touched, except that a
+ *          retune drops its backlog and the settling samples.
+ *
+ * @param cmd command taken from the mailbox, its result and fields are filled in
+ * @return unsigned int FIFO words to drop before the next packet starts
+ */
+unsigned int applyControl(streamCommand *cmd)
 {
-    // get the current occupancy of the FIFO by reading the occupancy register
-    unsigned int occupancy = axi_fifo_base[AXI4_STREAM_FIFO_RDFO_OFFSET/4];
-    //printf("FIFO occupancy: %u\n", occupancy); // print the occupancy for debugging
-    return occupancy;
+    cmd->result = 0;
+    switch (cmd->type) {
+        case STREAM_CMD_DEST:
+            if (!stream_udp) {
+                return refuseControl(cmd, "not streaming over UDP (-U)");
+            }
+            if (subscriberTable_replacePermanent(&subscribers, static_dest ? &static_addr : NULL, &cmd->dest) != 0) {
+                return refuseControl(cmd, "subscriber table full");
+            }
+            static_addr = cmd->dest;
+            static_dest = true; // the sender picks it up at its next batch
+            return 0;
+        case STREAM_CMD_TUNE:
+            if (radio == NULL) {
+                return refuseControl(cmd, "radio registers not mapped (-H legacy)");
+            }
+            if (scan_plan != NULL) {
+                return refuseControl(cmd, "the -Q scan owns the mixer");
+            }
+            if (record_path != NULL) {
+                return refuseControl(cmd, "recording one frequency (-r)"); // its metadata has one capture
+            }
+            if (cmd->hz < -RADIO_TIMER_HZ / 2.0 || cmd->hz > RADIO_TIMER_HZ / 2.0) {
+                return refuseControl(cmd, "frequency out of range");
+            }
+            radioTuner_setTunerHz(radio, cmd->hz);
+            // what the FIFO holds was captured at the old frequency, then the mixer settles
+            return fifo_get_current_occupancy(fifo.regs) + settle_samples;
+        case STREAM_CMD_PAUSE:
+            if (record_path != NULL) {
+                return refuseControl(cmd, "recording (-r), a pause would leave a silent gap in the file");
+            }
+            stream_paused = true;
+            return 0;
+        case STREAM_CMD_RESUME:
+            stream_paused = false;
+            return 0;
+        case STREAM_CMD_SIZE:
+            if (header_mode != PACKET_HEADER_SDR) {
+                return refuseControl(cmd, "SIZE needs the sdr header, legacy receivers expect a fixed size");
+            }
+            if (cmd->samples < MIN_NUM_SAMPLES || cmd->samples > max_samples) {
+                snprintf(cmd->fields, sizeof(cmd->fields), "%d to %u samples for this MTU", MIN_NUM_SAMPLES, max_samples);
+                cmd->result = -1;
+                return 0;
+            }
+            num_samples = cmd->samples;
+            raw_offset = sampleFormat_rawOffset(sample_format, num_samples);
+            if (fill_target_auto) {
+                fifoPacer_setTarget(&pacer, num_samples); // still wake up once per packet
+                fill_target = pacer.target; // as clamped, the UIO wait times its sleep for it
+            }
+            if (scan_plan != NULL) {
+                scan.halfPacketTicks = (uint32_t)((double)num_samples * RADIO_TIMER_HZ / sample_rate / 2);
+            }
+            return 0;
+        case STREAM_CMD_STATUS: {
+            char ip[INET_ADDRSTRLEN] = "none";
+            if (static_dest) {
+                inet_ntop(AF_INET, &static_addr.sin_addr, ip, sizeof(ip));
+            }
+            snprintf(cmd->fields, sizeof(cmd->fields), " dest=%s:%u samples=%u paused=%u tune=%.1f packets=%u dropped=%llu",
+                     ip, static_dest ? ntohs(static_addr.sin_port) : 0u, num_samples, stream_paused ? 1u : 0u,
+                     radio != NULL ? radioTuner_pincToHz(radioTuner_getTunerPinc(radio)) : 0.0, packetID,
+                     (unsigned long long)(paused_samples + tune_discarded));
+            return 0;
+        }
+        default:
+            return refuseControl(cmd, "unknown command");
+    }
 }
 
-unsigned int fifo_get_data(volatile unsigned int *axi_fifo_base)
+/**
+ * @brief Return a packet buffer to the ring once the kernel has sent it
+ *
+ * @param buffer packet buffer
+ * @param arg packet ring
+ */
+void releasePacket(void *buffer, void *arg)
 {
-    // get the data from the FIFO by reading the data register
-    return axi_fifo_base[AXI4_STREAM_FIFO_RDFD_OFFSET/4];
+    packetRing_release((packetRing *)arg, buffer);
 }
 
 void usage(const char *executableName)
 {
-    fprintf(stderr, "Usage: %s -i <IP address> -p <port> -t <timeout_second>\n\n", executableName);
-    fprintf(stderr, "  -i <IP address>      : Destination IP address (default: %s)\n\n", DEFAULT_DEST_IP);
+    fprintf(stderr, "Usage: %s -i <IP address> -p <port> -t <timeout_second> -s <samples> -H <header> -F <format> -N <factor> -T <taps file> -M <mode> -S <port[:fft[:averages]]> -C -Q <plan> -q <samples> -K <socket> -P <name> -n <slots> -o <policy> -D <mode> -A <address> -d <words> -L <words> -u <device> -b <packets> -f <microseconds> -G -Z -r <path> -w <MB> -U -c <port> -l <seconds> -m <group:port[:ttl]>\n\n", executableName);
+    fprintf(stderr, "  -i <IP address>      : Destination IP address, none for subscribers only (default: %s)\n\n", DEFAULT_DEST_IP);
     fprintf(stderr, "  -p <port>            : Destination UDP port (default: %d)\n\n", DEFAULT_UDP_DEST_PORT);
     fprintf(stderr, "  -t <timeout_second>  : Timeout in seconds (default: infinite)\n\n");
+    fprintf(stderr, "  -s <samples>         : Samples per packet, up to the route MTU (default: %d)\n\n", DEFAULT_NUM_SAMPLES);
+    fprintf(stderr, "  -H <header>          : Packet header: sdr (self-describing, time-stamped) or legacy (packet ID only)\n");
+    fprintf(stderr, "                         (default: sdr)\n\n");
+    fprintf(stderr, "  -F <format>          : Sample format: cs16_iq, cs16_qi, cs16_iq_be, cs16_qi_be, cs8 or cf32 (default: cs16_iq)\n\n");
+    fprintf(stderr, "  -N <factor>          : Low-pass filter and decimate the samples by <factor> on the board (default: 1, off)\n\n");
+    fprintf(stderr, "  -T <taps file>       : FIR taps for -N, floating point, 1.0 = unity (default: designed for the factor)\n\n");
+    fprintf(stderr, "  -M <mode>            : iq, or fm[:<audio rate>[:<de-emphasis us>]] to send FM-demodulated 16-bit PCM\n");
+    fprintf(stderr, "                         (default: iq; fm: %d samples/s, %d us)\n\n", FM_DEFAULT_AUDIO_RATE, FM_DEFAULT_DEEMPHASIS_US);
+    fprintf(stderr, "  -S <port[:fft[:averages]]>: Also send averaged dB spectrum frames to this port of the destination\n");
+    fprintf(stderr, "                         (default: off; %d-point FFT, %d averages)\n\n", SPECTRUM_DEFAULT_FFT, SPECTRUM_DEFAULT_AVERAGES);
+    fprintf(stderr, "  -C                   : Compress the IQ samples losslessly (cs16_qi inside, sdr header flag 0x2; no other -F)\n\n");
+    fprintf(stderr, "  -Q <plan>            : Scan the mixer: <start>:<stop>:<step>[@<ms>], <hz>[@<ms>],... or a file of\n");
+    fprintf(stderr, "                         \"<hz> [<ms>]\" lines; packets are tagged with their step (default dwell: %d ms)\n\n", SCAN_DEFAULT_DWELL_MS);
+    fprintf(stderr, "  -q <samples>         : Samples discarded after every retune, on top of the FIFO backlog (default: %d)\n\n", SCAN_DEFAULT_SETTLE);
+    fprintf(stderr, "  -K <socket>          : Control socket for DEST, TUNE, PAUSE, RESUME, SIZE, STATUS; none to disable\n");
+    fprintf(stderr, "                         (default: %s)\n\n", STREAM_CONTROL_SOCKET);
+    fprintf(stderr, "  -P <name>            : Shared-memory segment of the metrics read by streamerStats; none to disable\n");
+    fprintf(stderr, "                         (default: %s)\n\n", STREAM_METRICS_NAME);
+    fprintf(stderr, "  -n <slots>           : Number of packets in the reader/sender ring (default: %d)\n\n", RING_DEFAULT_SLOTS);
+    fprintf(stderr, "  -o <policy>          : Ring overrun policy: oldest, newest or block (default: oldest)\n\n");
+    fprintf(stderr, "  -D <mode>            : FIFO drain mode: word, burst or rlr (default: burst)\n\n");
+    fprintf(stderr, "  -A <address>         : Physical address of the FIFO AXI4 data interface, if the bitstream has one\n\n");
+    fprintf(stderr, "  -d <words>           : Receive FIFO depth in words (default: %d)\n\n", FIFO_DEFAULT_DEPTH);
+    fprintf(stderr, "  -L <words>           : FIFO fill level to wake up at, below 3/4 of -d (default: samples per packet)\n\n");
+    fprintf(stderr, "  -u <device>          : UIO device bound to the FIFO, wait on its interrupt instead of polling\n\n");
+    fprintf(stderr, "  -b <packets>         : Most packets sent per sendmmsg() call (default: %d)\n\n", UDP_TX_DEFAULT_BATCH);
+    fprintf(stderr, "  -f <microseconds>    : Longest wait for a batch to fill up (default: %d, send what is ready)\n\n", UDP_TX_DEFAULT_FLUSH_US);
+    fprintf(stderr, "  -G                   : Send each batch as one UDP GSO super-packet (same datagrams on the wire)\n\n");
+    fprintf(stderr, "  -Z                   : Send straight from the packet ring with MSG_ZEROCOPY (Linux 5.0+)\n\n");
+    fprintf(stderr, "  -r <path>            : Also record the samples to <path>.sigmf-data/.sigmf-meta\n\n");
+    fprintf(stderr, "  -w <MB>              : Write-behind buffer of the recording (default: %d)\n\n", SIGMF_DEFAULT_BUFFER_MB);
+    fprintf(stderr, "  -U                   : Do not stream IQ over UDP, only record (-r) and/or send spectra (-S)\n\n");
+    fprintf(stderr, "  -c <port>            : Control port for SUB/UNSUB [group:]port requests, 0 to disable (default: %d)\n\n", SUBSCRIBER_CONTROL_PORT);
+    fprintf(stderr, "  -l <seconds>         : Lease of a subscription without renewal (default: %d)\n\n", SUBSCRIBER_DEFAULT_LEASE_S);
+    fprintf(stderr, "  -m <group:port[:ttl]>: Also send to a multicast group, may be repeated (default TTL: %d)\n\n", UDP_TX_MULTICAST_TTL);
     fprintf(stderr, "  -h                   : Show this help message\n\n");
 }
\ No newline at end of file
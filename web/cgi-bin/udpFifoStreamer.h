@@ -13,6 +13,10 @@
 #ifndef _UDP_FIFO_STREAMER_H_
 #define _UDP_FIFO_STREAMER_H_
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // RUSAGE_THREAD, sendmmsg
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -23,6 +27,7 @@
 #include <arpa/inet.h>
 #include <sys/socket.h>
 #include <sys/mman.h>
+#include <sys/resource.h>
 #include <fcntl.h>
 #include <time.h>
 #include <pthread.h>
@@ -30,21 +35,10 @@
 #include <semaphore.h>
 #include <stdbool.h>
 
-/**
- * @brief The transmit path of the IP core is not enabled.
- * PS is not able to transmit data to PL.
- */
-#define AXI4_STREAM_FIFO_BASE_ADDR       0x43c10000 // Base address of the AXI FIFO
-
-// refer to AXI4-Stream FIFO LogiCORE IP Product Guide (PG080) 
-// https://docs.amd.com/r/en-US/pg080-axi-fifo-mm-s/Register-Space
-#define AXI4_STREAM_FIFO_RDFR_OFFSET     0x18 // Receive data FIFO reset offset
-#define AXI4_STREAM_FIFO_RDFO_OFFSET     0x1C // Receive data FIFO occupancy offset
-#define AXI4_STREAM_FIFO_RDFD_OFFSET     0x20 // Receive data FIFO data offset
-#define AXI4_STREAM_FIFO_RLR_OFFSET      0x24 // Receive Length offset
-
-#define AXI4_STREAM_FIFO_RDFR_RESET_MASK 0x000000FF // Reset mask for receive data FIFO
-#define AXI4_STREAM_FIFO_RDFR_RESET_KEY  0x000000A5 // Reset key for receive data FIFO
+#include "axiFifo.h"
+#include "radioTuner.h"
+#include "sdrPacket.h"
+#include "sampleFormat.h"
 
 /**
  * @brief UDP default settings
@@ -53,23 +47,40 @@
 #define DEFAULT_DEST_IP         "192.168.1.3"   // Default destination IP address
 
 /**
- * @brief Data packet structure
+ * @brief Packet layout
+ * @details Packets start with the sdrPacketHeader of sdrPacket.h, or with the
+ *          legacy header (dataPacket: a bare packet ID) in compatibility mode.
+ *          The number of samples per packet (-s) and their format (-F) are
+ *          chosen at startup, so packets are PACKET_SIZE(headerSize, n, sampleBytes)
+ *          bytes.
  */
-#define NUM_SAMPLES 256 // Number of samples in the packet
+typedef enum packetHeaderMode
+{
+    PACKET_HEADER_SDR = 0,      // self-describing sdrPacketHeader (default)
+    PACKET_HEADER_LEGACY        // uint32_t packetID only, the original layout
+} packetHeaderMode;
+
+#define DEFAULT_NUM_SAMPLES 256 // Default number of samples in the packet
+#define MIN_NUM_SAMPLES     16  // Smallest packet worth sending
 typedef struct dataPacket
 {
     uint32_t packetID;                  // Packet ID
-    int32_t  sdrData[NUM_SAMPLES];      // SDR data (256 samples)
+    int32_t  sdrData[];                 // SDR data (numSamples samples)
 } dataPacket;
 
-#define PACKET_SIZE (sizeof(dataPacket)) // 1028 bytes
+#define PACKET_HEADER_SIZE(mode) ((mode) == PACKET_HEADER_LEGACY ? SDR_LEGACY_HEADER_SIZE : sizeof(sdrPacketHeader))
+#define PACKET_SIZE(headerSize, numSamples, sampleBytes) ((size_t)(headerSize) + (size_t)(numSamples) * (sampleBytes))
+#define DEFAULT_SAMPLE_FORMAT SDR_FORMAT_CS16_IQ // I then Q, what the recorder and most tools expect
+
+/**
+ * @brief Packet size limits from the link MTU
+ */
+#define UDP_IP_HEADER_SIZE  28      // IPv4 (20) + UDP (8) header bytes
+#define DEFAULT_MTU         1500    // Assumed when the route MTU cannot be read
+#define JUMBO_MTU           9000    // Largest MTU the streamers are sized for
+#define MAX_SAMPLES_FOR_MTU(mtu, headerSize, sampleBytes) (((mtu) - UDP_IP_HEADER_SIZE - (headerSize)) / (sampleBytes))
 
 /**  Function Prototype */
-volatile unsigned int * get_a_pointer(unsigned int phys_addr);
-volatile unsigned int * get_pointer_to_axi_fifo();
-void fifo_reset(volatile unsigned int *axi_fifo_base);
-unsigned int fifo_get_current_occupancy(volatile unsigned int *axi_fifo_base);
-unsigned int fifo_get_data(volatile unsigned int *axi_fifo_base);
 void usage(const char *executableName);
 
 
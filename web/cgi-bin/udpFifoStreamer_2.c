@@ -11,22 +11,78 @@
  */
 
  #include "udpFifoStreamer.h"
+ #include "fifoPacer.h"
+ #include "fifoLoss.h"
+ #include "udpTx.h"
+ #include "streamMetrics.h"
 
 /* Global Variables */
-volatile unsigned int *axi_fifo_base = NULL;    // Pointer to the AXI FIFO base address
+axiFifo fifo;                                   // AXI4-Stream FIFO receive path
+fifoDrainMode drain_mode = FIFO_DRAIN_BURST;    // How the FIFO is drained
+unsigned int axi4_data_addr = 0;                // AXI4 data interface address (0: AXI-Lite only)
+fifoPacer pacer;                                // Occupancy-driven poll pacing
+fifoLoss loss;                                  // Overflow and read-error detection
+unsigned int fifo_depth = FIFO_DEFAULT_DEPTH;   // Receive FIFO depth in words
+unsigned int fill_target = 0;                   // Fill level the reader wakes up at (0: one packet)
+unsigned int num_samples = DEFAULT_NUM_SAMPLES; // Samples per packet
+packetHeaderMode header_mode = PACKET_HEADER_SDR; // Packet header layout
+size_t header_size = sizeof(sdrPacketHeader);   // Bytes in front of the samples
+size_t packet_size = 0;                         // Bytes per packet
+sdrSampleFormat sample_format = DEFAULT_SAMPLE_FORMAT; // Sample format on the wire
+size_t raw_offset = 0;                          // Where the raw FIFO words go, relative to the payload
+volatile unsigned int *radio = NULL;            // Radio tuner registers (tuning and timer for the header)
 char *dest_ip = DEFAULT_DEST_IP;                // Destination IP address
 int dest_port = DEFAULT_UDP_DEST_PORT;          // Destination UDP port
 int timeout = 0;                                // Timeout in seconds (default: infinite)
+volatile sig_atomic_t terminate = 0;            // Termination flag
+udpTx tx;                                       // UDP transmitter
+unsigned int batch_size = UDP_TX_DEFAULT_BATCH; // Most packets per sendmmsg() call
+unsigned int flush_us = UDP_TX_DEFAULT_FLUSH_US; // Longest time a complete packet waits for its batch
+const char *metrics_name = STREAM_METRICS_NAME; // Shared-memory metrics segment (NULL: private)
+streamMetrics *metrics = NULL;                  // Counters streamerStats reads while streaming
+
+void signalHandler(int sig);
+double elapsed_us(const struct timespec *since);
+int send_batch(void * const *batch, unsigned int numPackets);
 
 int main(int argc, char const *argv[])
 {
 
     int opt = 0;
-    while ((opt = getopt(argc, (char * const *)argv, "i:p:t:h")) != -1) {
+    while ((opt = getopt(argc, (char * const *)argv, "i:p:t:s:H:F:D:A:d:L:b:f:P:h")) != -1) {
         switch (opt) {
             case 'i': dest_ip = optarg; break;
             case 'p': dest_port = atoi(optarg); break;
             case 't': timeout = atoi(optarg); break;
+            case 's': num_samples = (unsigned int)atoi(optarg); break;
+            case 'H':
+                if (strcmp(optarg, "sdr") == 0) {
+                    header_mode = PACKET_HEADER_SDR;
+                } else if (strcmp(optarg, "legacy") == 0) {
+                    header_mode = PACKET_HEADER_LEGACY;
+                } else {
+                    fprintf(stderr, "Invalid packet header: %s\n", optarg);
+                    return -1;
+                }
+                break;
+            case 'F':
+                if (sampleFormat_parse(optarg, &sample_format) != 0) {
+                    fprintf(stderr, "Invalid sample format: %s\n", optarg);
+                    return -1;
+                }
+                break;
+            case 'D':
+                if (axiFifo_parseDrainMode(optarg, &drain_mode) != 0) {
+                    fprintf(stderr, "Invalid drain mode: %s\n", optarg);
+                    return -1;
+                }
+                break;
+            case 'A': axi4_data_addr = (unsigned int)strtoul(optarg, NULL, 0); break;
+            case 'd': fifo_depth = (unsigned int)atoi(optarg); break;
+            case 'L': fill_target = (unsigned int)atoi(optarg); break;
+            case 'b': batch_size = (unsigned int)atoi(optarg); break;
+            case 'f': flush_us = (unsigned int)atoi(optarg); break;
+            case 'P': metrics_name = (strcmp(optarg, "none") == 0) ? NULL : optarg; break;
             case 'h': usage(argv[0]); return 0;
             default: usage(argv[0]); return -1;
         }
@@ -37,6 +93,29 @@ int main(int argc, char const *argv[])
         fprintf(stderr, "Invalid timeout value: %d\n", timeout);
         return -1;
     }
+    if(batch_size == 0 || batch_size > UDP_TX_MAX_BATCH) {
+        fprintf(stderr, "Invalid batch size: %u (1 to %d)\n", batch_size, UDP_TX_MAX_BATCH);
+        return -1;
+    }
+    if(fifo_depth < 16) {
+        fprintf(stderr, "Invalid FIFO depth: %u\n", fifo_depth);
+        return -1;
+    }
+    if(fill_target >= FIFO_PACER_HIGH_WATER(fifo_depth)) {
+        fprintf(stderr, "Invalid fill target: %u (must be below %u for a %u-word FIFO)\n", fill_target,
+                FIFO_PACER_HIGH_WATER(fifo_depth), fifo_depth);
+        return -1;
+    }
+    if(fill_target == 0) {
+        fill_target = num_samples; // wake up once a packet's worth of samples is waiting
+        if(fill_target >= FIFO_PACER_HIGH_WATER(fifo_depth)) {
+            fill_target = FIFO_PACER_HIGH_WATER(fifo_depth) / 2; // what fifoPacer_init() would make of it
+        }
+    }
+    if(header_mode == PACKET_HEADER_LEGACY && sdrPacket_sampleBytes(sample_format) != 4) {
+        fprintf(stderr, "-H legacy has no format field, its receivers expect 4-byte IQ samples (not -F cs8/cf32)\n");
+        return -1;
+    }
     if(dest_port < 0 || dest_port > 65535) {
         fprintf(stderr, "Invalid port value: %d\n", dest_port);
         return -1;
@@ -47,6 +126,19 @@ int main(int argc, char const *argv[])
         fprintf(stderr, "Invalid IP address: %s\n", dest_ip);
         return -1;
     }
+    // a packet must fit in one datagram on the route to the destination (jumbo frames allowed)
+    int mtu = udpTx_pathMtu(dest_ip, dest_port);
+    int usableMtu = (mtu <= 0) ? DEFAULT_MTU : (mtu > JUMBO_MTU ? JUMBO_MTU : mtu);
+    header_size = PACKET_HEADER_SIZE(header_mode);
+    unsigned int sampleBytes = sdrPacket_sampleBytes(sample_format);
+    unsigned int maxSamples = MAX_SAMPLES_FOR_MTU(usableMtu, header_size, sampleBytes);
+    if(num_samples < MIN_NUM_SAMPLES || num_samples > maxSamples) {
+        fprintf(stderr, "Invalid number of samples per packet: %u (%d to %u for a %d-byte MTU)\n",
+                num_samples, MIN_NUM_SAMPLES, maxSamples, usableMtu);
+        return -1;
+    }
+    packet_size = PACKET_SIZE(header_size, num_samples, sampleBytes);
+    raw_offset = sampleFormat_rawOffset(sample_format, num_samples);
 
     // summarize the arguments
     printf("Summary:\n");
@@ -57,151 +149,234 @@ int main(int argc, char const *argv[])
     } else {
         printf("    Timeout: infinite\n");
     }
-    printf("    Packet size: %d bytes\n", PACKET_SIZE);
-    printf("    Number of samples per packet: %d\n", NUM_SAMPLES);
+    printf("    Packet size: %zu bytes (MTU %d)\n", packet_size, mtu);
+    printf("    Number of samples per packet: %u\n", num_samples);
+    printf("    Sample format: %s (%s conversion)\n", sampleFormat_name(sample_format), sampleFormat_backend());
+    printf("    Packet header: %s (%zu bytes)\n", header_mode == PACKET_HEADER_SDR ? "sdr" : "legacy", header_size);
+    printf("    FIFO drain: %s", axiFifo_drainModeName(drain_mode));
+    if (axi4_data_addr != 0) {
+        printf(" through the AXI4 data interface at 0x%08x", axi4_data_addr);
+    }
+    printf("\n");
+    printf("    FIFO pacing: wake at %u of %u words\n", fill_target, fifo_depth);
+    printf("    Send batch: up to %u packets, flush after %u us\n", batch_size, flush_us);
+    if (metrics_name != NULL) {
+        printf("    Metrics: /dev/shm%s (streamerStats)\n", metrics_name);
+    }
 
-    // get a pointer to the AXI FIFO base address
-    axi_fifo_base = get_pointer_to_axi_fifo();
-    if (axi_fifo_base == NULL) {
+    // map the AXI FIFO (and its AXI4 data window when the bitstream has one)
+    if (axiFifo_open(&fifo, drain_mode, axi4_data_addr, NULL) != 0) {
         fprintf(stderr, "Failed to get AXI FIFO base address\n");
         return -1;
     }
 
-    fifo_reset(axi_fifo_base); // reset the FIFO
+    fifo_reset(fifo.regs); // reset the FIFO
+    fifoPacer_init(&pacer, fifo_depth, fill_target);
+    fifoLoss_init(&loss, fifo_depth, RADIO_SAMPLE_RATE);
+
+    // stop cleanly on Ctrl-C / kill so the summary gets printed
+    struct sigaction sigact;
+    memset(&sigact, 0, sizeof(sigact));
+    sigact.sa_handler = signalHandler;
+    sigaction(SIGINT, &sigact, NULL);
+    sigaction(SIGTERM, &sigact, NULL);
 
-    // create a UDP socket
-    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
-    if (sockfd < 0) {
-        perror("Error creating socket");
+    // create the UDP socket and the sendmmsg() batch
+    if (udpTx_open(&tx, dest_ip, dest_port, batch_size) != 0) {
+        axiFifo_close(&fifo);
         return -1;
     }
 
-    // create a sockaddr_in structure to hold the server address
-    struct sockaddr_in server_addr;
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(dest_port);
-    if (inet_pton(AF_INET, dest_ip, &server_addr.sin_addr) <= 0) {
-        perror("Invalid IP address or IP Address not supported");
-        close(sockfd);
-        return -1;
+    // the radio registers describe and time-stamp the samples in the packet header
+    if (header_mode == PACKET_HEADER_SDR) {
+        radio = radioTuner_open(); // without it the header carries no tuning and no timestamps
     }
 
-    dataPacket packet;
+    // packets of the current batch, 8-byte aligned for the 64-bit header fields;
+    // each also holds the raw FIFO words until they are converted in place
+    size_t packetStride = (header_size + sampleFormat_bufferBytes(sample_format, num_samples) + 7) & ~(size_t)7;
+    uint8_t *packetBuffer = calloc(batch_size, packetStride);
+    if (packetBuffer == NULL) {
+        fprintf(stderr, "Failed to allocate the packet batch\n");
+        udpTx_close(&tx);
+        axiFifo_close(&fifo);
+        radioTuner_close(radio);
+        return -1;
+    }
+    uint8_t *packets[UDP_TX_MAX_BATCH];         // the packets of the batch
+    void *batch[UDP_TX_MAX_BATCH];              // the same packets as sendmmsg() buffers
+    for (unsigned int i = 0; i < batch_size; i++) {
+        packets[i] = packetBuffer + (size_t)i * packetStride;
+        batch[i] = packets[i];
+    }
+    // counters for streamerStats, private memory if the segment cannot be created
+    metrics = streamMetrics_open(metrics_name, argv[0], fifo_depth);
+    if (metrics == NULL) {
+        udpTx_close(&tx);
+        axiFifo_close(&fifo);
+        radioTuner_close(radio);
+        free(packetBuffer);
+        return -1;
+    }
+    unsigned int numPackets = 0; // complete packets waiting in the batch
+    struct timespec batchStart;  // time the first packet of the batch was completed
     uint32_t packetID = 0; // Packet ID
     unsigned int numSamplesRead = 0; // number of samples read for current packet
-    unsigned int targetSamples = NUM_SAMPLES; // target number of samples to read for each packet
+    unsigned int targetSamples = num_samples; // target number of samples to read for each packet
+    uint32_t captureTicks = 0; // radio timer when the first sample of the packet was drained
+    bool sendFailed = false;
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
 
-    while(true)
+    while(!terminate)
     {
+        uint8_t *packet = packets[numPackets]; // next free packet of the batch
+        uint32_t *payload = (uint32_t *)(packet + header_size + raw_offset); // its raw FIFO words
         // process reading data from the FIFO to fill the packet
-        while(numSamplesRead < targetSamples) {
-            // get the current occupancy of the FIFO
-            unsigned int occupancy = fifo_get_current_occupancy(axi_fifo_base);
-            if (occupancy > 0) {
-                // read data from the FIFO
-                for (unsigned int i = 0; i < occupancy; i++) {
-                    // read data from the FIFO
-                    uint32_t temp = fifo_get_data(axi_fifo_base); 
-                    // swap bytes inside each int16
-                    packet.sdrData[numSamplesRead] = ((temp & 0x0000FFFF) << 16) | ((temp & 0xFFFF0000) >> 16); // swap bytes inside each int16
-                    ++numSamplesRead; // increment the number of samples read
-                    if (numSamplesRead >= targetSamples) {
-                        break; // exit the loop if we have read enough samples
-                    }
+        while(numSamplesRead < targetSamples && !terminate) {
+            // read whatever the FIFO holds straight into the packet
+            unsigned int numRead = axiFifo_drain(&fifo, &payload[numSamplesRead], targetSamples - numSamplesRead);
+            if (numSamplesRead == 0 && numRead > 0 && radio != NULL) {
+                captureTicks = radioTuner_getTimer(radio); // latch the capture time of the packet
+            }
+            fifoPacer_update(&pacer, fifo.lastOccupancy, numRead);
+            fifoLoss_update(&loss, &fifo, numRead, &pacer.lastPoll);
+            streamMetrics_polled(metrics, &fifo, &loss);
+            numSamplesRead += numRead; // increment the number of samples read
+            if (numSamplesRead >= targetSamples) {
+                break; // packet is full
+            }
+            // complete packets must not wait past the flush deadline while this one fills up
+            if (numPackets > 0 && elapsed_us(&batchStart) >= flush_us) {
+                if (send_batch(batch, numPackets) != 0) {
+                    sendFailed = true;
+                    break;
                 }
+                memcpy(packets[0] + header_size + raw_offset, payload, numSamplesRead * sizeof(int32_t)); // keep the partial packet
+                packet = packets[0];
+                payload = (uint32_t *)(packet + header_size + raw_offset);
+                numPackets = 0;
             }
-            usleep(1000); // sleep for 1ms to avoid busy waiting
+            fifoPacer_wait(&pacer); // sleep until the FIFO should hold fill_target words
 
         }
+        if (sendFailed) {
+            break;
+        }
 
         // check if we have read enough samples for the current packet
         if (numSamplesRead >= targetSamples) {
-            // signal that data is ready to be sent
-            packet.packetID = packetID++;
-
-            // send the packet over UDP
-            ssize_t bytes_sent = sendto(sockfd, &packet, PACKET_SIZE, 0, (struct sockaddr *)&server_addr, sizeof(server_addr));
-            if (bytes_sent < 0) {
-                perror("Error sending packet");
-                close(sockfd);
-                break; // exit the loop
+            sampleFormat_convert(sample_format, packet + header_size, payload, targetSamples); // whole packet in one go
+            bool discontinuity = fifoLoss_packetDone(&loss, fifo.wordsDrained);
+            if (header_mode == PACKET_HEADER_SDR) {
+                sdrPacket_fillHeader((sdrPacketHeader *)packet, packetID++, targetSamples, sample_format, RADIO_SAMPLE_RATE, radio, captureTicks);
+                if (discontinuity) {
+                    ((sdrPacketHeader *)packet)->flags |= SDR_FLAG_DISCONTINUITY;
+                }
+            } else {
+                ((dataPacket *)packet)->packetID = packetID++;
+            }
+            streamMetrics_set(&metrics->reader.packetsBuilt, packetID);
+            if (numPackets++ == 0) {
+                clock_gettime(CLOCK_MONOTONIC, &batchStart);
             }
 
-            if (packetID % 1000 == 0) {
-                printf("Sent %u packets to %s:%d\n", packetID, dest_ip, dest_port);
+            // send when the batch is full, or when its deadline passed; with no deadline,
+            // as soon as the FIFO does not already hold the next packet
+            bool due = (flush_us == 0) ? (pacer.residual < targetSamples) : (elapsed_us(&batchStart) >= flush_us);
+            if (numPackets == batch_size || due) {
+                if (send_batch(batch, numPackets) != 0) {
+                    sendFailed = true;
+                    break; // exit the loop
+                }
+                if (packetID / 1000 != (packetID - numPackets) / 1000) {
+                    printf("Sent %u packets to %s:%d\n", packetID, dest_ip, dest_port);
+                }
+                numPackets = 0;
             }
         }
         numSamplesRead = 0; // reset the number of samples read for the next packet
 
     }
-    // report the number of packets sent
-    printf("Total:sent %d packets to %s : %d\n", packetID, dest_ip, dest_port);
+    if (sendFailed) {
+        perror("Error sending packet");
+    } else if (numPackets > 0) {
+        send_batch(batch, numPackets); // flush the last partial batch
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
 
-    return 0;
-}
+    // report the number of packets sent
+    printf("Total:sent %llu packets to %s : %d\n", (unsigned long long)tx.packets, dest_ip, dest_port);
+    axiFifo_printStats(&fifo, seconds);
+    fifoPacer_printStats(&pacer);
+    fifoLoss_printStats(&loss, seconds);
+    udpTx_printStats(&tx, seconds);
 
-// the below code uses a device called /dev/mem to get a pointer to a physical
-// address.  We will use this pointer to read/write the custom peripheral
-volatile unsigned int * get_a_pointer(unsigned int phys_addr)
-{
+    streamMetrics_close(metrics);
+    udpTx_close(&tx);
+    axiFifo_close(&fifo);
+    radioTuner_close(radio);
+    free(packetBuffer);
 
-	int mem_fd = open("/dev/mem", O_RDWR | O_SYNC); 
-    if (mem_fd < 0) {
-        perror("Failed to open /dev/mem");
-        return NULL;
-    }
-	void *map_base = mmap(0, 4096, PROT_READ | PROT_WRITE, MAP_SHARED, mem_fd, phys_addr); 
-    if (map_base == MAP_FAILED) {
-        perror("mmap failed");
-        close(mem_fd);
-        return NULL;
-    }
-	volatile unsigned int *peripheral_base = (volatile unsigned int *)map_base; 
-    close(mem_fd); // close the file descriptor after mapping
-	return (peripheral_base);
+    return 0;
 }
 
 /**
- * @brief Get a pointer to the AXI FIFO base address in user space
- * 
- * @return volatile unsigned int* Pointer to the AXI FIFO base address
+ * @brief Stamp the send time into the batch and send it
+ *
+ * @return int 0 on success, -1 on a send error
  */
-volatile unsigned int * get_pointer_to_axi_fifo()
+int send_batch(void * const *batch, unsigned int numPackets)
 {
-    volatile unsigned int *axi_fifo_base = get_a_pointer(AXI4_STREAM_FIFO_BASE_ADDR);
-    if (axi_fifo_base == NULL) {
-        fprintf(stderr, "Failed to map AXI FIFO base address\n");
-        return NULL;
+    if (header_mode == PACKET_HEADER_SDR) {
+        sdrPacket_stampSend(batch, numPackets, radio);
     }
-    return axi_fifo_base;
-}
-
-void fifo_reset(volatile unsigned int *axi_fifo_base)
-{
-    // reset the FIFO by writing the reset key to the reset register
-    axi_fifo_base[AXI4_STREAM_FIFO_RDFR_OFFSET/4] = AXI4_STREAM_FIFO_RDFR_RESET_KEY;
+    int rc = udpTx_send(&tx, batch, numPackets, packet_size);
+    streamMetrics_sent(metrics, &tx, numPackets); // nothing queues behind the batch on one thread
+    return rc;
 }
 
-unsigned int fifo_get_current_occupancy(volatile unsigned int *axi_fifo_base)
+/**
+ * @brief Microseconds elapsed since a CLOCK_MONOTONIC time stamp
+ */
+double elapsed_us(const struct timespec *since)
 {
-    // get the current occupancy of the FIFO by reading the occupancy register
-    unsigned int occupancy = axi_fifo_base[AXI4_STREAM_FIFO_RDFO_OFFSET/4];
-    //printf("FIFO occupancy: %u\n", occupancy); // print the occupancy for debugging
-    return occupancy;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - since->tv_sec) * 1e6 + (now.tv_nsec - since->tv_nsec) / 1e3;
 }
 
-unsigned int fifo_get_data(volatile unsigned int *axi_fifo_base)
+/**
+ * @brief Ask the streaming loop to stop
+ * 
+ * @param sig signal number
+ */
+void signalHandler(int sig)
 {
-    // get the data from the FIFO by reading the data register
-    return axi_fifo_base[AXI4_STREAM_FIFO_RDFD_OFFSET/4];
+    (void)sig;
+    terminate = 1;
 }
 
 void usage(const char *executableName)
 {
-    fprintf(stderr, "Usage: %s -i <IP address> -p <port> -t <timeout_second>\n\n", executableName);
+    fprintf(stderr, "Usage: %s -i <IP address> -p <port> -t <timeout_second> -s <samples> -H <header> -F <format> -D <mode> -A <address> -d <words> -L <words> -b <packets> -f <microseconds> -P <name>\n\n", executableName);
     fprintf(stderr, "  -i <IP address>      : Destination IP address (default: %s)\n\n", DEFAULT_DEST_IP);
     fprintf(stderr, "  -p <port>            : Destination UDP port (default: %d)\n\n", DEFAULT_UDP_DEST_PORT);
     fprintf(stderr, "  -t <timeout_second>  : Timeout in seconds (default: infinite)\n\n");
+    fprintf(stderr, "  -s <samples>         : Samples per packet, up to the route MTU (default: %d)\n\n", DEFAULT_NUM_SAMPLES);
+    fprintf(stderr, "  -H <header>          : Packet header: sdr (self-describing, time-stamped) or legacy (packet ID only)\n");
+    fprintf(stderr, "                         (default: sdr)\n\n");
+    fprintf(stderr, "  -F <format>          : Sample format: cs16_iq, cs16_qi, cs16_iq_be, cs16_qi_be, cs8 or cf32 (default: cs16_iq)\n\n");
+    fprintf(stderr, "  -D <mode>            : FIFO drain mode: word, burst or rlr (default: burst)\n\n");
+    fprintf(stderr, "  -A <address>         : Physical address of the FIFO AXI4 data interface, if the bitstream has one\n\n");
+    fprintf(stderr, "  -d <words>           : Receive FIFO depth in words (default: %d)\n\n", FIFO_DEFAULT_DEPTH);
+    fprintf(stderr, "  -L <words>           : FIFO fill level to wake up at, below 3/4 of -d (default: samples per packet)\n\n");
+    fprintf(stderr, "  -b <packets>         : Most packets sent per sendmmsg() call (default: %d)\n\n", UDP_TX_DEFAULT_BATCH);
+    fprintf(stderr, "  -f <microseconds>    : Longest time a complete packet waits for its batch (default: %d, send\n", UDP_TX_DEFAULT_FLUSH_US);
+    fprintf(stderr, "                         as soon as the FIFO does not already hold the next packet)\n\n");
+    fprintf(stderr, "  -P <name>            : Shared-memory segment of the metrics read by streamerStats; none to disable\n");
+    fprintf(stderr, "                         (default: %s)\n\n", STREAM_METRICS_NAME);
     fprintf(stderr, "  -h                   : Show this help message\n\n");
 }
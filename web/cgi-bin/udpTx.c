@@ -0,0 +1,739 @@
+/**
+ * @file udpTx.c
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief UDP transmit path shared by the FIFO streamers
+ * @details See udpTx.h.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // sendmmsg
+#endif
+
+/* Include */
+#include "udpTx.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <netinet/udp.h>
+#include <linux/errqueue.h>
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103 // linux/udp.h, missing from older C libraries
+#endif
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef IP_MTU
+#define IP_MTU 14 // linux/in.h
+#endif
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+
+/**
+ * @brief Create the UDP socket and the batch buffers
+ *
+ * @param tx transmitter
+ * @param ip destination IP address (NULL: none yet, see udpTx_setDestinations())
+ * @param port destination UDP port
+ * @param batchMax most packets per sendmmsg() call
+ * @return int 0 on success, -1 on failure
+ */
+int udpTx_open(udpTx *tx, const char *ip, int port, unsigned int batchMax)
+{
+    memset(tx, 0, sizeof(*tx));
+    tx->batchMax = batchMax;
+
+    // create a UDP socket
+    tx->sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (tx->sockfd < 0) {
+        perror("Error creating socket");
+        return -1;
+    }
+
+    // create a sockaddr_in structure to hold the server address
+    if (ip != NULL) {
+        tx->dests[0].sin_family = AF_INET;
+        tx->dests[0].sin_port = htons(port);
+        if (inet_pton(AF_INET, ip, &tx->dests[0].sin_addr) <= 0) {
+            perror("Invalid IP address or IP Address not supported");
+            udpTx_close(tx);
+            return -1;
+        }
+        tx->numDests = 1;
+    }
+
+    tx->msgs = calloc(batchMax, sizeof(struct mmsghdr));
+    tx->iovs = calloc(batchMax, sizeof(struct iovec));
+    if (tx->msgs == NULL || tx->iovs == NULL) {
+        fprintf(stderr, "Failed to allocate the send batch\n");
+        udpTx_close(tx);
+        return -1;
+    }
+    // every message carries one packet, the destination is filled in per send
+    for (unsigned int i = 0; i < batchMax; i++) {
+        tx->msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+        tx->msgs[i].msg_hdr.msg_iov = &tx->iovs[i];
+        tx->msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief MTU of the route to a destination
+ * @details Connects a throw-away UDP socket so the kernel picks the route, then
+ *          reads the path MTU of that route (the outgoing interface MTU unless
+ *          a smaller one has been learnt). Nothing is sent.
+ *
+ * @param ip destination IP address
+ * @param port destination UDP port
+ * @return int MTU in bytes, -1 if it cannot be determined
+ */
+int udpTx_pathMtu(const char *ip, int port)
+{
+    struct sockaddr_in dest;
+    memset(&dest, 0, sizeof(dest));
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(port);
+    if (inet_pton(AF_INET, ip, &dest.sin_addr) <= 0) {
+        return -1;
+    }
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sockfd < 0) {
+        return -1;
+    }
+    int mtu = -1;
+    socklen_t len = sizeof(mtu);
+    if (connect(sockfd, (struct sockaddr *)&dest, sizeof(dest)) != 0
+        || getsockopt(sockfd, IPPROTO_IP, IP_MTU, &mtu, &len) != 0) {
+        mtu = -1;
+    }
+    close(sockfd);
+    return mtu;
+}
+
+/**
+ * @brief Close the socket and free the batch buffers
+ */
+void udpTx_close(udpTx *tx)
+{
+    // give the kernel a moment to finish the last zero-copy sends, then hand everything back
+    for (int waited = 0; tx->inFlightCount > 0 && waited < UDP_TX_ZC_TIMEOUT_MS; waited += UDP_TX_ZC_WAIT_MS) {
+        udpTx_reap(tx, UDP_TX_ZC_WAIT_MS);
+    }
+    while (tx->inFlightCount > 0) {
+        if (tx->inFlight[tx->inFlightHead].buffer != NULL) {
+            tx->release(tx->inFlight[tx->inFlightHead].buffer, tx->releaseArg);
+        }
+        tx->inFlightHead = (tx->inFlightHead + 1) % tx->inFlightMax;
+        tx->inFlightCount--;
+    }
+    tx->inFlightBuffers = 0;
+    free(tx->inFlight);
+    tx->inFlight = NULL;
+    tx->zerocopy = 0;
+
+    if (tx->sockfd >= 0) {
+        close(tx->sockfd);
+    }
+    tx->sockfd = -1;
+    free(tx->msgs);
+    free(tx->iovs);
+    tx->msgs = NULL;
+    tx->iovs = NULL;
+}
+
+/**
+ * @brief Replace the destinations every batch is sent to
+ * @details Called between sends by the thread that sends, e.g. when the
+ *          subscriber table changed. Zero destinations is allowed, packets are
+ *          then dropped (and counted).
+ *
+ * @param tx transmitter
+ * @param dests destination addresses
+ * @param counters per-destination counters to add to (NULL, or NULL entries: not counted)
+ * @param count number of destinations, at most UDP_TX_MAX_DESTS
+ * @return int 0 on success, -1 if there are too many
+ */
+int udpTx_setDestinations(udpTx *tx, const struct sockaddr_in *dests, udpTxCounters * const *counters, unsigned int count)
+{
+    if (count > UDP_TX_MAX_DESTS) {
+        return -1;
+    }
+    for (unsigned int i = 0; i < count; i++) {
+        tx->dests[i] = dests[i];
+        tx->destCounters[i] = (counters != NULL) ? counters[i] : NULL;
+    }
+    tx->numDests = count;
+    return 0;
+}
+
+/**
+ * @brief Set how many routers multicast packets may cross
+ *
+ * @param tx transmitter
+ * @param ttl multicast TTL (1: local subnet only)
+ * @return int 0 on success, -1 on failure
+ */
+int udpTx_setMulticastTtl(udpTx *tx, int ttl)
+{
+    unsigned char value = (unsigned char)ttl;
+    if (setsockopt(tx->sockfd, IPPROTO_IP, IP_MULTICAST_TTL, &value, sizeof(value)) != 0) {
+        perror("Failed to set the multicast TTL");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Set the GSO segment size on the socket
+ */
+static int set_gso_size(udpTx *tx, size_t packetSize)
+{
+    int size = (int)packetSize;
+    if (setsockopt(tx->sockfd, SOL_UDP, UDP_SEGMENT, &size, sizeof(size)) != 0) {
+        return -1;
+    }
+    tx->gsoSize = packetSize;
+    return 0;
+}
+
+/**
+ * @brief Turn GSO off after the kernel refused it
+ */
+static void disable_gso(udpTx *tx, const char *reason)
+{
+    int off = 0;
+    setsockopt(tx->sockfd, SOL_UDP, UDP_SEGMENT, &off, sizeof(off));
+    tx->gso = 0;
+    tx->gsoSize = 0;
+    fprintf(stderr, "UDP GSO not available (%s), falling back to sendmmsg()\n", reason);
+}
+
+/**
+ * @brief Send batches as GSO super-packets
+ * @details Probes the kernel with the UDP_SEGMENT socket option (Linux 4.18+).
+ *
+ * @param tx transmitter
+ * @param packetSize size of one datagram on the wire
+ * @return int 0 if GSO is on, -1 if the kernel does not support it
+ */
+int udpTx_enableGso(udpTx *tx, size_t packetSize)
+{
+    if (set_gso_size(tx, packetSize) != 0) {
+        disable_gso(tx, strerror(errno));
+        return -1;
+    }
+    tx->gso = 1;
+    return 0;
+}
+
+/**
+ * @brief Send n packets as one GSO super-packet
+ * @details The packets are passed as an iovec array; the kernel gathers them
+ *          into one buffer and cuts it back into packetSize datagrams. With
+ *          MSG_ZEROCOPY the whole super-packet shares one completion id.
+ *
+ * @return int 0 on success, -1 on error (errno is set)
+ */
+static int send_gso(udpTx *tx, unsigned int d, void * const *packets, unsigned int n, size_t packetSize, int flags)
+{
+    if (tx->gsoSize != packetSize && set_gso_size(tx, packetSize) != 0) {
+        return -1;
+    }
+    for (unsigned int i = 0; i < n; i++) {
+        tx->iovs[i].iov_base = packets[i];
+        tx->iovs[i].iov_len = packetSize;
+    }
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &tx->dests[d];
+    msg.msg_namelen = sizeof(tx->dests[d]);
+    msg.msg_iov = tx->iovs;
+    msg.msg_iovlen = n;
+
+    ssize_t sent;
+    do {
+        sent = sendmsg(tx->sockfd, &msg, flags);
+        tx->syscalls++;
+    } while (sent < 0 && errno == EINTR);
+    if (sent < 0) {
+        return -1;
+    }
+    tx->gsoSends++;
+    tx->packets += n;
+    tx->bytes += (uint64_t)n * packetSize;
+    return 0;
+}
+
+/**
+ * @brief Bytes in n packets, of their own sizes or all packetSize
+ */
+static uint64_t batch_bytes(const size_t *sizes, unsigned int n, size_t packetSize)
+{
+    if (sizes == NULL) {
+        return (uint64_t)n * packetSize;
+    }
+    uint64_t bytes = 0;
+    for (unsigned int i = 0; i < n; i++) {
+        bytes += sizes[i];
+    }
+    return bytes;
+}
+
+/**
+ * @brief Largest of n packets, of their own sizes or all packetSize
+ */
+static size_t batch_max(const size_t *sizes, unsigned int n, size_t packetSize)
+{
+    if (sizes == NULL) {
+        return packetSize;
+    }
+    size_t largest = 0;
+    for (unsigned int i = 0; i < n; i++) {
+        if (sizes[i] > largest) {
+            largest = sizes[i];
+        }
+    }
+    return largest;
+}
+
+/**
+ * @brief Hand back the zero-copy buffers at the head of the in-flight list whose send completed
+ */
+static void zc_release_done(udpTx *tx)
+{
+    while (tx->inFlightCount > 0 && tx->inFlight[tx->inFlightHead].done) {
+        if (tx->inFlight[tx->inFlightHead].buffer != NULL) {
+            tx->release(tx->inFlight[tx->inFlightHead].buffer, tx->releaseArg);
+            tx->inFlightBuffers--;
+        }
+        tx->inFlightHead = (tx->inFlightHead + 1) % tx->inFlightMax;
+        tx->inFlightCount--;
+    }
+}
+
+/**
+ * @brief Mark the buffers of completion ids lo..hi as done
+ * @details Ids are handed out in send order, so the matching entries are at
+ *          the front of the in-flight list.
+ */
+static void zc_complete(udpTx *tx, uint32_t lo, uint32_t hi, int copied)
+{
+    for (unsigned int i = 0; i < tx->inFlightCount; i++) {
+        udpTxInFlight *entry = &tx->inFlight[(tx->inFlightHead + i) % tx->inFlightMax];
+        if ((int32_t)(entry->id - hi) > 0) {
+            break; // sent after this completion range
+        }
+        if ((int32_t)(entry->id - lo) >= 0 && !entry->done) {
+            entry->done = 1;
+            if (copied) {
+                tx->zcCopiedBytes += entry->bytes;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Stop using MSG_ZEROCOPY and hand every buffer in flight back
+ */
+static void zc_disable(udpTx *tx, const char *reason)
+{
+    fprintf(stderr, "UDP zero-copy disabled (%s), falling back to copying sends\n", reason);
+    for (unsigned int i = 0; i < tx->inFlightCount; i++) {
+        tx->inFlight[(tx->inFlightHead + i) % tx->inFlightMax].done = 1;
+    }
+    zc_release_done(tx);
+    tx->zerocopy = 0;
+}
+
+/**
+ * @brief Wait until n more entries, holding `buffers` more buffers, may be put in flight
+ */
+static void zc_make_room(udpTx *tx, unsigned int n, unsigned int buffers)
+{
+    if (tx->inFlightCount + n <= tx->inFlightMax && tx->inFlightBuffers + buffers <= tx->inFlightBufferMax) {
+        return;
+    }
+    tx->zcStalls++;
+    int waited = 0;
+    while (tx->zerocopy && (tx->inFlightCount + n > tx->inFlightMax
+                            || tx->inFlightBuffers + buffers > tx->inFlightBufferMax)) {
+        udpTx_reap(tx, UDP_TX_ZC_WAIT_MS);
+        waited += UDP_TX_ZC_WAIT_MS;
+        if (tx->zcNotifications == 0 && waited >= UDP_TX_ZC_TIMEOUT_MS) {
+            zc_disable(tx, "no completions from the kernel"); // e.g. a kernel without UDP MSG_ZEROCOPY
+        }
+    }
+}
+
+/**
+ * @brief Remember sent buffers until their completion arrives
+ *
+ * @param sizes bytes of every packet, NULL: all are packetSize
+ * @param perBuffer 1: every buffer was its own send, 0: all of them were one send
+ * @param owner 1: this was the last send of the buffers, hand them back on completion
+ */
+static void zc_track(udpTx *tx, void * const *packets, unsigned int n, size_t packetSize, const size_t *sizes,
+                     int perBuffer, int owner)
+{
+    for (unsigned int i = 0; i < n; i++) {
+        udpTxInFlight *entry = &tx->inFlight[(tx->inFlightHead + tx->inFlightCount) % tx->inFlightMax];
+        entry->buffer = owner ? packets[i] : NULL;
+        entry->id = tx->zcNextId;
+        entry->bytes = (uint32_t)(sizes != NULL ? sizes[i] : packetSize);
+        entry->done = 0;
+        tx->inFlightCount++;
+        tx->inFlightBuffers += owner ? 1 : 0;
+        if (perBuffer) {
+            tx->zcNextId++;
+        }
+    }
+    if (!perBuffer) {
+        tx->zcNextId++;
+    }
+    tx->zcBytes += batch_bytes(sizes, n, packetSize);
+}
+
+/**
+ * @brief Send from the packet buffers with MSG_ZEROCOPY
+ * @details From now on udpTx_send() keeps every buffer it is given (also on
+ *          error) and hands it back through release() once the kernel is done
+ *          with it. Needs Linux 5.0 or later for UDP.
+ *
+ * @param tx transmitter
+ * @param maxInFlight most buffers waiting for a completion (at least batchMax)
+ * @param release returns a buffer to its owner
+ * @param arg argument for release
+ * @return int 0 if zero-copy is on, -1 if it is not available
+ */
+int udpTx_enableZerocopy(udpTx *tx, unsigned int maxInFlight, udpTxRelease release, void *arg)
+{
+    if (maxInFlight < tx->batchMax) {
+        fprintf(stderr, "UDP zero-copy needs room for at least %u buffers in flight, has %u\n", tx->batchMax, maxInFlight);
+        return -1;
+    }
+    int on = 1;
+    if (setsockopt(tx->sockfd, SOL_SOCKET, SO_ZEROCOPY, &on, sizeof(on)) != 0) {
+        fprintf(stderr, "UDP zero-copy not available (%s), falling back to copying sends\n", strerror(errno));
+        return -1;
+    }
+    // one entry per send: a buffer fanned out to every destination takes UDP_TX_MAX_DESTS
+    tx->inFlight = calloc((size_t)maxInFlight * UDP_TX_MAX_DESTS, sizeof(udpTxInFlight));
+    if (tx->inFlight == NULL) {
+        fprintf(stderr, "Failed to allocate the zero-copy in-flight list\n");
+        return -1;
+    }
+    tx->inFlightMax = maxInFlight * UDP_TX_MAX_DESTS;
+    tx->inFlightBufferMax = maxInFlight;
+    tx->release = release;
+    tx->releaseArg = arg;
+    tx->zerocopy = 1;
+    return 0;
+}
+
+/**
+ * @brief Collect zero-copy completions and hand the finished buffers back
+ * @details Completions arrive on the socket error queue as ranges of send ids.
+ *
+ * @param tx transmitter
+ * @param timeoutMs longest wait for a completion (0: only what is pending)
+ */
+void udpTx_reap(udpTx *tx, int timeoutMs)
+{
+    if (tx->inFlightCount == 0) {
+        return;
+    }
+    if (timeoutMs > 0) {
+        struct pollfd pfd = { .fd = tx->sockfd, .events = 0 }; // POLLERR is always reported
+        poll(&pfd, 1, timeoutMs);
+    }
+
+    char control[128];
+    for (;;) {
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (recvmsg(tx->sockfd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            break; // EAGAIN: nothing pending
+        }
+        tx->zcNotifications++;
+        for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm != NULL; cm = CMSG_NXTHDR(&msg, cm)) {
+            if (cm->cmsg_level != SOL_IP || cm->cmsg_type != IP_RECVERR) {
+                continue;
+            }
+            struct sock_extended_err *serr = (struct sock_extended_err *)CMSG_DATA(cm);
+            if (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY || serr->ee_errno != 0) {
+                continue;
+            }
+            zc_complete(tx, serr->ee_info, serr->ee_data, serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED);
+        }
+    }
+    zc_release_done(tx);
+}
+
+/**
+ * @brief Hand back buffers that were never sent
+ * @details In zero-copy mode earlier destinations may still be sending them,
+ *          so they queue up behind those sends as already completed entries.
+ */
+static void release_unsent(udpTx *tx, void * const *packets, unsigned int n)
+{
+    if (tx->zerocopy) {
+        zc_make_room(tx, n, n);
+    }
+    for (unsigned int i = 0; i < n; i++) {
+        if (!tx->zerocopy) {
+            tx->release(packets[i], tx->releaseArg);
+            continue;
+        }
+        udpTxInFlight *entry = &tx->inFlight[(tx->inFlightHead + tx->inFlightCount) % tx->inFlightMax];
+        entry->buffer = packets[i];
+        entry->id = tx->zcNextId - 1; // no send of its own, keeps the ids in order
+        entry->bytes = 0;
+        entry->done = 1;
+        tx->inFlightCount++;
+        tx->inFlightBuffers++;
+    }
+    if (tx->zerocopy) {
+        zc_release_done(tx);
+    }
+}
+
+/**
+ * @brief Count a failed send syscall by its errno
+ */
+static void count_error(udpTx *tx)
+{
+    tx->errors++;
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        tx->errorsAgain++;
+    } else if (errno == ENOBUFS) {
+        tx->errorsNoBufs++;
+    }
+}
+
+/**
+ * @brief Send a batch of packets to one destination
+ * @details One sendmmsg() call (or one GSO send) per batchMax packets. A
+ *          partial send is resumed with the packets the kernel did not take.
+ *
+ * @param tx transmitter
+ * @param d destination index
+ * @param packets packet buffers
+ * @param count number of packets (may exceed batchMax)
+ * @param packetSize bytes per packet
+ * @param sizes bytes of every packet, NULL: all are packetSize (GSO needs equal sizes)
+ * @param owner 1: the buffers are ours and this is their last send, hand them back afterwards
+ * @return int 0 on success, -1 on a send error (errno is set)
+ */
+static int send_dest(udpTx *tx, unsigned int d, void * const *packets, unsigned int count, size_t packetSize,
+                     const size_t *sizes, int owner)
+{
+    unsigned int done = 0;
+    while (done < count) {
+        unsigned int n = count - done;
+        if (n > tx->batchMax) {
+            n = tx->batchMax;
+        }
+
+        if (tx->gso && n > 1 && sizes == NULL) {
+            unsigned int gsoMax = UDP_TX_GSO_MAX_BYTES / packetSize;
+            if (gsoMax > UDP_TX_GSO_MAX_SEGMENTS) {
+                gsoMax = UDP_TX_GSO_MAX_SEGMENTS;
+            }
+            if (n > gsoMax) {
+                n = gsoMax;
+            }
+            if (tx->zerocopy) {
+                zc_make_room(tx, n, owner ? n : 0);
+            }
+            if (send_gso(tx, d, &packets[done], n, packetSize, tx->zerocopy ? MSG_ZEROCOPY : 0) == 0) {
+                if (tx->zerocopy) {
+                    zc_track(tx, &packets[done], n, packetSize, NULL, 0, owner);
+                } else if (owner) {
+                    for (unsigned int i = 0; i < n; i++) {
+                        tx->release(packets[done + i], tx->releaseArg);
+                    }
+                }
+                done += n;
+                continue;
+            }
+            if (tx->gsoSends == 0 && (errno == EIO || errno == EINVAL || errno == ENOPROTOOPT)) {
+                disable_gso(tx, strerror(errno)); // e.g. the route or device cannot segment, resend below
+            } else {
+                count_error(tx);
+                break;
+            }
+        }
+
+        // the socket's GSO size applies to every send, a longer packet would be cut into segments
+        if (tx->gsoSize != 0 && batch_max(sizes != NULL ? &sizes[done] : NULL, n, packetSize) > tx->gsoSize
+            && set_gso_size(tx, 0) != 0) {
+            count_error(tx);
+            break;
+        }
+        if (tx->zerocopy) {
+            zc_make_room(tx, n, owner ? n : 0);
+        }
+        for (unsigned int i = 0; i < n; i++) {
+            tx->iovs[i].iov_base = packets[done + i];
+            tx->iovs[i].iov_len = (sizes != NULL) ? sizes[done + i] : packetSize;
+            tx->msgs[i].msg_hdr.msg_name = &tx->dests[d];
+        }
+
+        int sent = sendmmsg(tx->sockfd, tx->msgs, n, tx->zerocopy ? MSG_ZEROCOPY : 0);
+        tx->syscalls++;
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            count_error(tx);
+            break;
+        }
+        if (tx->zerocopy) {
+            zc_track(tx, &packets[done], sent, packetSize, sizes != NULL ? &sizes[done] : NULL, 1, owner);
+        } else if (owner) {
+            for (int i = 0; i < sent; i++) {
+                tx->release(packets[done + i], tx->releaseArg);
+            }
+        }
+        tx->packets += sent;
+        tx->bytes += batch_bytes(sizes != NULL ? &sizes[done] : NULL, sent, packetSize);
+        done += sent;
+    }
+
+    int err = errno;
+    udpTxCounters *counters = tx->destCounters[d];
+    if (counters != NULL) {
+        atomic_fetch_add_explicit(&counters->packets, done, memory_order_relaxed);
+        atomic_fetch_add_explicit(&counters->bytes, batch_bytes(sizes, done, packetSize), memory_order_relaxed);
+    }
+    if (done < count) {
+        if (counters != NULL) {
+            atomic_fetch_add_explicit(&counters->errors, 1, memory_order_relaxed);
+            atomic_store_explicit(&counters->lastErrno, err, memory_order_relaxed);
+        }
+        if (owner) {
+            release_unsent(tx, &packets[done], count - done);
+        }
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Send a batch of packets to every destination
+ * @details Every destination gets its own send of the same buffers. A failed
+ *          destination does not hold up the others. In zero-copy mode the
+ *          packets are handed back through release() later, even when the
+ *          send fails, and only once the last destination is done with them.
+ *
+ * @return int 0 if at least one destination got the batch (or there is none), -1 if all failed (errno is set)
+ */
+static int send_all(udpTx *tx, void * const *packets, unsigned int count, size_t packetSize, const size_t *sizes)
+{
+    int owned = tx->zerocopy; // the buffers are ours until they are released
+    if (tx->numDests == 0) {
+        tx->noDest += count; // nobody to send to, the packets are dropped
+        for (unsigned int i = 0; owned && i < count; i++) {
+            tx->release(packets[i], tx->releaseArg);
+        }
+        return 0;
+    }
+
+    unsigned int failed = 0;
+    int err = 0;
+    for (unsigned int d = 0; d < tx->numDests; d++) {
+        if (send_dest(tx, d, packets, count, packetSize, sizes, owned && d == tx->numDests - 1) != 0) {
+            failed++;
+            err = errno;
+        }
+    }
+    if (tx->zerocopy) {
+        udpTx_reap(tx, 0); // pick up completions that are already there
+    }
+    if (failed == tx->numDests) {
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Send a batch of equal-size packets to every destination
+ *
+ * @param tx transmitter
+ * @param packets packet buffers
+ * @param count number of packets (may exceed batchMax)
+ * @param packetSize bytes per packet
+ * @return int 0 if at least one destination got the batch (or there is none), -1 if all failed (errno is set)
+ */
+int udpTx_send(udpTx *tx, void * const *packets, unsigned int count, size_t packetSize)
+{
+    return send_all(tx, packets, count, packetSize, NULL);
+}
+
+/**
+ * @brief Send a batch of packets of different sizes to every destination
+ * @details Like udpTx_send(), for variable-length (compressed) packets. The
+ *          batch goes out with sendmmsg(), GSO needs equal segments.
+ *
+ * @param tx transmitter
+ * @param packets packet buffers
+ * @param sizes bytes of every packet
+ * @param count number of packets (may exceed batchMax)
+ * @return int 0 if at least one destination got the batch (or there is none), -1 if all failed (errno is set)
+ */
+int udpTx_sendSizes(udpTx *tx, void * const *packets, const size_t *sizes, unsigned int count)
+{
+    return send_all(tx, packets, count, 0, sizes);
+}
+
+/**
+ * @brief Print the transmit counters
+ *
+ * @param tx transmitter
+ * @param elapsedSeconds time the transmitter was running
+ */
+void udpTx_printStats(const udpTx *tx, double elapsedSeconds)
+{
+    printf("UDP transmit summary (batch of up to %u%s):\n", tx->batchMax, tx->gso ? ", GSO" : "");
+    printf("    Packets sent: %llu (%llu bytes)\n", (unsigned long long)tx->packets, (unsigned long long)tx->bytes);
+    printf("    Send syscalls: %llu (%.3f per packet), errors: %llu (%llu EAGAIN, %llu ENOBUFS)\n",
+           (unsigned long long)tx->syscalls, tx->packets ? (double)tx->syscalls / tx->packets : 0.0,
+           (unsigned long long)tx->errors, (unsigned long long)tx->errorsAgain, (unsigned long long)tx->errorsNoBufs);
+    printf("    Packet rate: %.1f packets/s\n", elapsedSeconds > 0 ? tx->packets / elapsedSeconds : 0.0);
+    if (tx->noDest > 0) {
+        printf("    Dropped with no destination: %llu packets\n", (unsigned long long)tx->noDest);
+    }
+    if (tx->gsoSends > 0) {
+        printf("    GSO super-packets: %llu (%.1f datagrams each)\n", (unsigned long long)tx->gsoSends,
+               (double)tx->packets / tx->gsoSends);
+    }
+    if (tx->zcBytes > 0) {
+        uint64_t avoided = tx->zcBytes - tx->zcCopiedBytes;
+        printf("    Zero-copy: %llu bytes sent, %llu copied by the kernel anyway, %llu completion messages, %llu stalls\n",
+               (unsigned long long)tx->zcBytes, (unsigned long long)tx->zcCopiedBytes,
+               (unsigned long long)tx->zcNotifications, (unsigned long long)tx->zcStalls);
+        // every byte that was not copied saves one memory read and one write
+        printf("    Copy bandwidth saved: %.2f MB/s\n", elapsedSeconds > 0 ? 2.0 * avoided / elapsedSeconds / 1e6 : 0.0);
+    }
+}
@@ -0,0 +1,131 @@
+/**
+ * @file udpTx.h
+ * @author Yuchen Zhou (yzhou276@jh.edu)
+ * @brief UDP transmit path shared by the FIFO streamers
+ * @details Packets are handed over in batches and sent with one sendmmsg()
+ *          call per batch, so the syscall cost is shared by every packet in
+ *          the batch. In GSO mode the whole batch goes out as one UDP
+ *          "super-packet" that the kernel splits into packetSize datagrams
+ *          (UDP_SEGMENT), so the stack is traversed once per batch instead of
+ *          once per packet. The datagrams on the wire are unchanged.
+ *          In zero-copy mode (MSG_ZEROCOPY) the kernel sends straight out of
+ *          the packet buffers instead of copying them, so the transmitter owns
+ *          every buffer it was given until the kernel reports the send as
+ *          complete on the socket error queue, and only then hands it back
+ *          through the release callback.
+ *          A batch can be fanned out to several destinations (subscribers,
+ *          multicast groups): every destination gets its own send of the same
+ *          packet buffers, nothing is copied per destination in user space.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef _UDP_TX_H_
+#define _UDP_TX_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#define UDP_TX_DEFAULT_BATCH    8       // Packets per sendmmsg() call
+#define UDP_TX_MAX_BATCH        64      // Upper limit for the batch size
+#define UDP_TX_DEFAULT_FLUSH_US 0       // Wait for a full batch at most this long (0: send what is ready)
+#define UDP_TX_GSO_MAX_SEGMENTS 64      // Kernel limit on segments per GSO send (UDP_MAX_SEGMENTS)
+#define UDP_TX_GSO_MAX_BYTES    65507   // Largest UDP payload a GSO send may carry
+#define UDP_TX_ZC_WAIT_MS       1       // Completion poll interval while the in-flight limit is reached
+#define UDP_TX_ZC_TIMEOUT_MS    200     // No completion at all after this long: the kernel ignores MSG_ZEROCOPY
+#define UDP_TX_MAX_DESTS        16      // Most destinations a batch is fanned out to
+#define UDP_TX_MULTICAST_TTL    1       // Default TTL of multicast sends (stay on the local subnet)
+
+/**
+ * @brief Hands a buffer back once the kernel no longer reads it
+ */
+typedef void (*udpTxRelease)(void *buffer, void *arg);
+
+/**
+ * @brief Per-destination send counters
+ * @details Owned by whoever registered the destination, the transmitter only
+ *          adds to them. Atomic so they can be read from another thread.
+ */
+typedef struct udpTxCounters
+{
+    atomic_ullong packets;          // packets sent
+    atomic_ullong bytes;            // payload bytes sent
+    atomic_ullong errors;           // failed send syscalls
+    atomic_int lastErrno;           // errno of the last failure
+} udpTxCounters;
+
+/**
+ * @brief Buffer sent with MSG_ZEROCOPY, waiting for its completion
+ * @details With several destinations a buffer is in one entry per send; only
+ *          the entry of the last send carries the buffer (the others are NULL),
+ *          and entries are released strictly in order, so the buffer goes back
+ *          once every send of it has completed.
+ */
+typedef struct udpTxInFlight
+{
+    void *buffer;                   // packet buffer the kernel may still read (NULL: not the last send of it)
+    uint32_t id;                    // completion id of the send that carried it
+    uint32_t bytes;                 // bytes sent from the buffer
+    int done;                       // completion received
+} udpTxInFlight;
+
+/**
+ * @brief UDP transmitter
+ */
+typedef struct udpTx
+{
+    int sockfd;                     // UDP socket
+    struct sockaddr_in dests[UDP_TX_MAX_DESTS]; // destination addresses
+    udpTxCounters *destCounters[UDP_TX_MAX_DESTS]; // per-destination counters (NULL: not counted)
+    unsigned int numDests;          // destinations every packet is sent to
+    unsigned int batchMax;          // most packets sent per syscall
+    struct mmsghdr *msgs;           // one message per packet of a batch
+    struct iovec *iovs;             // one iovec per packet of a batch
+    int gso;                        // send batches as GSO super-packets
+    size_t gsoSize;                 // segment size currently set on the socket
+    int zerocopy;                   // send with MSG_ZEROCOPY
+    udpTxRelease release;           // returns buffers to their owner after completion
+    void *releaseArg;               // argument for release
+    udpTxInFlight *inFlight;        // zero-copy buffers in send order
+    unsigned int inFlightMax;       // capacity of inFlight (entries)
+    unsigned int inFlightHead;      // oldest entry of inFlight
+    unsigned int inFlightCount;     // entries in inFlight
+    unsigned int inFlightBuffers;   // distinct buffers in flight
+    unsigned int inFlightBufferMax; // most buffers in flight at once
+    uint32_t zcNextId;              // completion id of the next zero-copy send
+
+    // statistics
+    uint64_t packets;               // packets sent
+    uint64_t bytes;                 // payload bytes sent
+    uint64_t syscalls;              // send syscalls made
+    uint64_t errors;                // failed send syscalls
+    uint64_t errorsAgain;           // of those, EAGAIN (socket buffer full)
+    uint64_t errorsNoBufs;          // of those, ENOBUFS (device queue full)
+    uint64_t noDest;                // packets dropped while there was no destination
+    uint64_t gsoSends;              // GSO super-packets sent
+    uint64_t zcBytes;               // bytes sent without a copy
+    uint64_t zcCopiedBytes;         // bytes the kernel copied after all (no SG/checksum offload)
+    uint64_t zcNotifications;       // error queue messages read
+    uint64_t zcStalls;              // sends that waited for the in-flight limit
+} udpTx;
+
+/**  Function Prototype */
+int udpTx_open(udpTx *tx, const char *ip, int port, unsigned int batchMax);
+int udpTx_pathMtu(const char *ip, int port);
+void udpTx_close(udpTx *tx);
+int udpTx_setDestinations(udpTx *tx, const struct sockaddr_in *dests, udpTxCounters * const *counters, unsigned int count);
+int udpTx_setMulticastTtl(udpTx *tx, int ttl);
+int udpTx_enableGso(udpTx *tx, size_t packetSize);
+int udpTx_enableZerocopy(udpTx *tx, unsigned int maxInFlight, udpTxRelease release, void *arg);
+int udpTx_send(udpTx *tx, void * const *packets, unsigned int count, size_t packetSize);
+int udpTx_sendSizes(udpTx *tx, void * const *packets, const size_t *sizes, unsigned int count);
+void udpTx_reap(udpTx *tx, int timeoutMs);
+void udpTx_printStats(const udpTx *tx, double elapsedSeconds);
+
+#endif /* _UDP_TX_H_ */